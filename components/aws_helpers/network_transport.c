@@ -7,17 +7,30 @@
 #include "esp_tls.h"
 #include "sys/socket.h"
 #include "network_transport.h"
+#include "transport_deadline.h"
 #include "sdkconfig.h"
 
 #define TAG "network_transport"
 
-Timeouts_t timeouts = { .connectionTimeoutMs = 4000, .sendTimeoutMs = 10000, .recvTimeoutMs = 2000 };
+/* Longest esp-tls may block in one xTlsConnectStep() while the TCP
+ * connection is pending, and longest xTlsConnect() sleeps between steps
+ * (a step runs earlier if the socket becomes ready). */
+#define TLS_CONNECT_STEP_WAIT_MS    1
+#define TLS_CONNECT_POLL_MS         100
+
+Timeouts_t timeouts = { .connectionTimeoutMs = 4000, .handshakeTimeoutMs = 20000,
+                        .sendTimeoutMs = 10000, .recvTimeoutMs = 2000 };
 
 void vTlsSetConnectTimeout( uint16_t connectionTimeoutMs )
 {
     timeouts.connectionTimeoutMs = connectionTimeoutMs;
 }
 
+void vTlsSetHandshakeTimeout( uint16_t handshakeTimeoutMs )
+{
+    timeouts.handshakeTimeoutMs = handshakeTimeoutMs;
+}
+
 void vTlsSetSendTimeout( uint16_t sendTimeoutMs )
 {
     timeouts.sendTimeoutMs = sendTimeoutMs;
@@ -28,10 +41,28 @@ void vTlsSetRecvTimeout( uint16_t recvTimeoutMs )
     timeouts.recvTimeoutMs = recvTimeoutMs;
 }
 
-TlsTransportStatus_t xTlsConnect( NetworkContext_t* pxNetworkContext )
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+static void prvForgetSession( NetworkContext_t* pxNetworkContext )
 {
-    TlsTransportStatus_t xResult = TLS_TRANSPORT_CONNECT_FAILURE;
+    if( pxNetworkContext->pxClientSession != NULL )
+    {
+        esp_tls_free_client_session( pxNetworkContext->pxClientSession );
+        pxNetworkContext->pxClientSession = NULL;
+    }
+}
 
+static bool prvHandshakeFailed( esp_tls_t * pxTls )
+{
+    esp_tls_error_handle_t xErrorHandle = NULL;
+
+    return ( esp_tls_get_error_handle( pxTls, &xErrorHandle ) == ESP_OK ) &&
+           ( xErrorHandle != NULL ) &&
+           ( xErrorHandle->last_error == ESP_ERR_MBEDTLS_SSL_HANDSHAKE_FAILED );
+}
+#endif
+
+static void prvFillConfig( NetworkContext_t* pxNetworkContext, esp_tls_cfg_t * pxConfig )
+{
     esp_tls_cfg_t xEspTlsConfig = {
         .cacert_buf = (const unsigned char*) ( pxNetworkContext->pcServerRootCA ),
         .cacert_bytes = pxNetworkContext->pcServerRootCASize,
@@ -43,45 +74,167 @@ TlsTransportStatus_t xTlsConnect( NetworkContext_t* pxNetworkContext )
         .ds_data = pxNetworkContext->ds_data,
         .clientkey_buf = ( const unsigned char* )( pxNetworkContext->pcClientKey ),
         .clientkey_bytes = pxNetworkContext->pcClientKeySize,
-        .timeout_ms = timeouts.connectionTimeoutMs,
-        .non_block = false,
+        /* With non_block, esp-tls waits at most this long for the TCP
+         * connection on each step; the limits of the whole phases are
+         * connectionTimeoutMs and handshakeTimeoutMs. */
+        .timeout_ms = TLS_CONNECT_STEP_WAIT_MS,
+        .non_block = true,
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        .client_session = pxNetworkContext->pxClientSession,
+#endif
     };
 
+    *pxConfig = xEspTlsConfig;
+}
+
+/* Called with the context semaphore held once the pending connection is
+ * done, successfully or not. */
+static TlsTransportStatus_t prvFinishConnect( NetworkContext_t* pxNetworkContext, bool xConnected )
+{
+    TlsTransportStatus_t xResult = TLS_TRANSPORT_CONNECT_FAILURE;
+    esp_tls_t * pxTls = pxNetworkContext->pxConnectingTls;
+
+    pxNetworkContext->pxConnectingTls = NULL;
+
+    if( xConnected )
+    {
+        int lSockFd = -1;
+        if( esp_tls_get_conn_sockfd( pxTls, &lSockFd ) == ESP_OK )
+        {
+            int flags = fcntl( lSockFd, F_GETFL );
+
+            if( fcntl( lSockFd, F_SETFL, flags | O_NONBLOCK ) != -1 )
+            {
+                xResult = TLS_TRANSPORT_SUCCESS;
+            }
+        }
+    }
+
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    /* Keep the newest session: the server may have issued a new ticket. */
+    if( xResult == TLS_TRANSPORT_SUCCESS )
+    {
+        esp_tls_client_session_t * pxSession = esp_tls_get_client_session( pxTls );
+
+        if( pxSession != NULL )
+        {
+            prvForgetSession( pxNetworkContext );
+            pxNetworkContext->pxClientSession = pxSession;
+        }
+    }
+    else if( prvHandshakeFailed( pxTls ) )
+    {
+        /* A server that rejects a ticket falls back to a full handshake,
+         * so this is rare; do not offer the same session again. Failures
+         * before the handshake (Wi-Fi down, DNS, TCP) keep it. */
+        prvForgetSession( pxNetworkContext );
+    }
+#endif
+
+    if( xResult == TLS_TRANSPORT_SUCCESS )
+    {
+        pxNetworkContext->pxTls = pxTls;
+    }
+    else
+    {
+        esp_tls_conn_destroy( pxTls );
+    }
+
+    return xResult;
+}
+
+TlsTransportStatus_t xTlsConnectStart( NetworkContext_t* pxNetworkContext )
+{
+    TlsTransportStatus_t xResult = TLS_TRANSPORT_INTERNAL_ERROR;
+
+    if( ( pxNetworkContext == NULL ) || ( pxNetworkContext->pxConnectingTls != NULL ) )
+    {
+        return TLS_TRANSPORT_INVALID_PARAMETER;
+    }
+
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    pxNetworkContext->xSessionOffered = ( pxNetworkContext->pxClientSession != NULL );
+#else
+    pxNetworkContext->xSessionOffered = false;
+#endif
+
     if( xSemaphoreTake( pxNetworkContext->xTlsContextSemaphore, portMAX_DELAY ) == pdTRUE )
     {
-        int lConnectResult = -1;
         esp_tls_t * pxTls = esp_tls_init();
 
         if( pxTls != NULL )
         {
-            pxNetworkContext->pxTls = pxTls;
+            pxNetworkContext->pxConnectingTls = pxTls;
+            pxNetworkContext->xConnectDeadlineUs = xTransportDeadline( timeouts.connectionTimeoutMs );
+            pxNetworkContext->xConnectHandshaking = false;
+            xResult = TLS_TRANSPORT_CONNECT_IN_PROGRESS;
+        }
+        else
+        {
+            xResult = TLS_TRANSPORT_INSUFFICIENT_MEMORY;
+        }
+        ( void ) xSemaphoreGive( pxNetworkContext->xTlsContextSemaphore );
+    }
 
-            lConnectResult = esp_tls_conn_new_sync( pxNetworkContext->pcHostname,
-                strlen( pxNetworkContext->pcHostname ),
-                pxNetworkContext->xPort,
-                &xEspTlsConfig, pxTls );
+    return xResult;
+}
 
-            if( lConnectResult == 1 )
-            {
-                int lSockFd = -1;
-                if( esp_tls_get_conn_sockfd( pxNetworkContext->pxTls, &lSockFd ) == ESP_OK )
-                {
-                    int flags = fcntl( lSockFd, F_GETFL );
+TlsTransportStatus_t xTlsConnectStep( NetworkContext_t* pxNetworkContext )
+{
+    TlsTransportStatus_t xResult = TLS_TRANSPORT_INTERNAL_ERROR;
 
-                    if( fcntl( lSockFd, F_SETFL, flags | O_NONBLOCK ) != -1 )
-                    {
-                        xResult = TLS_TRANSPORT_SUCCESS;
-                    }
-                }
+    if( ( pxNetworkContext == NULL ) || ( pxNetworkContext->pxConnectingTls == NULL ) )
+    {
+        return TLS_TRANSPORT_INVALID_PARAMETER;
+    }
+
+    esp_tls_cfg_t xEspTlsConfig;
+    prvFillConfig( pxNetworkContext, &xEspTlsConfig );
+
+    if( xSemaphoreTake( pxNetworkContext->xTlsContextSemaphore, portMAX_DELAY ) == pdTRUE )
+    {
+        /* The first step resolves the host name (blocking, inside esp-tls)
+         * and starts the TCP connection; the next ones advance the
+         * handshake as far as the received data allows. */
+        int lConnectResult = esp_tls_conn_new_async( pxNetworkContext->pcHostname,
+            strlen( pxNetworkContext->pcHostname ),
+            pxNetworkContext->xPort,
+            &xEspTlsConfig, pxNetworkContext->pxConnectingTls );
+
+        if( ( lConnectResult == 0 ) && !pxNetworkContext->xConnectHandshaking )
+        {
+            esp_tls_conn_state_t xState = ESP_TLS_CONNECTING;
+
+            /* TCP is up: the handshake gets its own budget from now on,
+             * as it did when esp-tls applied the timeout per operation. */
+            ( void ) esp_tls_get_conn_state( pxNetworkContext->pxConnectingTls, &xState );
+
+            if( xState == ESP_TLS_HANDSHAKE )
+            {
+                pxNetworkContext->xConnectHandshaking = true;
+                pxNetworkContext->xConnectDeadlineUs = xTransportDeadline( timeouts.handshakeTimeoutMs );
             }
+        }
 
-            if( xResult != TLS_TRANSPORT_SUCCESS )
+        if( lConnectResult == 1 )
+        {
+            xResult = prvFinishConnect( pxNetworkContext, true );
+        }
+        else if( ( lConnectResult == 0 ) && ( xTransportTimeLeft( pxNetworkContext->xConnectDeadlineUs, NULL ) ) )
+        {
+            xResult = TLS_TRANSPORT_CONNECT_IN_PROGRESS;
+        }
+        else
+        {
+            if( ( lConnectResult == 0 ) && pxNetworkContext->xConnectHandshaking )
             {
-                esp_tls_conn_destroy( pxNetworkContext->pxTls );
-                pxNetworkContext->pxTls = NULL;
-            } else 
+                ESP_LOGE( TAG, "TLS handshake not completed after %u ms", ( unsigned ) timeouts.handshakeTimeoutMs );
+            }
+            else if( lConnectResult == 0 )
             {
+                ESP_LOGE( TAG, "Connection not established after %u ms", ( unsigned ) timeouts.connectionTimeoutMs );
             }
+            xResult = prvFinishConnect( pxNetworkContext, false );
         }
         ( void ) xSemaphoreGive( pxNetworkContext->xTlsContextSemaphore );
     }
@@ -89,6 +242,50 @@ TlsTransportStatus_t xTlsConnect( NetworkContext_t* pxNetworkContext )
     return xResult;
 }
 
+int lTlsConnectPollFd( NetworkContext_t* pxNetworkContext, bool * pxWantWrite )
+{
+    int lSockFd = -1;
+    esp_tls_conn_state_t xState = ESP_TLS_HANDSHAKE;
+
+    if( ( pxNetworkContext == NULL ) || ( pxNetworkContext->pxConnectingTls == NULL ) ||
+        ( esp_tls_get_conn_sockfd( pxNetworkContext->pxConnectingTls, &lSockFd ) != ESP_OK ) )
+    {
+        return -1;
+    }
+
+    ( void ) esp_tls_get_conn_state( pxNetworkContext->pxConnectingTls, &xState );
+    *pxWantWrite = ( xState == ESP_TLS_CONNECTING );
+    return lSockFd;
+}
+
+TlsTransportStatus_t xTlsConnect( NetworkContext_t* pxNetworkContext )
+{
+    TlsTransportStatus_t xResult = xTlsConnectStart( pxNetworkContext );
+
+    while( xResult == TLS_TRANSPORT_CONNECT_IN_PROGRESS )
+    {
+        xResult = xTlsConnectStep( pxNetworkContext );
+
+        if( xResult == TLS_TRANSPORT_CONNECT_IN_PROGRESS )
+        {
+            bool xWantWrite = false;
+            int lSockFd = lTlsConnectPollFd( pxNetworkContext, &xWantWrite );
+
+            if( lSockFd >= 0 )
+            {
+                fd_set fds;
+                struct timeval timeout = { .tv_sec = 0, .tv_usec = TLS_CONNECT_POLL_MS * 1000 };
+
+                FD_ZERO( &fds );
+                FD_SET( lSockFd, &fds );
+                ( void ) select( lSockFd + 1, xWantWrite ? NULL : &fds, xWantWrite ? &fds : NULL, NULL, &timeout );
+            }
+        }
+    }
+
+    return xResult;
+}
+
 TlsTransportStatus_t xTlsDisconnect( NetworkContext_t* pxNetworkContext )
 {
     BaseType_t xResult;
@@ -108,6 +305,9 @@ TlsTransportStatus_t xTlsDisconnect( NetworkContext_t* pxNetworkContext )
             xResult = TLS_TRANSPORT_DISCONNECT_FAILURE;
         }
 
+        /* esp_tls_conn_destroy() frees the handle even when closing fails */
+        pxNetworkContext->pxTls = NULL;
+
         ( void ) xSemaphoreGive( pxNetworkContext->xTlsContextSemaphore );
     }
     else
@@ -118,6 +318,55 @@ TlsTransportStatus_t xTlsDisconnect( NetworkContext_t* pxNetworkContext )
     return xResult;
 }
 
+/* Write uxDataLen bytes as TLS records before xDeadlineUs, shared by every
+ * write of one espTlsTransportSend() or espTlsTransportWritev() call. The
+ * socket is non-blocking: each write is tried first and select() only runs
+ * when mbedTLS cannot progress. Must be called with the context semaphore
+ * held. Returns the bytes written before the deadline, or a negative error. */
+static int32_t prvTlsWrite( NetworkContext_t* pxNetworkContext, int lSockFd,
+                            const unsigned char * pucData, size_t uxDataLen,
+                            int64_t xDeadlineUs )
+{
+    int32_t lBytesSent = 0;
+
+    do
+    {
+        ssize_t lResult = esp_tls_conn_write( pxNetworkContext->pxTls,
+                                              &( pucData[lBytesSent] ),
+                                              uxDataLen - lBytesSent );
+
+        if( lResult > 0 )
+        {
+            lBytesSent += ( int32_t ) lResult;
+        }
+        else if( ( lResult == 0 ) ||
+                 ( lResult == MBEDTLS_ERR_SSL_WANT_WRITE ) ||
+                 ( lResult == MBEDTLS_ERR_SSL_WANT_READ ) )
+        {
+            int lWaitResult = lTransportWait( lSockFd, lResult != MBEDTLS_ERR_SSL_WANT_READ, 0, xDeadlineUs );
+
+            if( lWaitResult < 0 )
+            {
+                ESP_LOGE( TAG, "Error during call to select." );
+                lBytesSent = -1;
+            }
+            else if( lWaitResult == 0 )
+            {
+                break;
+            }
+        }
+        else
+        {
+            lBytesSent = lResult;
+        }
+    }
+    while( ( lBytesSent >= 0 ) &&
+           ( lBytesSent < uxDataLen ) &&
+           xTransportTimeLeft( xDeadlineUs, NULL ) );
+
+    return lBytesSent;
+}
+
 int32_t espTlsTransportSend( NetworkContext_t* pxNetworkContext,
                              const void* pvData, size_t uxDataLen )
 {
@@ -128,72 +377,115 @@ int32_t espTlsTransportSend( NetworkContext_t* pxNetworkContext,
         ( pxNetworkContext != NULL ) &&
         ( pxNetworkContext->pxTls != NULL ) )
     {
-        TimeOut_t xTimeout;
-        vTaskSetTimeOutState( &xTimeout );
+        int64_t xDeadlineUs = xTransportDeadline( timeouts.sendTimeoutMs );
 
-        struct timeval timeout = { .tv_usec = timeouts.sendTimeoutMs * 1000, .tv_sec = 0 };
-        TickType_t xTicksToWait = pdMS_TO_TICKS( timeouts.sendTimeoutMs );
-        TickType_t start_tick = xTaskGetTickCount();
-
-        if( xSemaphoreTake( pxNetworkContext->xTlsContextSemaphore, xTicksToWait ) == pdTRUE )
+        if( xSemaphoreTake( pxNetworkContext->xTlsContextSemaphore, pdMS_TO_TICKS( timeouts.sendTimeoutMs ) ) == pdTRUE )
         {
             int lSockFd = -1;
             esp_err_t xError = esp_tls_get_conn_sockfd( pxNetworkContext->pxTls, &lSockFd );
             if( xError == ESP_OK )
             {
-                unsigned char * pucData = ( unsigned char * ) pvData;
-                lBytesSent = 0;
-                do
+                lBytesSent = prvTlsWrite( pxNetworkContext, lSockFd, ( const unsigned char * ) pvData,
+                                          uxDataLen, xDeadlineUs );
+            }
+            xSemaphoreGive(pxNetworkContext->xTlsContextSemaphore);
+        }
+    }
+
+    return lBytesSent;
+}
+
+/* Flush the staged vectors as one TLS record. Returns false if they could
+ * not all be written; *plBytesSent then holds the total written so far or
+ * the error. */
+static bool prvFlushStaged( NetworkContext_t* pxNetworkContext, int lSockFd, size_t * puxStaged,
+                            int32_t * plBytesSent, int64_t xDeadlineUs )
+{
+    if( *puxStaged == 0 )
+    {
+        return true;
+    }
+
+    int32_t lResult = prvTlsWrite( pxNetworkContext, lSockFd, pxNetworkContext->pucWritevBuffer,
+                                   *puxStaged, xDeadlineUs );
+    bool xComplete = ( lResult == ( int32_t ) *puxStaged );
+
+    *plBytesSent = ( lResult < 0 ) ? lResult : *plBytesSent + lResult;
+    *puxStaged = 0;
+    return xComplete;
+}
+
+int32_t espTlsTransportWritev( NetworkContext_t* pxNetworkContext,
+                               TransportOutVector_t* pxIoVec, size_t uxIoVecCount )
+{
+    int32_t lBytesSent = -1;
+
+    if( ( pxIoVec == NULL ) ||
+        ( uxIoVecCount == 0 ) ||
+        ( pxNetworkContext == NULL ) ||
+        ( pxNetworkContext->pxTls == NULL ) )
+    {
+        return lBytesSent;
+    }
+
+    int64_t xDeadlineUs = xTransportDeadline( timeouts.sendTimeoutMs );
+
+    if( xSemaphoreTake( pxNetworkContext->xTlsContextSemaphore, pdMS_TO_TICKS( timeouts.sendTimeoutMs ) ) == pdTRUE )
+    {
+        int lSockFd = -1;
+
+        if( esp_tls_get_conn_sockfd( pxNetworkContext->pxTls, &lSockFd ) == ESP_OK )
+        {
+            size_t uxCapacity = ( pxNetworkContext->pucWritevBuffer != NULL ) ? pxNetworkContext->uxWritevBufferSize : 0;
+            size_t uxStaged = 0;
+            bool xComplete = true;
+
+            lBytesSent = 0;
+
+            /* Small vectors (MQTT fixed header, topic, packet ID, short
+             * payloads) are copied into the staging buffer and leave as a
+             * single TLS record. A vector that does not fit in the buffer is
+             * written in place after flushing what was staged, so payloads
+             * are never copied. */
+            for( size_t i = 0; ( i < uxIoVecCount ) && xComplete; i++ )
+            {
+                const unsigned char * pucData = pxIoVec[ i ].iov_base;
+                size_t uxLen = pxIoVec[ i ].iov_len;
+
+                if( uxLen == 0 )
                 {
-                    fd_set write_fds;
-                    fd_set error_fds;
-                    int lSelectResult = -1;
+                    continue;
+                }
 
-                    FD_ZERO( &write_fds );
-                    FD_SET( lSockFd, &write_fds );
-                    FD_ZERO( &error_fds );
-                    FD_SET( lSockFd, &error_fds );
+                if( uxStaged + uxLen > uxCapacity )
+                {
+                    xComplete = prvFlushStaged( pxNetworkContext, lSockFd, &uxStaged, &lBytesSent, xDeadlineUs );
+                }
 
-                    suseconds_t elapsed_time_usec = ( xTaskGetTickCount() - start_tick ) * portTICK_PERIOD_MS * 1000;
-                    timeout.tv_usec = ( timeout.tv_usec - elapsed_time_usec >= 0 ) ? timeout.tv_usec - elapsed_time_usec : 0;
-                    lSelectResult = select( lSockFd + 1, NULL, &write_fds, &error_fds, &timeout );
+                if( !xComplete )
+                {
+                    break;
+                }
+                else if( uxLen <= uxCapacity )
+                {
+                    memcpy( &pxNetworkContext->pucWritevBuffer[ uxStaged ], pucData, uxLen );
+                    uxStaged += uxLen;
+                }
+                else
+                {
+                    int32_t lResult = prvTlsWrite( pxNetworkContext, lSockFd, pucData, uxLen, xDeadlineUs );
 
-                    if( lSelectResult < 0 )
-                    {
-                        lBytesSent = -1;
-                        ESP_LOGE( TAG, "Error during call to select." );
-                    }
-                    else if( ( lSelectResult > 0 ) && ( FD_ISSET( lSockFd, &write_fds ) != 0 ) )
-                    {
-                        ssize_t lResult = esp_tls_conn_write( pxNetworkContext->pxTls,
-                                                        &( pucData[lBytesSent] ),
-                                                     uxDataLen - lBytesSent );
-
-                        if( lResult >= 0 )
-                        {
-                            lBytesSent += ( int32_t ) lResult;
-                        }
-                        else if( ( lResult != MBEDTLS_ERR_SSL_WANT_WRITE ) &&
-                                ( lResult != MBEDTLS_ERR_SSL_WANT_READ ) )
-                        {
-                            lBytesSent = lResult;
-                        }
-                        else
-                        {
-                            /* Empty when MBEDTLS_ERR_SSL_WANT_READ || MBEDTLS_ERR_SSL_WANT_WRITE */
-                        }
-                    }
-                    else
-                    {
-                        /* Empty when lSelectResult == 0 */
-                    }
+                    xComplete = ( lResult == ( int32_t ) uxLen );
+                    lBytesSent = ( lResult < 0 ) ? lResult : lBytesSent + lResult;
                 }
-                while( ( xTaskCheckForTimeOut( &xTimeout, &xTicksToWait ) == pdFALSE ) &&
-                       ( lBytesSent < uxDataLen ) &&
-                       ( lBytesSent >= 0 ) );
             }
-            xSemaphoreGive(pxNetworkContext->xTlsContextSemaphore);
+
+            if( xComplete )
+            {
+                ( void ) prvFlushStaged( pxNetworkContext, lSockFd, &uxStaged, &lBytesSent, xDeadlineUs );
+            }
         }
+        ( void ) xSemaphoreGive( pxNetworkContext->xTlsContextSemaphore );
     }
 
     return lBytesSent;
@@ -209,33 +501,24 @@ int32_t espTlsTransportRecv( NetworkContext_t* pxNetworkContext,
         ( pxNetworkContext != NULL ) &&
         ( pxNetworkContext->pxTls != NULL ) )
     {
-        TimeOut_t xTimeout;
-        vTaskSetTimeOutState( &xTimeout );
+        int64_t xDeadlineUs = xTransportDeadline( timeouts.recvTimeoutMs );
 
-        TickType_t xTicksToWait = pdMS_TO_TICKS( timeouts.recvTimeoutMs );
-        struct timeval timeout = {.tv_usec = timeouts.recvTimeoutMs * 1000, .tv_sec = 0};
-        TickType_t start_tick = xTaskGetTickCount();
-
-        if( xSemaphoreTake( pxNetworkContext->xTlsContextSemaphore, xTicksToWait ) == pdTRUE )
+        if( xSemaphoreTake( pxNetworkContext->xTlsContextSemaphore, pdMS_TO_TICKS( timeouts.recvTimeoutMs ) ) == pdTRUE )
         {
             int lSockFd = -1;
-            fd_set read_fds;
-            fd_set error_fds;
 
             lBytesRead = 0;
 
             esp_tls_get_conn_sockfd( pxNetworkContext->pxTls, &lSockFd );
-            FD_ZERO( &read_fds );
-            FD_SET( lSockFd, &read_fds );
-            FD_ZERO( &error_fds );
-            FD_SET( lSockFd, &error_fds );
 
             do
             {
-                // Fetch any buffered data
+                /* Decrypted data buffered by mbedTLS is returned first. With a
+                 * zero timeout an empty socket ends the call here: the
+                 * deadline has passed, so lTransportWait() skips select(). */
                 ssize_t lResult = esp_tls_conn_read( pxNetworkContext->pxTls,
-                                                pvData,
-                                            ( size_t ) uxDataLen );
+                                                     pvData,
+                                                     ( size_t ) uxDataLen );
 
                 if( lResult > 0 )
                 {
@@ -244,13 +527,19 @@ int32_t espTlsTransportRecv( NetworkContext_t* pxNetworkContext,
                 else if( ( lResult == MBEDTLS_ERR_SSL_WANT_WRITE ) ||
                          ( lResult == MBEDTLS_ERR_SSL_WANT_READ ) )
                 {
-                    suseconds_t elapsed_time_usec = ( xTaskGetTickCount() - start_tick ) * portTICK_PERIOD_MS * 1000;
-                    timeout.tv_usec = ( timeout.tv_usec - elapsed_time_usec >= 0 ) ? timeout.tv_usec - elapsed_time_usec : 0;
+                    ssize_t lBuffered = esp_tls_get_bytes_avail( pxNetworkContext->pxTls );
+                    int lWaitResult = lTransportWait( lSockFd, lResult == MBEDTLS_ERR_SSL_WANT_WRITE,
+                                                      ( lBuffered > 0 ) ? ( size_t ) lBuffered : 0,
+                                                      xDeadlineUs );
 
-                    int lSelectResult = select( lSockFd + 1, &read_fds, NULL, &error_fds, &timeout );
-                    if ( ( lSelectResult < 0 ) || FD_ISSET( lSockFd, &error_fds ) ) {
+                    if( lWaitResult < 0 )
+                    {
                         ESP_LOGE( TAG, "Error reading the message" );
-                        lBytesRead = lResult = -1;
+                        lBytesRead = -1;
+                    }
+                    else if( lWaitResult == 0 )
+                    {
+                        break;
                     }
                 }
                 else if( lResult == 0 )
@@ -264,9 +553,7 @@ int32_t espTlsTransportRecv( NetworkContext_t* pxNetworkContext,
                     lBytesRead = ( int32_t ) lResult;
                 }
             }
-            while ( ( xTaskCheckForTimeOut( &xTimeout, &xTicksToWait ) == pdFALSE ) &&
-                    ( lBytesRead == 0 ) );
-
+            while( lBytesRead == 0 );
 
             ( void ) xSemaphoreGive( pxNetworkContext->xTlsContextSemaphore );
         }
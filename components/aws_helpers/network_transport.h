@@ -7,13 +7,16 @@
 #endif
 /* *INDENT-ON* */
 
+#include <stdbool.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "transport_interface.h"
 #include "esp_tls.h"
+#include "sdkconfig.h"
 
 typedef enum TlsTransportStatus
 {
+    TLS_TRANSPORT_CONNECT_IN_PROGRESS = 1,  /**< Asynchronous connection still in progress. */
     TLS_TRANSPORT_SUCCESS = 0,              /**< Function successfully completed. */
                                             /**< -1 is reserved for ESP_FAIL */
     TLS_TRANSPORT_INVALID_PARAMETER = -2,   /**< At least one parameter was invalid. */
@@ -55,6 +58,37 @@ struct NetworkContext
     * @brief Disable server name indication (SNI) for a TLS session.
     */
     BaseType_t disableSni;
+
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    /**
+    * @brief Session of the last successful connection, offered on the next
+    * xTlsConnect() for an abbreviated handshake. Owned by the transport;
+    * NULL before the first connection or after a failed handshake.
+    */
+    esp_tls_client_session_t * pxClientSession;
+#endif
+
+    /**
+    * @brief Set by xTlsConnect(): whether the attempt offered a cached session.
+    */
+    bool xSessionOffered;
+
+    /**
+    * @brief Connection being established by xTlsConnectStart() and
+    * xTlsConnectStep(); it becomes pxTls once the handshake completes.
+    */
+    esp_tls_t* pxConnectingTls;
+    int64_t xConnectDeadlineUs;      /**< @brief esp_timer time at which the current phase of the pending connection fails. */
+    bool xConnectHandshaking;        /**< @brief The pending connection reached the TLS handshake (handshakeTimeoutMs applies). */
+    /**
+    * @brief Staging buffer of espTlsTransportWritev(), provided by the
+    * application. Vectors that fit are gathered here and sent as one TLS
+    * record; size it for a typical MQTT packet and no larger than the mbedTLS
+    * output record (CONFIG_MBEDTLS_SSL_OUT_CONTENT_LEN). With NULL every
+    * vector is written on its own.
+    */
+    uint8_t * pucWritevBuffer;
+    size_t uxWritevBufferSize;
 };
 
 /**
@@ -62,30 +96,85 @@ struct NetworkContext
  * Note that it uses FreeRTOS software timer internally and hence minimum resolution is the tick duration.
  * These timeouts can be specified before any receive or send operation. Timout of 0 will act as a non-blocking mode.
  *
+ * A connection has two budgets, each a deadline for its whole phase: connectionTimeoutMs
+ * covers name resolution and the TCP connection, and handshakeTimeoutMs starts once TCP
+ * is up and covers the complete TLS handshake, including client authentication.
+ *
  * Defaults are:
  * Connection timeout - 4 seconds
+ * Handshake timeout - 20 seconds
  * Send timeout - 10 seconds
  * Receive timeout - 2 seconds
  */
 typedef struct Timeouts
 {
     uint16_t connectionTimeoutMs;
+    uint16_t handshakeTimeoutMs;
     uint16_t sendTimeoutMs;
     uint16_t recvTimeoutMs;
 } Timeouts_t;
 
+/**
+ * @brief Connect and complete the TLS handshake, blocking up to connectionTimeoutMs
+ * for DNS and TCP plus handshakeTimeoutMs for the handshake.
+ *
+ * Same as xTlsConnectStart() followed by xTlsConnectStep() until it is done.
+ * The context semaphore is only held during each step.
+ */
 TlsTransportStatus_t xTlsConnect(NetworkContext_t* pxNetworkContext );
 
+/**
+ * @brief Begin an asynchronous connection (esp-tls non-blocking connect).
+ *
+ * @return TLS_TRANSPORT_CONNECT_IN_PROGRESS, after which xTlsConnectStep()
+ * must be called until it returns something else, or an error.
+ */
+TlsTransportStatus_t xTlsConnectStart( NetworkContext_t* pxNetworkContext );
+
+/**
+ * @brief Advance the pending connection without waiting for the network.
+ *
+ * The first step resolves the host name, which esp-tls still does
+ * synchronously. Between steps the caller may wait on lTlsConnectPollFd().
+ *
+ * @return TLS_TRANSPORT_CONNECT_IN_PROGRESS while not done, TLS_TRANSPORT_SUCCESS
+ * once pxTls is connected, or an error (the pending connection is then
+ * released, also when the TCP connection is not up connectionTimeoutMs after
+ * xTlsConnectStart(), or the handshake not done handshakeTimeoutMs after that).
+ */
+TlsTransportStatus_t xTlsConnectStep( NetworkContext_t* pxNetworkContext );
+
+/**
+ * @brief Socket of the pending connection, for select() between steps.
+ *
+ * @param[out] pxWantWrite true while the TCP connection is pending (wait for
+ * writability), false during the handshake (wait for data).
+ * @return The socket, or -1 before the first step.
+ */
+int lTlsConnectPollFd( NetworkContext_t* pxNetworkContext, bool * pxWantWrite );
+
 TlsTransportStatus_t xTlsDisconnect( NetworkContext_t* pxNetworkContext );
 
 int32_t espTlsTransportSend( NetworkContext_t* pxNetworkContext,
     const void* pvData, size_t uxDataLen );
 
+/**
+ * @brief TransportWritev_t for coreMQTT: gathers the vectors of one packet
+ * into as few TLS records as possible (see pucWritevBuffer).
+ *
+ * @return Bytes written, which may be fewer than requested on timeout, or a
+ * negative error.
+ */
+int32_t espTlsTransportWritev( NetworkContext_t* pxNetworkContext,
+    TransportOutVector_t* pxIoVec, size_t uxIoVecCount );
+
 int32_t espTlsTransportRecv( NetworkContext_t* pxNetworkContext,
     void* pvData, size_t uxDataLen );
 
 void vTlsSetConnectTimeout( uint16_t connectionTimeoutMs );
 
+void vTlsSetHandshakeTimeout( uint16_t handshakeTimeoutMs );
+
 void vTlsSetSendTimeout( uint16_t sendTimeoutMs );
 
 void vTlsSetRecvTimeout( uint16_t recvTimeoutMs );
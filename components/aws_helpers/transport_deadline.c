@@ -0,0 +1,60 @@
+#include "transport_deadline.h"
+
+#include <sys/select.h>
+#include "esp_timer.h"
+
+int64_t xTransportDeadline( uint32_t ulTimeoutMs )
+{
+    return esp_timer_get_time() + ( int64_t ) ulTimeoutMs * 1000;
+}
+
+bool xTransportTimeLeft( int64_t xDeadlineUs, struct timeval * pxTimeout )
+{
+    int64_t xLeftUs = xDeadlineUs - esp_timer_get_time();
+
+    if( xLeftUs < 0 )
+    {
+        xLeftUs = 0;
+    }
+
+    if( pxTimeout != NULL )
+    {
+        /* tv_usec must stay below 1000000: lwIP and POSIX reject larger values */
+        pxTimeout->tv_sec = ( time_t ) ( xLeftUs / 1000000 );
+        pxTimeout->tv_usec = ( suseconds_t ) ( xLeftUs % 1000000 );
+    }
+
+    return xLeftUs > 0;
+}
+
+int lTransportWait( int lSockFd, bool xWrite, size_t uxBuffered, int64_t xDeadlineUs )
+{
+    struct timeval xTimeout;
+    fd_set xReadyFds;
+    fd_set xErrorFds;
+
+    if( !xWrite && ( uxBuffered > 0 ) )
+    {
+        return 1;
+    }
+
+    if( !xTransportTimeLeft( xDeadlineUs, &xTimeout ) )
+    {
+        return 0;
+    }
+
+    FD_ZERO( &xReadyFds );
+    FD_SET( lSockFd, &xReadyFds );
+    FD_ZERO( &xErrorFds );
+    FD_SET( lSockFd, &xErrorFds );
+
+    int lResult = select( lSockFd + 1, xWrite ? NULL : &xReadyFds, xWrite ? &xReadyFds : NULL,
+                          &xErrorFds, &xTimeout );
+
+    if( ( lResult < 0 ) || ( ( lResult > 0 ) && FD_ISSET( lSockFd, &xErrorFds ) ) )
+    {
+        return -1;
+    }
+
+    return ( lResult > 0 ) ? 1 : 0;
+}
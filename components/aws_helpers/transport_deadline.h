@@ -0,0 +1,57 @@
+/**
+ * @file transport_deadline.h
+ * @brief Deadline-based waits for the TLS transport, on the esp_timer clock.
+ *
+ * A send or receive call computes one absolute deadline when it starts and
+ * every wait on the socket uses what is left of it, so retries never extend
+ * the call beyond its timeout. esp_timer is monotonic and has microsecond
+ * resolution, unlike the FreeRTOS tick count.
+ */
+
+#ifndef TRANSPORT_DEADLINE_H_
+#define TRANSPORT_DEADLINE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/time.h>
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/**
+ * @brief Deadline ulTimeoutMs milliseconds from now, in esp_timer microseconds.
+ */
+int64_t xTransportDeadline( uint32_t ulTimeoutMs );
+
+/**
+ * @brief Time left until xDeadlineUs, for select().
+ *
+ * @param[out] pxTimeout Remaining time with tv_usec always below one
+ * second, or zero once the deadline has passed. May be NULL.
+ * @return false once the deadline has passed.
+ */
+bool xTransportTimeLeft( int64_t xDeadlineUs, struct timeval * pxTimeout );
+
+/**
+ * @brief Wait until lSockFd is readable (writable if xWrite) or xDeadlineUs.
+ *
+ * Returns at once, without select(), when reading and mbedTLS already holds
+ * uxBuffered bytes of decrypted data, or when the deadline has already
+ * passed (a zero timeout).
+ *
+ * @return 1 if the socket is ready or data is buffered, 0 on timeout, -1 if
+ * select() fails or reports an error condition on the socket.
+ */
+int lTransportWait( int lSockFd, bool xWrite, size_t uxBuffered, int64_t xDeadlineUs );
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* ifndef TRANSPORT_DEADLINE_H_ */
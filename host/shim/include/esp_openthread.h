@@ -0,0 +1,11 @@
+#ifndef HOST_ESP_OPENTHREAD_H
+#define HOST_ESP_OPENTHREAD_H
+
+#include "openthread/instance.h"
+
+/**
+ * @brief The single simulated OpenThread instance (see sim_openthread.h)
+ */
+otInstance *esp_openthread_get_instance(void);
+
+#endif // HOST_ESP_OPENTHREAD_H
@@ -0,0 +1,16 @@
+#ifndef HOST_ESP_OPENTHREAD_LOCK_H
+#define HOST_ESP_OPENTHREAD_LOCK_H
+
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+
+/**
+ * @brief The OpenThread API lock, a recursive mutex as on the target
+ *
+ * The simulated mainloop holds it while it dispatches CoAP requests and
+ * state changes.
+ */
+bool esp_openthread_lock_acquire(TickType_t block_ticks);
+void esp_openthread_lock_release(void);
+
+#endif // HOST_ESP_OPENTHREAD_LOCK_H
@@ -0,0 +1,17 @@
+#ifndef HOST_ESP_SYSTEM_H
+#define HOST_ESP_SYSTEM_H
+
+#include <stdint.h>
+
+/**
+ * @brief Heap figures of the simulated target
+ *
+ * The host heap says nothing about the ESP32 one, so both calls return a
+ * fixed value (sys.heap_* and the heap watermark check stay quiet).
+ */
+uint32_t esp_get_free_heap_size(void);
+uint32_t esp_get_minimum_free_heap_size(void);
+
+void esp_restart(void) __attribute__((noreturn));
+
+#endif // HOST_ESP_SYSTEM_H
@@ -0,0 +1,25 @@
+#ifndef HOST_ESP_TLS_H
+#define HOST_ESP_TLS_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include "esp_err.h"
+
+/**
+ * @brief Plain TCP connection standing in for an esp-tls session
+ *
+ * The host transport talks to a local broker without TLS, so there is never
+ * decrypted data buffered outside the socket.
+ */
+typedef struct esp_tls {
+    int sockfd;
+} esp_tls_t;
+
+esp_err_t esp_tls_get_conn_sockfd(esp_tls_t *tls, int *sockfd);
+
+/**
+ * @brief Always 0: without TLS nothing is buffered above the socket
+ */
+ssize_t esp_tls_get_bytes_avail(esp_tls_t *tls);
+
+#endif // HOST_ESP_TLS_H
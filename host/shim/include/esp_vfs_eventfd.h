@@ -0,0 +1,26 @@
+#ifndef HOST_ESP_VFS_EVENTFD_H
+#define HOST_ESP_VFS_EVENTFD_H
+
+#include <stddef.h>
+#include <sys/eventfd.h>
+#include "esp_err.h"
+
+/**
+ * @brief Linux eventfd in place of the ESP-IDF VFS one
+ *
+ * Reading an ESP-IDF eventfd never blocks (it returns the counter, possibly
+ * 0), and the pipeline relies on that to clear it before checking the
+ * rings. Linux blocks on a zero counter unless EFD_NONBLOCK is set, so it is
+ * always added.
+ */
+typedef struct {
+    size_t max_fds;
+} esp_vfs_eventfd_config_t;
+
+#define ESP_VFS_EVENTD_CONFIG_DEFAULT() { .max_fds = 5 }
+
+esp_err_t esp_vfs_eventfd_register(const esp_vfs_eventfd_config_t *config);
+
+#define eventfd(initval, flags) eventfd((initval), (flags) | EFD_NONBLOCK)
+
+#endif // HOST_ESP_VFS_EVENTFD_H
@@ -0,0 +1,59 @@
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Minimal FreeRTOS on POSIX threads
+ *
+ * Only what the pipeline uses: tasks with direct-to-task notifications,
+ * mutexes, tick count and critical sections. One tick is one millisecond.
+ * Core affinity and static buffers are accepted and ignored: every task is a
+ * detached pthread.
+ */
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint8_t StackType_t;
+
+typedef struct host_task *TaskHandle_t;
+typedef struct host_semaphore *SemaphoreHandle_t;
+
+typedef struct {
+    uint8_t unused;
+} StaticTask_t;
+
+typedef struct host_semaphore {
+    pthread_mutex_t mutex;
+} StaticSemaphore_t;
+
+typedef struct {
+    TickType_t start;
+} TimeOut_t;
+
+#define pdTRUE                  1
+#define pdFALSE                 0
+#define pdPASS                  pdTRUE
+#define pdFAIL                  pdFALSE
+#define portMAX_DELAY           ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ      1000
+#define portTICK_PERIOD_MS      (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define portNUM_PROCESSORS      2
+#define tskNO_AFFINITY          ((BaseType_t)0x7FFFFFFF)
+
+// Secciones críticas: un mutex por portMUX
+typedef struct {
+    pthread_mutex_t mutex;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { PTHREAD_MUTEX_INITIALIZER }
+#define portENTER_CRITICAL(mux)     pthread_mutex_lock(&(mux)->mutex)
+#define portEXIT_CRITICAL(mux)      pthread_mutex_unlock(&(mux)->mutex)
+
+BaseType_t xPortGetCoreID(void);
+
+#endif // HOST_FREERTOS_H
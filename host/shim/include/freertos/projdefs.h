@@ -0,0 +1,6 @@
+#ifndef HOST_PROJDEFS_H
+#define HOST_PROJDEFS_H
+
+#include "freertos/FreeRTOS.h"
+
+#endif // HOST_PROJDEFS_H
@@ -0,0 +1,88 @@
+#ifndef HOST_NETWORK_TRANSPORT_H
+#define HOST_NETWORK_TRANSPORT_H
+
+/**
+ * Host replacement for components/aws_helpers/network_transport.h: same
+ * context and functions, over plain TCP to a local MQTT broker. The endpoint
+ * configured in aws_task.c is ignored; the broker address comes from the
+ * SIM_BROKER_HOST and SIM_BROKER_PORT environment variables (127.0.0.1:1883
+ * by default). Certificates are accepted and unused.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "transport_interface.h"
+#include "esp_tls.h"
+
+typedef enum TlsTransportStatus
+{
+    TLS_TRANSPORT_CONNECT_IN_PROGRESS = 1,
+    TLS_TRANSPORT_SUCCESS = 0,
+    TLS_TRANSPORT_INVALID_PARAMETER = -2,
+    TLS_TRANSPORT_INSUFFICIENT_MEMORY = -3,
+    TLS_TRANSPORT_INVALID_CREDENTIALS = -4,
+    TLS_TRANSPORT_HANDSHAKE_FAILED = -5,
+    TLS_TRANSPORT_INTERNAL_ERROR = -6,
+    TLS_TRANSPORT_CONNECT_FAILURE = -7,
+    TLS_TRANSPORT_DISCONNECT_FAILURE = -8
+} TlsTransportStatus_t;
+
+struct NetworkContext
+{
+    SemaphoreHandle_t xTlsContextSemaphore;
+    esp_tls_t* pxTls;
+    const char *pcHostname;
+    int xPort;
+    const char *pcServerRootCA;
+    uint32_t pcServerRootCASize;
+    const char *pcClientCert;
+    uint32_t pcClientCertSize;
+    const char *pcClientKey;
+    uint32_t pcClientKeySize;
+    bool use_secure_element;
+    void *ds_data;
+    const char ** pAlpnProtos;
+    BaseType_t disableSni;
+    bool xSessionOffered;            /* always false: no TLS, no sessions */
+    esp_tls_t* pxConnectingTls;      /* pending non-blocking connect() */
+    int64_t xConnectDeadlineUs;
+    uint8_t * pucWritevBuffer;       /* unused: sendmsg() gathers the vectors */
+    size_t uxWritevBufferSize;
+};
+
+typedef struct Timeouts
+{
+    uint16_t connectionTimeoutMs;
+    uint16_t handshakeTimeoutMs;     /* unused: no TLS handshake */
+    uint16_t sendTimeoutMs;
+    uint16_t recvTimeoutMs;
+} Timeouts_t;
+
+TlsTransportStatus_t xTlsConnect( NetworkContext_t* pxNetworkContext );
+
+TlsTransportStatus_t xTlsConnectStart( NetworkContext_t* pxNetworkContext );
+
+TlsTransportStatus_t xTlsConnectStep( NetworkContext_t* pxNetworkContext );
+
+int lTlsConnectPollFd( NetworkContext_t* pxNetworkContext, bool * pxWantWrite );
+
+TlsTransportStatus_t xTlsDisconnect( NetworkContext_t* pxNetworkContext );
+
+int32_t espTlsTransportSend( NetworkContext_t* pxNetworkContext,
+    const void* pvData, size_t uxDataLen );
+
+int32_t espTlsTransportWritev( NetworkContext_t* pxNetworkContext,
+    TransportOutVector_t* pxIoVec, size_t uxIoVecCount );
+
+int32_t espTlsTransportRecv( NetworkContext_t* pxNetworkContext,
+    void* pvData, size_t uxDataLen );
+
+void vTlsSetConnectTimeout( uint16_t connectionTimeoutMs );
+
+void vTlsSetHandshakeTimeout( uint16_t handshakeTimeoutMs );
+
+void vTlsSetSendTimeout( uint16_t sendTimeoutMs );
+
+void vTlsSetRecvTimeout( uint16_t recvTimeoutMs );
+
+#endif /* HOST_NETWORK_TRANSPORT_H */
@@ -0,0 +1,96 @@
+#ifndef HOST_OPENTHREAD_COAP_H
+#define HOST_OPENTHREAD_COAP_H
+
+#include "openthread/message.h"
+
+/**
+ * @brief The subset of the OpenThread CoAP API used by thread_coap_task.c
+ *
+ * Messages are not encoded on the wire: the simulated stack keeps type,
+ * code, token and options as fields and the payload in the message buffer,
+ * starting at offset 0.
+ */
+#define OT_DEFAULT_COAP_PORT        5683
+#define OT_COAP_MAX_TOKEN_LENGTH    8
+
+typedef enum {
+    OT_COAP_TYPE_CONFIRMABLE = 0,
+    OT_COAP_TYPE_NON_CONFIRMABLE = 1,
+    OT_COAP_TYPE_ACKNOWLEDGMENT = 2,
+    OT_COAP_TYPE_RESET = 3,
+} otCoapType;
+
+#define OT_COAP_CODE(c, d) ((((c) & 0x7) << 5) | ((d) & 0x1f))
+
+typedef enum {
+    OT_COAP_CODE_EMPTY = OT_COAP_CODE(0, 0),
+    OT_COAP_CODE_GET = OT_COAP_CODE(0, 1),
+    OT_COAP_CODE_POST = OT_COAP_CODE(0, 2),
+    OT_COAP_CODE_PUT = OT_COAP_CODE(0, 3),
+    OT_COAP_CODE_DELETE = OT_COAP_CODE(0, 4),
+    OT_COAP_CODE_CHANGED = OT_COAP_CODE(2, 4),
+    OT_COAP_CODE_CONTENT = OT_COAP_CODE(2, 5),
+    OT_COAP_CODE_BAD_REQUEST = OT_COAP_CODE(4, 0),
+    OT_COAP_CODE_NOT_FOUND = OT_COAP_CODE(4, 4),
+    OT_COAP_CODE_REQUEST_TOO_LARGE = OT_COAP_CODE(4, 13),
+    OT_COAP_CODE_INTERNAL_ERROR = OT_COAP_CODE(5, 0),
+    OT_COAP_CODE_SERVICE_UNAVAILABLE = OT_COAP_CODE(5, 3),
+} otCoapCode;
+
+typedef enum {
+    OT_COAP_OPTION_OBSERVE = 6,
+    OT_COAP_OPTION_URI_PATH = 11,
+    OT_COAP_OPTION_CONTENT_FORMAT = 12,
+} otCoapOptionType;
+
+typedef enum {
+    OT_COAP_OPTION_CONTENT_FORMAT_OCTET_STREAM = 42,
+    OT_COAP_OPTION_CONTENT_FORMAT_CBOR = 60,
+} otCoapOptionContentFormat;
+
+typedef struct {
+    uint16_t mNumber;
+    uint16_t mLength;
+} otCoapOption;
+
+typedef struct {
+    const otMessage *mMessage;
+    otCoapOption mOption;
+    uint16_t mNextOptionOffset;
+} otCoapOptionIterator;
+
+typedef void (*otCoapRequestHandler)(void *aContext, otMessage *aMessage, const otMessageInfo *aMessageInfo);
+
+typedef struct otCoapResource {
+    const char *mUriPath;
+    otCoapRequestHandler mHandler;
+    void *mContext;
+    struct otCoapResource *mNext;
+} otCoapResource;
+
+otError otCoapStart(otInstance *aInstance, uint16_t aPort);
+otError otCoapStop(otInstance *aInstance);
+void otCoapAddResource(otInstance *aInstance, otCoapResource *aResource);
+void otCoapRemoveResource(otInstance *aInstance, otCoapResource *aResource);
+
+otMessage *otCoapNewMessage(otInstance *aInstance, const otMessageSettings *aSettings);
+void otCoapMessageInit(otMessage *aMessage, otCoapType aType, otCoapCode aCode);
+otError otCoapMessageInitResponse(otMessage *aResponse, const otMessage *aRequest, otCoapType aType,
+                                  otCoapCode aCode);
+otError otCoapMessageSetToken(otMessage *aMessage, const uint8_t *aToken, uint8_t aTokenLength);
+otError otCoapMessageSetPayloadMarker(otMessage *aMessage);
+otError otCoapMessageAppendObserveOption(otMessage *aMessage, uint32_t aObserve);
+otError otCoapMessageAppendContentFormatOption(otMessage *aMessage, otCoapOptionContentFormat aContentFormat);
+
+otCoapType otCoapMessageGetType(const otMessage *aMessage);
+otCoapCode otCoapMessageGetCode(const otMessage *aMessage);
+const uint8_t *otCoapMessageGetToken(const otMessage *aMessage);
+uint8_t otCoapMessageGetTokenLength(const otMessage *aMessage);
+
+otError otCoapOptionIteratorInit(otCoapOptionIterator *aIterator, const otMessage *aMessage);
+const otCoapOption *otCoapOptionIteratorGetFirstOptionMatching(otCoapOptionIterator *aIterator, uint16_t aOption);
+otError otCoapOptionIteratorGetOptionUintValue(otCoapOptionIterator *aIterator, uint64_t *aValue);
+
+otError otCoapSendResponse(otInstance *aInstance, otMessage *aMessage, const otMessageInfo *aMessageInfo);
+
+#endif // HOST_OPENTHREAD_COAP_H
@@ -0,0 +1,15 @@
+#ifndef HOST_OPENTHREAD_ERROR_H
+#define HOST_OPENTHREAD_ERROR_H
+
+typedef enum {
+    OT_ERROR_NONE = 0,
+    OT_ERROR_FAILED = 1,
+    OT_ERROR_NO_BUFS = 3,
+    OT_ERROR_PARSE = 6,
+    OT_ERROR_INVALID_ARGS = 7,
+    OT_ERROR_INVALID_STATE = 13,
+    OT_ERROR_NOT_FOUND = 23,
+    OT_ERROR_ALREADY = 24,
+} otError;
+
+#endif // HOST_OPENTHREAD_ERROR_H
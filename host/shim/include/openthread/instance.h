@@ -0,0 +1,17 @@
+#ifndef HOST_OPENTHREAD_INSTANCE_H
+#define HOST_OPENTHREAD_INSTANCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "openthread/error.h"
+
+typedef struct otInstance otInstance;
+typedef uint32_t otChangedFlags;
+typedef void (*otStateChangedCallback)(otChangedFlags aFlags, void *aContext);
+
+#define OT_CHANGED_IP6_ADDRESS_ADDED    (1U << 0)
+#define OT_CHANGED_THREAD_ROLE          (1U << 2)
+
+otError otSetStateChangedCallback(otInstance *aInstance, otStateChangedCallback aCallback, void *aContext);
+
+#endif // HOST_OPENTHREAD_INSTANCE_H
@@ -0,0 +1,25 @@
+#ifndef HOST_OPENTHREAD_IP6_H
+#define HOST_OPENTHREAD_IP6_H
+
+#include "openthread/instance.h"
+
+#define OT_IP6_ADDRESS_SIZE 16
+
+typedef struct {
+    union {
+        uint8_t m8[OT_IP6_ADDRESS_SIZE];
+        uint16_t m16[OT_IP6_ADDRESS_SIZE / 2];
+        uint32_t m32[OT_IP6_ADDRESS_SIZE / 4];
+    } mFields;
+} otIp6Address;
+
+typedef struct otNetifAddress {
+    otIp6Address mAddress;
+    uint8_t mPrefixLength;
+    struct otNetifAddress *mNext;
+} otNetifAddress;
+
+const otNetifAddress *otIp6GetUnicastAddresses(otInstance *aInstance);
+bool otIp6IsAddressEqual(const otIp6Address *aFirst, const otIp6Address *aSecond);
+
+#endif // HOST_OPENTHREAD_IP6_H
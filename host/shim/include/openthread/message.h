@@ -0,0 +1,27 @@
+#ifndef HOST_OPENTHREAD_MESSAGE_H
+#define HOST_OPENTHREAD_MESSAGE_H
+
+#include "openthread/ip6.h"
+
+typedef struct otMessage otMessage;
+
+typedef struct {
+    otIp6Address mSockAddr;
+    otIp6Address mPeerAddr;
+    uint16_t mSockPort;
+    uint16_t mPeerPort;
+    uint8_t mHopLimit;
+} otMessageInfo;
+
+typedef struct {
+    bool mLinkSecurityEnabled;
+    uint8_t mPriority;
+} otMessageSettings;
+
+uint16_t otMessageGetLength(const otMessage *aMessage);
+uint16_t otMessageGetOffset(const otMessage *aMessage);
+uint16_t otMessageRead(const otMessage *aMessage, uint16_t aOffset, void *aBuf, uint16_t aLength);
+otError otMessageAppend(otMessage *aMessage, const void *aBuf, uint16_t aLength);
+void otMessageFree(otMessage *aMessage);
+
+#endif // HOST_OPENTHREAD_MESSAGE_H
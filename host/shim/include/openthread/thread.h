@@ -0,0 +1,16 @@
+#ifndef HOST_OPENTHREAD_THREAD_H
+#define HOST_OPENTHREAD_THREAD_H
+
+#include "openthread/instance.h"
+
+typedef enum {
+    OT_DEVICE_ROLE_DISABLED = 0,
+    OT_DEVICE_ROLE_DETACHED = 1,
+    OT_DEVICE_ROLE_CHILD = 2,
+    OT_DEVICE_ROLE_ROUTER = 3,
+    OT_DEVICE_ROLE_LEADER = 4,
+} otDeviceRole;
+
+otDeviceRole otThreadGetDeviceRole(otInstance *aInstance);
+
+#endif // HOST_OPENTHREAD_THREAD_H
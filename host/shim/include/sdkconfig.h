@@ -0,0 +1,105 @@
+/*
+ * Host build configuration: the Kconfig defaults of main/Kconfig.projbuild.
+ * Any value can be overridden from CMake (-DCONFIG_...=...).
+ */
+#ifndef HOST_SDKCONFIG_H
+#define HOST_SDKCONFIG_H
+
+#ifndef CONFIG_SENSOR_COAP_REPORT_INTERVAL_MS
+#define CONFIG_SENSOR_COAP_REPORT_INTERVAL_MS 0
+#endif
+#ifndef CONFIG_SENSOR_RATE_BUDGET_RPS
+#define CONFIG_SENSOR_RATE_BUDGET_RPS 20
+#endif
+#ifndef CONFIG_SENSOR_RATE_MIN_PERIOD_MS
+#define CONFIG_SENSOR_RATE_MIN_PERIOD_MS 1000
+#endif
+#ifndef CONFIG_SENSOR_RATE_MAX_PERIOD_MS
+#define CONFIG_SENSOR_RATE_MAX_PERIOD_MS 300000
+#endif
+#ifndef CONFIG_SENSOR_REGISTRY_MAX_DEVICES
+#define CONFIG_SENSOR_REGISTRY_MAX_DEVICES 64
+#endif
+#ifndef CONFIG_SENSOR_REGISTRY_IDLE_S
+#define CONFIG_SENSOR_REGISTRY_IDLE_S 3600
+#endif
+#ifndef CONFIG_SENSOR_COAP_MAX_OBSERVERS
+#define CONFIG_SENSOR_COAP_MAX_OBSERVERS 8
+#endif
+#ifndef CONFIG_SENSOR_FRAME_MAX_SIZE
+#define CONFIG_SENSOR_FRAME_MAX_SIZE 512
+#endif
+#ifndef CONFIG_SENSOR_PIPELINE_DEPTH
+#define CONFIG_SENSOR_PIPELINE_DEPTH 32
+#endif
+#ifndef CONFIG_SENSOR_CLASS_QUEUE_DEPTH
+#define CONFIG_SENSOR_CLASS_QUEUE_DEPTH 16
+#endif
+#ifndef CONFIG_SENSOR_BATCH_MAX_READINGS
+#define CONFIG_SENSOR_BATCH_MAX_READINGS 10
+#endif
+#ifndef CONFIG_SENSOR_BATCH_LINGER_MS
+#define CONFIG_SENSOR_BATCH_LINGER_MS 200
+#endif
+#ifndef CONFIG_SENSOR_DEADBAND_HEARTBEAT_MS
+#define CONFIG_SENSOR_DEADBAND_HEARTBEAT_MS 0
+#endif
+#ifndef CONFIG_SENSOR_DEADBAND_TEMP
+#define CONFIG_SENSOR_DEADBAND_TEMP 20
+#endif
+#ifndef CONFIG_SENSOR_DEADBAND_HUM
+#define CONFIG_SENSOR_DEADBAND_HUM 100
+#endif
+#ifndef CONFIG_SENSOR_DEADBAND_PRESS
+#define CONFIG_SENSOR_DEADBAND_PRESS 50
+#endif
+#ifndef CONFIG_SENSOR_DEADBAND_GAS
+#define CONFIG_SENSOR_DEADBAND_GAS 500
+#endif
+#ifndef CONFIG_SENSOR_AGGREGATE_WINDOW_MS
+#define CONFIG_SENSOR_AGGREGATE_WINDOW_MS 0
+#endif
+#ifndef CONFIG_SENSOR_AGGREGATE_MAX_DEVICES
+#define CONFIG_SENSOR_AGGREGATE_MAX_DEVICES 32
+#endif
+#ifndef CONFIG_SENSOR_AGGREGATE_PASSTHROUGH
+#define CONFIG_SENSOR_AGGREGATE_PASSTHROUGH ""
+#endif
+#if !defined(CONFIG_SENSOR_PAYLOAD_CBOR) && !defined(CONFIG_SENSOR_PAYLOAD_JSON)
+#define CONFIG_SENSOR_PAYLOAD_JSON 1
+#endif
+#if defined(CONFIG_SENSOR_PAYLOAD_CBOR) && !defined(CONFIG_SENSOR_CBOR_HALF_FLOAT)
+#define CONFIG_SENSOR_CBOR_HALF_FLOAT 1
+#endif
+#ifndef CONFIG_MQTT_PUBLISH_WINDOW
+#define CONFIG_MQTT_PUBLISH_WINDOW 8
+#endif
+#ifndef CONFIG_MQTT_PUBACK_TIMEOUT_MS
+#define CONFIG_MQTT_PUBACK_TIMEOUT_MS 5000
+#endif
+#ifndef CONFIG_MQTT_WRITEV_BUFFER_SIZE
+#define CONFIG_MQTT_WRITEV_BUFFER_SIZE 1024
+#endif
+#ifndef CONFIG_SENSOR_SPOOL_REPLAY_BATCH
+#define CONFIG_SENSOR_SPOOL_REPLAY_BATCH 10
+#endif
+#ifndef CONFIG_SENSOR_SPOOL_REPLAY_INTERVAL_MS
+#define CONFIG_SENSOR_SPOOL_REPLAY_INTERVAL_MS 500
+#endif
+#ifndef CONFIG_SENSOR_METRICS_REPORT_MS
+#define CONFIG_SENSOR_METRICS_REPORT_MS 60000
+#endif
+#ifndef CONFIG_SENSOR_HEAP_WARMUP_PUBACKS
+#define CONFIG_SENSOR_HEAP_WARMUP_PUBACKS 200
+#endif
+#ifndef CONFIG_TASK_CORE_OPENTHREAD
+#define CONFIG_TASK_CORE_OPENTHREAD 0
+#endif
+#ifndef CONFIG_TASK_CORE_CLOUD
+#define CONFIG_TASK_CORE_CLOUD 1
+#endif
+#ifndef CONFIG_TASK_CORE_SERVICES
+#define CONFIG_TASK_CORE_SERVICES -1
+#endif
+
+#endif // HOST_SDKCONFIG_H
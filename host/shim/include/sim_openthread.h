@@ -0,0 +1,64 @@
+#ifndef SIM_OPENTHREAD_H
+#define SIM_OPENTHREAD_H
+
+#include <stdint.h>
+#include "openthread/coap.h"
+#include "openthread/thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Sentinel for sim_ot_request(): no Observe option
+ */
+#define SIM_OT_NO_OBSERVE UINT32_MAX
+
+/**
+ * @brief Called for every message the border router sends back (ACKs and
+ *        Observe notifications), still inside the simulated mainloop
+ *
+ * @param payload Payload after the marker, NULL if there is none
+ */
+typedef void (*sim_ot_response_fn)(void *context, const otMessageInfo *info, otCoapType type, otCoapCode code,
+                                   const uint8_t *payload, uint16_t length);
+
+/**
+ * @brief Number of message buffers, like the OpenThread message pool
+ *
+ * A request takes one and each response another, so the handler sees
+ * otCoapNewMessage() fail once the pool is exhausted.
+ */
+#define SIM_OT_MESSAGE_POOL 8
+
+/**
+ * @brief Where responses go
+ */
+void sim_ot_set_response_handler(sim_ot_response_fn fn, void *context);
+
+/**
+ * @brief Change the Thread role and run the state-changed callback, under
+ *        the OpenThread lock
+ */
+void sim_ot_set_role(otDeviceRole role);
+
+/**
+ * @brief Deliver one CoAP request to the resource registered for uri
+ *
+ * Runs the handler synchronously with the OpenThread lock held, as the
+ * mainloop does on the target. Must always be called from the same thread:
+ * it is the producer side of the sensor rings.
+ *
+ * @param observe Observe option value, or SIM_OT_NO_OBSERVE
+ * @return OT_ERROR_NOT_FOUND if the CoAP server is stopped or the URI is
+ *         unknown, OT_ERROR_NO_BUFS if the message pool is exhausted
+ */
+otError sim_ot_request(const char *uri, otCoapType type, otCoapCode code, const otMessageInfo *info,
+                       const uint8_t *token, uint8_t token_length, uint32_t observe,
+                       const void *payload, uint16_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_OPENTHREAD_H
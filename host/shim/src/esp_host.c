@@ -0,0 +1,270 @@
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_random.h"
+#include "esp_rom_crc.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_vfs_eventfd.h"
+#include "nvs.h"
+
+// ---- Reloj: microsegundos desde el "arranque" (primer uso) ----
+
+static int64_t monotonic_us(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static int64_t s_boot_us;
+
+__attribute__((constructor)) static void record_boot(void)
+{
+    s_boot_us = monotonic_us();
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return monotonic_us() - s_boot_us;
+}
+
+// ---- Log ----
+
+static esp_log_level_t s_log_level = (esp_log_level_t)-1;
+
+esp_log_level_t esp_log_host_level(void)
+{
+    if (s_log_level == (esp_log_level_t)-1) {
+        const char *env = getenv("SIM_LOG_LEVEL");
+        const char *levels = "NEWIDV";
+        const char *found = (env != NULL && env[0] != '\0') ? strchr(levels, env[0]) : NULL;
+        s_log_level = (found != NULL) ? (esp_log_level_t)(found - levels) : ESP_LOG_WARN;
+    }
+    return s_log_level;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    va_list args;
+
+    fprintf(stderr, "(%lld) ", (long long)(esp_timer_get_time() / 1000));
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK: return "ESP_OK";
+    case ESP_FAIL: return "ESP_FAIL";
+    case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_RESPONSE: return "ESP_ERR_INVALID_RESPONSE";
+    case ESP_ERR_INVALID_CRC: return "ESP_ERR_INVALID_CRC";
+    case ESP_ERR_NVS_NOT_FOUND: return "ESP_ERR_NVS_NOT_FOUND";
+    default: return "UNKNOWN ERROR";
+    }
+}
+
+// ---- Sistema ----
+
+// Valor fijo: el heap del host no dice nada del ESP32
+#define HOST_FAKE_HEAP_FREE (200 * 1024)
+
+uint32_t esp_get_free_heap_size(void)
+{
+    return HOST_FAKE_HEAP_FREE;
+}
+
+uint32_t esp_get_minimum_free_heap_size(void)
+{
+    return HOST_FAKE_HEAP_FREE;
+}
+
+void esp_restart(void)
+{
+    fprintf(stderr, "esp_restart() called, exiting\n");
+    exit(EXIT_FAILURE);
+}
+
+// xorshift32: reproducible si se fija SIM_SEED
+uint32_t esp_random(void)
+{
+    static __thread uint32_t s_state;
+
+    if (s_state == 0) {
+        const char *seed = getenv("SIM_SEED");
+        s_state = (seed != NULL) ? (uint32_t)strtoul(seed, NULL, 0) : (uint32_t)monotonic_us();
+        if (s_state == 0) {
+            s_state = 0x9E3779B9u;
+        }
+    }
+    s_state ^= s_state << 13;
+    s_state ^= s_state >> 17;
+    s_state ^= s_state << 5;
+    return s_state;
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+esp_err_t esp_vfs_eventfd_register(const esp_vfs_eventfd_config_t *config)
+{
+    (void)config;
+    return ESP_OK;
+}
+
+// ---- Flash: la partición "spool" de partitions.csv, en RAM ----
+
+#define HOST_SPOOL_SIZE     (256 * 1024)
+#define HOST_SECTOR_SIZE    4096
+
+static uint8_t s_spool_flash[HOST_SPOOL_SIZE];
+static bool s_spool_erased = false;
+
+static const esp_partition_t s_spool_partition = {
+    .type = ESP_PARTITION_TYPE_DATA,
+    .subtype = 0x40,
+    .address = 0,
+    .size = HOST_SPOOL_SIZE,
+    .erase_size = HOST_SECTOR_SIZE,
+    .label = "spool",
+};
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label)
+{
+    if (type != ESP_PARTITION_TYPE_DATA || label == NULL || strcmp(label, s_spool_partition.label) != 0) {
+        return NULL;
+    }
+    if (!s_spool_erased) {
+        memset(s_spool_flash, 0xFF, sizeof(s_spool_flash));
+        s_spool_erased = true;
+    }
+    return &s_spool_partition;
+}
+
+static bool in_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+    return partition == &s_spool_partition && offset <= partition->size && size <= partition->size - offset;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+    if (!in_range(partition, src_offset, size)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(dst, &s_spool_flash[src_offset], size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size)
+{
+    const uint8_t *bytes = src;
+
+    if (!in_range(partition, dst_offset, size)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    // NOR: escribir solo puede poner bits a 0
+    for (size_t i = 0; i < size; i++) {
+        s_spool_flash[dst_offset + i] &= bytes[i];
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+    if (!in_range(partition, offset, size) || offset % HOST_SECTOR_SIZE != 0 || size % HOST_SECTOR_SIZE != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(&s_spool_flash[offset], 0xFF, size);
+    return ESP_OK;
+}
+
+// ---- NVS en memoria: pocas claves u16 ----
+
+#define HOST_NVS_MAX_KEYS 16
+
+typedef struct {
+    char name[32];
+    uint16_t value;
+} nvs_entry_t;
+
+static nvs_entry_t s_nvs[HOST_NVS_MAX_KEYS];
+static size_t s_nvs_count = 0;
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    (void)name;
+    (void)open_mode;
+    *out_handle = 1;
+    return ESP_OK;
+}
+
+static nvs_entry_t *nvs_find(const char *key)
+{
+    for (size_t i = 0; i < s_nvs_count; i++) {
+        if (strcmp(s_nvs[i].name, key) == 0) {
+            return &s_nvs[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t nvs_get_u16(nvs_handle_t handle, const char *key, uint16_t *out_value)
+{
+    nvs_entry_t *entry = nvs_find(key);
+
+    if (entry == NULL) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *out_value = entry->value;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_u16(nvs_handle_t handle, const char *key, uint16_t value)
+{
+    nvs_entry_t *entry = nvs_find(key);
+
+    if (entry == NULL) {
+        if (s_nvs_count == HOST_NVS_MAX_KEYS) {
+            return ESP_ERR_NO_MEM;
+        }
+        entry = &s_nvs[s_nvs_count++];
+        snprintf(entry->name, sizeof(entry->name), "%s", key);
+    }
+    entry->value = value;
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+}
@@ -0,0 +1,274 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Una tarea es un pthread desacoplado más su contador de notificaciones
+struct host_task {
+    pthread_t thread;
+    TaskFunction_t code;
+    void *param;
+    const char *name;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify;
+    _Atomic bool deleted;
+};
+
+static __thread struct host_task *s_current = NULL;
+static pthread_condattr_t s_cond_attr;
+static pthread_once_t s_once = PTHREAD_ONCE_INIT;
+
+static void init_once(void)
+{
+    // Las esperas con timeout usan el reloj monótono, como los ticks
+    pthread_condattr_init(&s_cond_attr);
+    pthread_condattr_setclock(&s_cond_attr, CLOCK_MONOTONIC);
+}
+
+static struct host_task *task_alloc(TaskFunction_t code, const char *name, void *param)
+{
+    pthread_once(&s_once, init_once);
+
+    struct host_task *task = calloc(1, sizeof(*task));
+    if (task == NULL) {
+        return NULL;
+    }
+    task->code = code;
+    task->param = param;
+    task->name = name;
+    pthread_mutex_init(&task->lock, NULL);
+    pthread_cond_init(&task->cond, &s_cond_attr);
+    return task;
+}
+
+static void *task_entry(void *arg)
+{
+    struct host_task *task = arg;
+
+    s_current = task;
+    task->code(task->param);
+    // Una tarea de FreeRTOS no debe retornar; si lo hace, se da por borrada
+    task->deleted = true;
+    return NULL;
+}
+
+static TaskHandle_t task_start(TaskFunction_t code, const char *name, void *param)
+{
+    struct host_task *task = task_alloc(code, name, param);
+    pthread_attr_t attr;
+
+    if (task == NULL) {
+        return NULL;
+    }
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int err = pthread_create(&task->thread, &attr, task_entry, task);
+    pthread_attr_destroy(&attr);
+    if (err != 0) {
+        free(task);
+        return NULL;
+    }
+    return task;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name, uint32_t stack_depth, void *param,
+                       UBaseType_t priority, TaskHandle_t *created)
+{
+    TaskHandle_t task = task_start(code, name, param);
+
+    if (created != NULL) {
+        *created = task;
+    }
+    return (task != NULL) ? pdPASS : pdFAIL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char *name, uint32_t stack_depth, void *param,
+                                   UBaseType_t priority, TaskHandle_t *created, BaseType_t core)
+{
+    return xTaskCreate(code, name, stack_depth, param, priority, created);
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t code, const char *name, uint32_t stack_depth, void *param,
+                               UBaseType_t priority, StackType_t *stack, StaticTask_t *tcb)
+{
+    return task_start(code, name, param);
+}
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t code, const char *name, uint32_t stack_depth,
+                                           void *param, UBaseType_t priority, StackType_t *stack,
+                                           StaticTask_t *tcb, BaseType_t core)
+{
+    return task_start(code, name, param);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task != NULL && task != xTaskGetCurrentTaskHandle()) {
+        abort();  // borrar otra tarea no está soportado
+    }
+    s_current->deleted = true;
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec ts = {
+        .tv_sec = ticks / configTICK_RATE_HZ,
+        .tv_nsec = (long)(ticks % configTICK_RATE_HZ) * (1000000000L / configTICK_RATE_HZ),
+    };
+
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (TickType_t)((uint64_t)now.tv_sec * configTICK_RATE_HZ +
+                        (uint64_t)now.tv_nsec / (1000000000UL / configTICK_RATE_HZ));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    // Hilos que no se crearon como tareas (main) reciben su descriptor al
+    // pedirlo por primera vez
+    if (s_current == NULL) {
+        s_current = task_alloc(NULL, "main", NULL);
+        if (s_current == NULL) {
+            abort();
+        }
+        s_current->thread = pthread_self();
+    }
+    return s_current;
+}
+
+eTaskState eTaskGetState(TaskHandle_t task)
+{
+    if (task == xTaskGetCurrentTaskHandle()) {
+        return eRunning;
+    }
+    return task->deleted ? eDeleted : eReady;
+}
+
+const char *pcTaskGetName(TaskHandle_t task)
+{
+    return (task != NULL ? task : xTaskGetCurrentTaskHandle())->name;
+}
+
+static void deadline_after(TickType_t ticks, struct timespec *deadline)
+{
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += ticks / configTICK_RATE_HZ;
+    deadline->tv_nsec += (long)(ticks % configTICK_RATE_HZ) * (1000000000L / configTICK_RATE_HZ);
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    struct host_task *task = xTaskGetCurrentTaskHandle();
+    struct timespec deadline;
+    uint32_t value;
+
+    deadline_after(ticks, &deadline);
+    pthread_mutex_lock(&task->lock);
+    while (task->notify == 0 && ticks != 0) {
+        int err = (ticks == portMAX_DELAY) ? pthread_cond_wait(&task->cond, &task->lock)
+                                           : pthread_cond_timedwait(&task->cond, &task->lock, &deadline);
+        if (err == ETIMEDOUT) {
+            break;
+        }
+    }
+    value = task->notify;
+    if (value != 0) {
+        task->notify = clear_on_exit ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->lock);
+    task->notify++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+void vTaskSetTimeOutState(TimeOut_t *timeout)
+{
+    timeout->start = xTaskGetTickCount();
+}
+
+BaseType_t xTaskCheckForTimeOut(TimeOut_t *timeout, TickType_t *ticks_to_wait)
+{
+    if (*ticks_to_wait == portMAX_DELAY) {
+        return pdFALSE;
+    }
+
+    TickType_t now = xTaskGetTickCount();
+    TickType_t elapsed = now - timeout->start;
+    if (elapsed >= *ticks_to_wait) {
+        *ticks_to_wait = 0;
+        return pdTRUE;
+    }
+    *ticks_to_wait -= elapsed;
+    timeout->start = now;
+    return pdFALSE;
+}
+
+BaseType_t xPortGetCoreID(void)
+{
+    return 0;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buffer)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ERRORCHECK);
+    pthread_mutex_init(&buffer->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    return buffer;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    StaticSemaphore_t *buffer = malloc(sizeof(*buffer));
+
+    return (buffer != NULL) ? xSemaphoreCreateMutexStatic(buffer) : NULL;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY) {
+        return pthread_mutex_lock(&semaphore->mutex) == 0 ? pdTRUE : pdFALSE;
+    }
+
+    // pthread_mutex_timedlock solo admite CLOCK_REALTIME
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += ticks / configTICK_RATE_HZ;
+    deadline.tv_nsec += (long)(ticks % configTICK_RATE_HZ) * (1000000000L / configTICK_RATE_HZ);
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    return pthread_mutex_timedlock(&semaphore->mutex, &deadline) == 0 ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    return pthread_mutex_unlock(&semaphore->mutex) == 0 ? pdTRUE : pdFALSE;
+}
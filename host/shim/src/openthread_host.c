@@ -0,0 +1,359 @@
+#include <pthread.h>
+#include <stddef.h>
+#include <string.h>
+#include "esp_openthread.h"
+#include "esp_openthread_lock.h"
+#include "sim_openthread.h"
+
+// Mensajes sin codificar: cabecera CoAP como campos, payload en buf desde el
+// offset 0 (el marcador de payload no ocupa bytes)
+#define SIM_OT_MESSAGE_SIZE 1280
+
+struct otMessage {
+    bool in_use;
+    otCoapType type;
+    otCoapCode code;
+    uint8_t token[OT_COAP_MAX_TOKEN_LENGTH];
+    uint8_t token_length;
+    bool has_observe;
+    uint32_t observe;
+    uint16_t length;
+    uint8_t buf[SIM_OT_MESSAGE_SIZE];
+};
+
+struct otInstance {
+    otDeviceRole role;
+    otStateChangedCallback state_callback;
+    void *state_context;
+    bool coap_started;
+    otCoapResource *resources;
+    sim_ot_response_fn response_fn;
+    void *response_context;
+    otMessage pool[SIM_OT_MESSAGE_POOL];
+};
+
+static otInstance s_instance = { .role = OT_DEVICE_ROLE_DISABLED };
+
+static pthread_mutex_t s_lock;
+static pthread_once_t s_lock_once = PTHREAD_ONCE_INIT;
+
+static void lock_init(void)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&s_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+bool esp_openthread_lock_acquire(TickType_t block_ticks)
+{
+    (void)block_ticks;
+    pthread_once(&s_lock_once, lock_init);
+    return pthread_mutex_lock(&s_lock) == 0;
+}
+
+void esp_openthread_lock_release(void)
+{
+    pthread_mutex_unlock(&s_lock);
+}
+
+otInstance *esp_openthread_get_instance(void)
+{
+    return &s_instance;
+}
+
+// ---- Estado ----
+
+otError otSetStateChangedCallback(otInstance *aInstance, otStateChangedCallback aCallback, void *aContext)
+{
+    if (aInstance->state_callback != NULL && aInstance->state_callback != aCallback) {
+        return OT_ERROR_ALREADY;
+    }
+    aInstance->state_callback = aCallback;
+    aInstance->state_context = aContext;
+    return OT_ERROR_NONE;
+}
+
+otDeviceRole otThreadGetDeviceRole(otInstance *aInstance)
+{
+    return aInstance->role;
+}
+
+void sim_ot_set_role(otDeviceRole role)
+{
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    if (s_instance.role != role) {
+        s_instance.role = role;
+        if (s_instance.state_callback != NULL) {
+            s_instance.state_callback(OT_CHANGED_THREAD_ROLE, s_instance.state_context);
+        }
+    }
+    esp_openthread_lock_release();
+}
+
+// ---- IPv6 ----
+
+// fd00:db8::1, la ML-EID del border router
+static const otNetifAddress s_mesh_local = {
+    .mAddress.mFields.m8 = { 0xfd, 0x00, 0x0d, 0xb8, [15] = 0x01 },
+    .mPrefixLength = 64,
+};
+
+const otNetifAddress *otIp6GetUnicastAddresses(otInstance *aInstance)
+{
+    (void)aInstance;
+    return &s_mesh_local;
+}
+
+bool otIp6IsAddressEqual(const otIp6Address *aFirst, const otIp6Address *aSecond)
+{
+    return memcmp(aFirst->mFields.m8, aSecond->mFields.m8, OT_IP6_ADDRESS_SIZE) == 0;
+}
+
+// ---- Mensajes ----
+
+uint16_t otMessageGetLength(const otMessage *aMessage)
+{
+    return aMessage->length;
+}
+
+uint16_t otMessageGetOffset(const otMessage *aMessage)
+{
+    (void)aMessage;
+    return 0;
+}
+
+uint16_t otMessageRead(const otMessage *aMessage, uint16_t aOffset, void *aBuf, uint16_t aLength)
+{
+    if (aOffset >= aMessage->length) {
+        return 0;
+    }
+    if (aLength > aMessage->length - aOffset) {
+        aLength = aMessage->length - aOffset;
+    }
+    memcpy(aBuf, &aMessage->buf[aOffset], aLength);
+    return aLength;
+}
+
+otError otMessageAppend(otMessage *aMessage, const void *aBuf, uint16_t aLength)
+{
+    if (aLength > sizeof(aMessage->buf) - aMessage->length) {
+        return OT_ERROR_NO_BUFS;
+    }
+    memcpy(&aMessage->buf[aMessage->length], aBuf, aLength);
+    aMessage->length += aLength;
+    return OT_ERROR_NONE;
+}
+
+void otMessageFree(otMessage *aMessage)
+{
+    if (aMessage != NULL) {
+        aMessage->in_use = false;
+    }
+}
+
+// ---- CoAP ----
+
+otError otCoapStart(otInstance *aInstance, uint16_t aPort)
+{
+    (void)aPort;
+    aInstance->coap_started = true;
+    return OT_ERROR_NONE;
+}
+
+otError otCoapStop(otInstance *aInstance)
+{
+    aInstance->coap_started = false;
+    return OT_ERROR_NONE;
+}
+
+void otCoapAddResource(otInstance *aInstance, otCoapResource *aResource)
+{
+    for (otCoapResource *entry = aInstance->resources; entry != NULL; entry = entry->mNext) {
+        if (entry == aResource) {
+            return;
+        }
+    }
+    aResource->mNext = aInstance->resources;
+    aInstance->resources = aResource;
+}
+
+void otCoapRemoveResource(otInstance *aInstance, otCoapResource *aResource)
+{
+    for (otCoapResource **link = &aInstance->resources; *link != NULL; link = &(*link)->mNext) {
+        if (*link == aResource) {
+            *link = aResource->mNext;
+            aResource->mNext = NULL;
+            return;
+        }
+    }
+}
+
+otMessage *otCoapNewMessage(otInstance *aInstance, const otMessageSettings *aSettings)
+{
+    (void)aSettings;
+    for (size_t i = 0; i < SIM_OT_MESSAGE_POOL; i++) {
+        otMessage *message = &aInstance->pool[i];
+        if (!message->in_use) {
+            memset(message, 0, offsetof(otMessage, buf));
+            message->in_use = true;
+            return message;
+        }
+    }
+    return NULL;
+}
+
+void otCoapMessageInit(otMessage *aMessage, otCoapType aType, otCoapCode aCode)
+{
+    aMessage->type = aType;
+    aMessage->code = aCode;
+    aMessage->token_length = 0;
+    aMessage->has_observe = false;
+    aMessage->length = 0;
+}
+
+otError otCoapMessageInitResponse(otMessage *aResponse, const otMessage *aRequest, otCoapType aType,
+                                  otCoapCode aCode)
+{
+    otCoapMessageInit(aResponse, aType, aCode);
+    return otCoapMessageSetToken(aResponse, aRequest->token, aRequest->token_length);
+}
+
+otError otCoapMessageSetToken(otMessage *aMessage, const uint8_t *aToken, uint8_t aTokenLength)
+{
+    if (aTokenLength > OT_COAP_MAX_TOKEN_LENGTH) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+    memcpy(aMessage->token, aToken, aTokenLength);
+    aMessage->token_length = aTokenLength;
+    return OT_ERROR_NONE;
+}
+
+otError otCoapMessageSetPayloadMarker(otMessage *aMessage)
+{
+    (void)aMessage;
+    return OT_ERROR_NONE;
+}
+
+otError otCoapMessageAppendObserveOption(otMessage *aMessage, uint32_t aObserve)
+{
+    aMessage->has_observe = true;
+    aMessage->observe = aObserve & 0xFFFFFF;
+    return OT_ERROR_NONE;
+}
+
+otError otCoapMessageAppendContentFormatOption(otMessage *aMessage, otCoapOptionContentFormat aContentFormat)
+{
+    (void)aMessage;
+    (void)aContentFormat;
+    return OT_ERROR_NONE;
+}
+
+otCoapType otCoapMessageGetType(const otMessage *aMessage)
+{
+    return aMessage->type;
+}
+
+otCoapCode otCoapMessageGetCode(const otMessage *aMessage)
+{
+    return aMessage->code;
+}
+
+const uint8_t *otCoapMessageGetToken(const otMessage *aMessage)
+{
+    return aMessage->token;
+}
+
+uint8_t otCoapMessageGetTokenLength(const otMessage *aMessage)
+{
+    return aMessage->token_length;
+}
+
+// Solo se modela la opción Observe
+otError otCoapOptionIteratorInit(otCoapOptionIterator *aIterator, const otMessage *aMessage)
+{
+    memset(aIterator, 0, sizeof(*aIterator));
+    aIterator->mMessage = aMessage;
+    return OT_ERROR_NONE;
+}
+
+const otCoapOption *otCoapOptionIteratorGetFirstOptionMatching(otCoapOptionIterator *aIterator, uint16_t aOption)
+{
+    if (aOption != OT_COAP_OPTION_OBSERVE || !aIterator->mMessage->has_observe) {
+        return NULL;
+    }
+    aIterator->mOption.mNumber = aOption;
+    aIterator->mOption.mLength = 3;
+    return &aIterator->mOption;
+}
+
+otError otCoapOptionIteratorGetOptionUintValue(otCoapOptionIterator *aIterator, uint64_t *aValue)
+{
+    if (aIterator->mOption.mNumber != OT_COAP_OPTION_OBSERVE) {
+        return OT_ERROR_NOT_FOUND;
+    }
+    *aValue = aIterator->mMessage->observe;
+    return OT_ERROR_NONE;
+}
+
+otError otCoapSendResponse(otInstance *aInstance, otMessage *aMessage, const otMessageInfo *aMessageInfo)
+{
+    if (!aInstance->coap_started) {
+        return OT_ERROR_INVALID_STATE;
+    }
+    if (aInstance->response_fn != NULL) {
+        aInstance->response_fn(aInstance->response_context, aMessageInfo, aMessage->type, aMessage->code,
+                               aMessage->length > 0 ? aMessage->buf : NULL, aMessage->length);
+    }
+    otMessageFree(aMessage);
+    return OT_ERROR_NONE;
+}
+
+// ---- Lado del nodo ----
+
+void sim_ot_set_response_handler(sim_ot_response_fn fn, void *context)
+{
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    s_instance.response_fn = fn;
+    s_instance.response_context = context;
+    esp_openthread_lock_release();
+}
+
+otError sim_ot_request(const char *uri, otCoapType type, otCoapCode code, const otMessageInfo *info,
+                       const uint8_t *token, uint8_t token_length, uint32_t observe,
+                       const void *payload, uint16_t length)
+{
+    otError error = OT_ERROR_NOT_FOUND;
+
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    otCoapResource *resource = NULL;
+    if (s_instance.coap_started) {
+        for (resource = s_instance.resources; resource != NULL; resource = resource->mNext) {
+            if (strcmp(resource->mUriPath, uri) == 0) {
+                break;
+            }
+        }
+    }
+    if (resource != NULL) {
+        otMessage *request = otCoapNewMessage(&s_instance, NULL);
+        error = (request != NULL) ? OT_ERROR_NONE : OT_ERROR_NO_BUFS;
+        if (error == OT_ERROR_NONE) {
+            otCoapMessageInit(request, type, code);
+            error = otCoapMessageSetToken(request, token, token_length);
+        }
+        if (error == OT_ERROR_NONE && observe != SIM_OT_NO_OBSERVE) {
+            error = otCoapMessageAppendObserveOption(request, observe);
+        }
+        if (error == OT_ERROR_NONE && length > 0) {
+            error = otMessageAppend(request, payload, length);
+        }
+        if (error == OT_ERROR_NONE) {
+            resource->mHandler(resource->mContext, request, info);
+        }
+        otMessageFree(request);
+    }
+    esp_openthread_lock_release();
+    return error;
+}
@@ -0,0 +1,391 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "network_transport.h"
+#include "transport_deadline.h"
+
+#define TAG "network_transport"
+
+#define SIM_BROKER_DEFAULT_HOST "127.0.0.1"
+#define SIM_BROKER_DEFAULT_PORT "1883"
+
+// coreMQTT no pasa más de unos pocos vectores por paquete (SUBSCRIBE: 4 por filtro)
+#define SIM_WRITEV_MAX_VECTORS  64
+
+static Timeouts_t timeouts = { .connectionTimeoutMs = 4000, .handshakeTimeoutMs = 20000,
+                               .sendTimeoutMs = 10000, .recvTimeoutMs = 2000 };
+
+// Una sola conexión a la vez, como en aws_task.c
+static esp_tls_t s_tls = { .sockfd = -1 };
+
+void vTlsSetConnectTimeout( uint16_t connectionTimeoutMs )
+{
+    timeouts.connectionTimeoutMs = connectionTimeoutMs;
+}
+
+void vTlsSetHandshakeTimeout( uint16_t handshakeTimeoutMs )
+{
+    timeouts.handshakeTimeoutMs = handshakeTimeoutMs;
+}
+
+void vTlsSetSendTimeout( uint16_t sendTimeoutMs )
+{
+    timeouts.sendTimeoutMs = sendTimeoutMs;
+}
+
+void vTlsSetRecvTimeout( uint16_t recvTimeoutMs )
+{
+    timeouts.recvTimeoutMs = recvTimeoutMs;
+}
+
+esp_err_t esp_tls_get_conn_sockfd( esp_tls_t *tls, int *sockfd )
+{
+    if( ( tls == NULL ) || ( sockfd == NULL ) )
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *sockfd = tls->sockfd;
+    return ESP_OK;
+}
+
+ssize_t esp_tls_get_bytes_avail( esp_tls_t *tls )
+{
+    return ( tls == NULL ) ? -1 : 0;
+}
+
+static const char *env_or( const char *name, const char *fallback )
+{
+    const char *value = getenv( name );
+
+    return ( value != NULL && value[0] != '\0' ) ? value : fallback;
+}
+
+// Conexión en curso de xTlsConnectStart()/xTlsConnectStep(): sin TLS, solo
+// el connect() no bloqueante
+static esp_tls_t s_connecting = { .sockfd = -1 };
+
+// Resuelve el broker y lanza connect() no bloqueante hacia la primera
+// dirección que lo acepte; devuelve el socket o -1
+static int start_tcp_connect( void )
+{
+    const char *host = env_or( "SIM_BROKER_HOST", SIM_BROKER_DEFAULT_HOST );
+    const char *port = env_or( "SIM_BROKER_PORT", SIM_BROKER_DEFAULT_PORT );
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *list = NULL;
+    int fd = -1;
+
+    if( getaddrinfo( host, port, &hints, &list ) == 0 )
+    {
+        for( const struct addrinfo *ai = list; ( ai != NULL ) && ( fd < 0 ); ai = ai->ai_next )
+        {
+            fd = socket( ai->ai_family, ai->ai_socktype, ai->ai_protocol );
+            if( fd < 0 )
+            {
+                continue;
+            }
+            fcntl( fd, F_SETFL, fcntl( fd, F_GETFL ) | O_NONBLOCK );
+            if( ( connect( fd, ai->ai_addr, ai->ai_addrlen ) < 0 ) && ( errno != EINPROGRESS ) )
+            {
+                close( fd );
+                fd = -1;
+            }
+        }
+        freeaddrinfo( list );
+    }
+    if( fd < 0 )
+    {
+        ESP_LOGE( TAG, "Cannot reach broker %s:%s", host, port );
+    }
+    return fd;
+}
+
+TlsTransportStatus_t xTlsConnectStart( NetworkContext_t* pxNetworkContext )
+{
+    if( ( pxNetworkContext == NULL ) || ( pxNetworkContext->pxConnectingTls != NULL ) )
+    {
+        return TLS_TRANSPORT_INVALID_PARAMETER;
+    }
+    pxNetworkContext->xSessionOffered = false;
+    pxNetworkContext->pxConnectingTls = &s_connecting;
+    pxNetworkContext->xConnectDeadlineUs = xTransportDeadline( timeouts.connectionTimeoutMs );
+    return TLS_TRANSPORT_CONNECT_IN_PROGRESS;
+}
+
+TlsTransportStatus_t xTlsConnectStep( NetworkContext_t* pxNetworkContext )
+{
+    TlsTransportStatus_t xResult = TLS_TRANSPORT_CONNECT_FAILURE;
+
+    if( ( pxNetworkContext == NULL ) || ( pxNetworkContext->pxConnectingTls == NULL ) )
+    {
+        return TLS_TRANSPORT_INVALID_PARAMETER;
+    }
+    if( xSemaphoreTake( pxNetworkContext->xTlsContextSemaphore, portMAX_DELAY ) != pdTRUE )
+    {
+        return TLS_TRANSPORT_INTERNAL_ERROR;
+    }
+
+    esp_tls_t *pxTls = pxNetworkContext->pxConnectingTls;
+    struct pollfd pfd = { .fd = pxTls->sockfd, .events = POLLOUT };
+    int error = 0;
+    socklen_t len = sizeof( error );
+
+    if( pxTls->sockfd < 0 )
+    {
+        // Primer paso: resolver y lanzar connect()
+        pxTls->sockfd = start_tcp_connect();
+        pfd.fd = pxTls->sockfd;
+    }
+
+    if( pxTls->sockfd < 0 )
+    {
+        xResult = TLS_TRANSPORT_CONNECT_FAILURE;
+    }
+    else if( poll( &pfd, 1, 0 ) == 1 )
+    {
+        if( ( getsockopt( pxTls->sockfd, SOL_SOCKET, SO_ERROR, &error, &len ) == 0 ) && ( error == 0 ) )
+        {
+            s_tls.sockfd = pxTls->sockfd;
+            pxNetworkContext->pxTls = &s_tls;
+            xResult = TLS_TRANSPORT_SUCCESS;
+        }
+        else
+        {
+            ESP_LOGE( TAG, "connect() failed: %s", strerror( error ) );
+        }
+    }
+    else if( xTransportTimeLeft( pxNetworkContext->xConnectDeadlineUs, NULL ) )
+    {
+        xResult = TLS_TRANSPORT_CONNECT_IN_PROGRESS;
+    }
+
+    if( xResult != TLS_TRANSPORT_CONNECT_IN_PROGRESS )
+    {
+        if( ( xResult != TLS_TRANSPORT_SUCCESS ) && ( pxTls->sockfd >= 0 ) )
+        {
+            close( pxTls->sockfd );
+        }
+        pxTls->sockfd = -1;
+        pxNetworkContext->pxConnectingTls = NULL;
+    }
+
+    ( void ) xSemaphoreGive( pxNetworkContext->xTlsContextSemaphore );
+    return xResult;
+}
+
+int lTlsConnectPollFd( NetworkContext_t* pxNetworkContext, bool * pxWantWrite )
+{
+    if( ( pxNetworkContext == NULL ) || ( pxNetworkContext->pxConnectingTls == NULL ) )
+    {
+        return -1;
+    }
+    // Sin handshake: solo se espera a que el connect() termine
+    *pxWantWrite = true;
+    return pxNetworkContext->pxConnectingTls->sockfd;
+}
+
+TlsTransportStatus_t xTlsConnect( NetworkContext_t* pxNetworkContext )
+{
+    TlsTransportStatus_t xResult = xTlsConnectStart( pxNetworkContext );
+
+    while( xResult == TLS_TRANSPORT_CONNECT_IN_PROGRESS )
+    {
+        xResult = xTlsConnectStep( pxNetworkContext );
+        if( xResult == TLS_TRANSPORT_CONNECT_IN_PROGRESS )
+        {
+            ( void ) lTransportWait( pxNetworkContext->pxConnectingTls->sockfd, true, 0,
+                                     pxNetworkContext->xConnectDeadlineUs );
+        }
+    }
+    return xResult;
+}
+
+TlsTransportStatus_t xTlsDisconnect( NetworkContext_t* pxNetworkContext )
+{
+    if( xSemaphoreTake( pxNetworkContext->xTlsContextSemaphore, portMAX_DELAY ) != pdTRUE )
+    {
+        return TLS_TRANSPORT_DISCONNECT_FAILURE;
+    }
+    if( pxNetworkContext->pxTls != NULL )
+    {
+        close( pxNetworkContext->pxTls->sockfd );
+        pxNetworkContext->pxTls->sockfd = -1;
+        pxNetworkContext->pxTls = NULL;
+    }
+    ( void ) xSemaphoreGive( pxNetworkContext->xTlsContextSemaphore );
+    return TLS_TRANSPORT_SUCCESS;
+}
+
+int32_t espTlsTransportSend( NetworkContext_t* pxNetworkContext,
+                             const void* pvData, size_t uxDataLen )
+{
+    int32_t lBytesSent = -1;
+
+    if( ( pvData == NULL ) || ( uxDataLen == 0 ) ||
+        ( pxNetworkContext == NULL ) || ( pxNetworkContext->pxTls == NULL ) )
+    {
+        return -1;
+    }
+
+    int64_t deadline_us = xTransportDeadline( timeouts.sendTimeoutMs );
+
+    if( xSemaphoreTake( pxNetworkContext->xTlsContextSemaphore, pdMS_TO_TICKS( timeouts.sendTimeoutMs ) ) == pdTRUE )
+    {
+        const uint8_t *pucData = pvData;
+        int fd = pxNetworkContext->pxTls->sockfd;
+
+        lBytesSent = 0;
+        do
+        {
+            ssize_t lResult = send( fd, &pucData[lBytesSent], uxDataLen - lBytesSent, MSG_NOSIGNAL );
+
+            if( lResult >= 0 )
+            {
+                lBytesSent += ( int32_t ) lResult;
+            }
+            else if( ( errno == EAGAIN ) || ( errno == EWOULDBLOCK ) || ( errno == EINTR ) )
+            {
+                ( void ) lTransportWait( fd, true, 0, deadline_us );
+            }
+            else
+            {
+                ESP_LOGE( TAG, "send() failed: %s", strerror( errno ) );
+                lBytesSent = -1;
+            }
+        }
+        while( ( lBytesSent >= 0 ) && ( ( size_t ) lBytesSent < uxDataLen ) && xTransportTimeLeft( deadline_us, NULL ) );
+
+        ( void ) xSemaphoreGive( pxNetworkContext->xTlsContextSemaphore );
+    }
+
+    return lBytesSent;
+}
+
+// Sin TLS no hay registros que juntar: sendmsg() envía los vectores sin copiarlos
+int32_t espTlsTransportWritev( NetworkContext_t* pxNetworkContext,
+                               TransportOutVector_t* pxIoVec, size_t uxIoVecCount )
+{
+    struct iovec iov[ SIM_WRITEV_MAX_VECTORS ];
+    int32_t lBytesSent = -1;
+
+    if( ( pxIoVec == NULL ) || ( uxIoVecCount == 0 ) || ( uxIoVecCount > SIM_WRITEV_MAX_VECTORS ) ||
+        ( pxNetworkContext == NULL ) || ( pxNetworkContext->pxTls == NULL ) )
+    {
+        return -1;
+    }
+
+    for( size_t i = 0; i < uxIoVecCount; i++ )
+    {
+        iov[ i ].iov_base = ( void * ) pxIoVec[ i ].iov_base;
+        iov[ i ].iov_len = pxIoVec[ i ].iov_len;
+    }
+
+    int64_t deadline_us = xTransportDeadline( timeouts.sendTimeoutMs );
+
+    if( xSemaphoreTake( pxNetworkContext->xTlsContextSemaphore, pdMS_TO_TICKS( timeouts.sendTimeoutMs ) ) == pdTRUE )
+    {
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = uxIoVecCount };
+        int fd = pxNetworkContext->pxTls->sockfd;
+
+        lBytesSent = 0;
+        while( msg.msg_iovlen > 0 )
+        {
+            ssize_t lResult = sendmsg( fd, &msg, MSG_NOSIGNAL );
+
+            if( lResult >= 0 )
+            {
+                lBytesSent += ( int32_t ) lResult;
+                // Saltar lo enviado: vectores completos y el principio del siguiente
+                while( ( msg.msg_iovlen > 0 ) && ( ( size_t ) lResult >= msg.msg_iov->iov_len ) )
+                {
+                    lResult -= msg.msg_iov->iov_len;
+                    msg.msg_iov++;
+                    msg.msg_iovlen--;
+                }
+                if( msg.msg_iovlen > 0 )
+                {
+                    msg.msg_iov->iov_base = ( uint8_t * ) msg.msg_iov->iov_base + lResult;
+                    msg.msg_iov->iov_len -= lResult;
+                }
+            }
+            else if( ( errno == EAGAIN ) || ( errno == EWOULDBLOCK ) || ( errno == EINTR ) )
+            {
+                ( void ) lTransportWait( fd, true, 0, deadline_us );
+            }
+            else
+            {
+                ESP_LOGE( TAG, "sendmsg() failed: %s", strerror( errno ) );
+                lBytesSent = -1;
+                break;
+            }
+
+            if( !xTransportTimeLeft( deadline_us, NULL ) )
+            {
+                break;
+            }
+        }
+
+        ( void ) xSemaphoreGive( pxNetworkContext->xTlsContextSemaphore );
+    }
+
+    return lBytesSent;
+}
+
+int32_t espTlsTransportRecv( NetworkContext_t* pxNetworkContext,
+                             void* pvData, size_t uxDataLen )
+{
+    int32_t lBytesRead = -1;
+
+    if( ( pvData == NULL ) || ( uxDataLen == 0 ) ||
+        ( pxNetworkContext == NULL ) || ( pxNetworkContext->pxTls == NULL ) )
+    {
+        return -1;
+    }
+
+    int64_t deadline_us = xTransportDeadline( timeouts.recvTimeoutMs );
+
+    if( xSemaphoreTake( pxNetworkContext->xTlsContextSemaphore, pdMS_TO_TICKS( timeouts.recvTimeoutMs ) ) == pdTRUE )
+    {
+        int fd = pxNetworkContext->pxTls->sockfd;
+
+        lBytesRead = 0;
+        do
+        {
+            ssize_t lResult = recv( fd, pvData, uxDataLen, MSG_DONTWAIT );
+
+            if( lResult > 0 )
+            {
+                lBytesRead = ( int32_t ) lResult;
+            }
+            else if( lResult == 0 )
+            {
+                ESP_LOGE( TAG, "Connection closed" );
+                lBytesRead = -1;
+            }
+            else if( ( errno == EAGAIN ) || ( errno == EWOULDBLOCK ) || ( errno == EINTR ) )
+            {
+                // Sin datos: con timeout 0 se vuelve enseguida, como en el destino
+                if( ( lTransportWait( fd, false, 0, deadline_us ) < 0 ) && ( errno != EINTR ) )
+                {
+                    lBytesRead = -1;
+                }
+            }
+            else
+            {
+                ESP_LOGE( TAG, "recv() failed: %s", strerror( errno ) );
+                lBytesRead = -1;
+            }
+        }
+        while( ( lBytesRead == 0 ) && xTransportTimeLeft( deadline_us, NULL ) );
+
+        ( void ) xSemaphoreGive( pxNetworkContext->xTlsContextSemaphore );
+    }
+    return lBytesRead;
+}
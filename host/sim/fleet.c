@@ -0,0 +1,310 @@
+#include "fleet.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "sensor_class.h"
+#include "sensor_frame.h"
+#include "shared_data.h"
+#include "sim_openthread.h"
+
+static const char *TAG = "SIM_FLEET";
+
+#define FLEET_MAX_METRICS   4
+#define FLEET_ID_LEN        8   // "sim-0000"
+#define FLEET_VALUE_LEN     4   // métricas siempre en 4 bytes
+
+// Paseo aleatorio de una métrica: paso máximo por lectura y límites
+typedef struct {
+    uint8_t type;
+    uint8_t decimals;
+    float start;
+    float step;
+    float min;
+    float max;
+    bool monotonic;  // contador que solo crece (energía)
+} fleet_metric_t;
+
+typedef struct {
+    const fleet_metric_t *metrics;
+    size_t count;
+} fleet_class_t;
+
+static const fleet_metric_t s_environment[] = {
+    { SENSOR_FRAME_M_TEMPERATURE, 2, 21.0f, 0.5f, -10.0f, 45.0f, false },
+    { SENSOR_FRAME_M_HUMIDITY, 2, 45.0f, 1.5f, 0.0f, 100.0f, false },
+    { SENSOR_FRAME_M_PRESSURE, 2, 1013.0f, 1.0f, 950.0f, 1050.0f, false },
+    { SENSOR_FRAME_M_GAS, 2, 100.0f, 10.0f, 0.0f, 1000.0f, false },
+};
+
+static const fleet_metric_t s_air_quality[] = {
+    { SENSOR_FRAME_M_CO2, 0, 600.0f, 25.0f, 400.0f, 5000.0f, false },
+    { SENSOR_FRAME_M_VOC_INDEX, 0, 100.0f, 10.0f, 1.0f, 500.0f, false },
+    { SENSOR_FRAME_M_PM2_5, 2, 12.0f, 1.5f, 0.0f, 500.0f, false },
+    { SENSOR_FRAME_M_PM10, 2, 20.0f, 2.0f, 0.0f, 600.0f, false },
+};
+
+static const fleet_metric_t s_energy[] = {
+    { SENSOR_FRAME_M_VOLTAGE, 2, 230.0f, 1.0f, 200.0f, 250.0f, false },
+    { SENSOR_FRAME_M_CURRENT, 2, 5.0f, 0.5f, 0.0f, 32.0f, false },
+    { SENSOR_FRAME_M_POWER, 2, 1000.0f, 50.0f, 0.0f, 7000.0f, false },
+    { SENSOR_FRAME_M_ENERGY, 0, 0.0f, 10.0f, 0.0f, 1e9f, true },
+};
+
+static const fleet_metric_t s_occupancy[] = {
+    { SENSOR_FRAME_M_OCCUPIED, 0, 0.0f, 1.0f, 0.0f, 1.0f, false },
+    { SENSOR_FRAME_M_PEOPLE, 0, 0.0f, 1.0f, 0.0f, 20.0f, false },
+    { SENSOR_FRAME_M_ILLUMINANCE, 0, 300.0f, 20.0f, 0.0f, 2000.0f, false },
+};
+
+#define CLASS(table) { (table), sizeof(table) / sizeof((table)[0]) }
+
+static const fleet_class_t s_classes[SENSOR_CLASS_COUNT] = {
+    [SENSOR_CLASS_ENVIRONMENT] = CLASS(s_environment),
+    [SENSOR_CLASS_AIR_QUALITY] = CLASS(s_air_quality),
+    [SENSOR_CLASS_ENERGY] = CLASS(s_energy),
+    [SENSOR_CLASS_OCCUPANCY] = CLASS(s_occupancy),
+};
+
+typedef struct {
+    sensor_class_t cls;
+    char id[FLEET_ID_LEN + 1];
+    otMessageInfo info;
+    int64_t next_due_us;
+    uint32_t period_ms;
+    uint16_t token;
+    float values[FLEET_MAX_METRICS];
+} fleet_node_t;
+
+typedef struct {
+    const sim_fleet_config_t *config;
+    sim_fleet_stats_t *stats;
+    fleet_node_t *nodes;
+    uint32_t random;
+} fleet_t;
+
+static uint32_t fleet_random(fleet_t *fleet)
+{
+    fleet->random ^= fleet->random << 13;
+    fleet->random ^= fleet->random >> 17;
+    fleet->random ^= fleet->random << 5;
+    return fleet->random;
+}
+
+// Uniforme en [-1, 1]
+static float fleet_uniform(fleet_t *fleet)
+{
+    return (float)(fleet_random(fleet) & 0xFFFF) / 32767.5f - 1.0f;
+}
+
+// Dirección mesh-local del nodo: el índice va en los dos últimos bytes del IID
+static void node_address(uint32_t index, otIp6Address *address)
+{
+    static const uint8_t prefix[8] = { 0xfd, 0x00, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00 };
+
+    memcpy(address->mFields.m8, prefix, sizeof(prefix));
+    address->mFields.m8[8] = 0x02;
+    address->mFields.m8[9] = 's';
+    address->mFields.m8[10] = 'i';
+    address->mFields.m8[11] = 'm';
+    address->mFields.m8[12] = (uint8_t)(index >> 24);
+    address->mFields.m8[13] = (uint8_t)(index >> 16);
+    address->mFields.m8[14] = (uint8_t)(index >> 8);
+    address->mFields.m8[15] = (uint8_t)index;
+}
+
+static uint32_t node_index(const otIp6Address *address)
+{
+    const uint8_t *m8 = address->mFields.m8;
+
+    return ((uint32_t)m8[12] << 24) | ((uint32_t)m8[13] << 16) | ((uint32_t)m8[14] << 8) | m8[15];
+}
+
+static size_t put_record(uint8_t *buf, uint8_t type, const void *value, uint8_t length)
+{
+    buf[0] = type;
+    buf[1] = length;
+    memcpy(&buf[2], value, length);
+    return 2 + (size_t)length;
+}
+
+// Avanza el paseo aleatorio y añade una lectura a la trama
+static size_t put_reading(fleet_t *fleet, fleet_node_t *node, uint8_t *buf)
+{
+    const fleet_class_t *cls = &s_classes[node->cls];
+    uint8_t reading[FLEET_MAX_METRICS * (2 + FLEET_VALUE_LEN)];
+    size_t len = 0;
+
+    for (size_t m = 0; m < cls->count; m++) {
+        const fleet_metric_t *metric = &cls->metrics[m];
+        float step = metric->step * fleet_uniform(fleet);
+        float value = node->values[m] + (metric->monotonic ? fabsf(step) : step);
+
+        value = fminf(fmaxf(value, metric->min), metric->max);
+        node->values[m] = value;
+
+        int32_t fixed = (int32_t)lroundf(metric->decimals ? value * 100.0f : value);
+        uint8_t le[FLEET_VALUE_LEN] = {
+            (uint8_t)fixed, (uint8_t)(fixed >> 8), (uint8_t)(fixed >> 16), (uint8_t)(fixed >> 24),
+        };
+        len += put_record(&reading[len], metric->type, le, sizeof(le));
+    }
+    return put_record(buf, SENSOR_FRAME_T_READING, reading, (uint8_t)len);
+}
+
+static void send_frame(fleet_t *fleet, fleet_node_t *node, uint32_t readings)
+{
+    uint8_t frame[CONFIG_SENSOR_FRAME_MAX_SIZE];
+    size_t len = 0;
+
+    frame[len++] = SENSOR_FRAME_VERSION_1;
+    len += put_record(&frame[len], SENSOR_FRAME_T_DEVICE_ID, node->id, FLEET_ID_LEN);
+    for (uint32_t i = 0; i < readings; i++) {
+        len += put_reading(fleet, node, &frame[len]);
+    }
+
+    node->token++;
+    uint8_t token[2] = { (uint8_t)(node->token >> 8), (uint8_t)node->token };
+    otCoapType type = fleet->config->confirmable ? OT_COAP_TYPE_CONFIRMABLE : OT_COAP_TYPE_NON_CONFIRMABLE;
+    otError error = sim_ot_request(sensor_class_get(node->cls)->uri, type, OT_COAP_CODE_POST, &node->info,
+                                   token, sizeof(token), SIM_OT_NO_OBSERVE, frame, (uint16_t)len);
+    if (error != OT_ERROR_NONE) {
+        fleet->stats->undelivered++;
+        return;
+    }
+    fleet->stats->frames++;
+    fleet->stats->readings += readings;
+}
+
+// ACKs del border router, en el mismo hilo que sim_ot_request()
+static void on_response(void *context, const otMessageInfo *info, otCoapType type, otCoapCode code,
+                        const uint8_t *payload, uint16_t length)
+{
+    fleet_t *fleet = context;
+    uint32_t index = node_index(&info->mPeerAddr);
+
+    if (index >= fleet->config->devices) {
+        return;
+    }
+    if (type == OT_COAP_TYPE_ACKNOWLEDGMENT) {
+        if (code == OT_COAP_CODE_CHANGED) {
+            fleet->stats->acked++;
+        } else if (code == OT_COAP_CODE_SERVICE_UNAVAILABLE) {
+            fleet->stats->unavailable++;
+        } else {
+            fleet->stats->other_codes++;
+        }
+    }
+
+    // Periodo asignado por el control de ritmo (sensor_coap_config_t); se
+    // aplica a partir del próximo envío
+    sensor_coap_config_t config;
+    if (fleet->config->obey_rate_control && payload != NULL && length >= sizeof(config)) {
+        memcpy(&config, payload, sizeof(config));
+        fleet_node_t *node = &fleet->nodes[index];
+        if (config.report_interval_ms != 0 && config.report_interval_ms != node->period_ms) {
+            node->period_ms = config.report_interval_ms;
+            fleet->stats->period_changes++;
+        }
+    }
+}
+
+static void sleep_until(int64_t deadline_us)
+{
+    int64_t wait_us = deadline_us - esp_timer_get_time();
+
+    if (wait_us > 0) {
+        struct timespec ts = { .tv_sec = wait_us / 1000000, .tv_nsec = (wait_us % 1000000) * 1000 };
+        nanosleep(&ts, NULL);
+    }
+}
+
+void sim_fleet_run(const sim_fleet_config_t *config, sim_fleet_stats_t *stats)
+{
+    static const otIp6Address s_br_address = { .mFields.m8 = { 0xfd, 0x00, 0x0d, 0xb8, [15] = 0x01 } };
+    fleet_t fleet = {
+        .config = config,
+        .stats = stats,
+        .random = config->seed ? config->seed : 1,
+    };
+    size_t per_reading = 2 + FLEET_MAX_METRICS * (2 + FLEET_VALUE_LEN);
+    uint32_t max_readings = (CONFIG_SENSOR_FRAME_MAX_SIZE - 1 - (2 + FLEET_ID_LEN)) / per_reading;
+    uint32_t readings = config->readings_per_frame;
+    uint32_t mask = config->class_mask & ((1u << SENSOR_CLASS_COUNT) - 1);
+    int cls = 0;
+
+    memset(stats, 0, sizeof(*stats));
+    if (config->devices == 0 || mask == 0) {
+        ESP_LOGE(TAG, "Empty fleet (devices %lu, class mask 0x%lx)",
+                 (unsigned long)config->devices, (unsigned long)config->class_mask);
+        return;
+    }
+    if (readings == 0 || readings > max_readings) {
+        readings = (readings == 0) ? 1 : max_readings;
+        ESP_LOGW(TAG, "Readings per frame clamped to %lu", (unsigned long)readings);
+    }
+
+    fleet.nodes = calloc(config->devices, sizeof(fleet_node_t));
+    if (fleet.nodes == NULL) {
+        ESP_LOGE(TAG, "No memory for %lu nodes", (unsigned long)config->devices);
+        return;
+    }
+
+    // Arranques escalonados a lo largo del primer periodo
+    int64_t start_us = esp_timer_get_time();
+    int64_t end_us = start_us + (int64_t)config->duration_ms * 1000;
+    for (uint32_t i = 0; i < config->devices; i++) {
+        fleet_node_t *node = &fleet.nodes[i];
+
+        while ((mask & (1u << cls)) == 0) {
+            cls = (cls + 1) % SENSOR_CLASS_COUNT;
+        }
+        node->cls = cls;
+        cls = (cls + 1) % SENSOR_CLASS_COUNT;
+
+        snprintf(node->id, sizeof(node->id), "sim-%04u", (unsigned)(i % 10000));
+        node_address(i, &node->info.mPeerAddr);
+        node->info.mSockAddr = s_br_address;
+        node->info.mPeerPort = OT_DEFAULT_COAP_PORT;
+        node->info.mSockPort = OT_DEFAULT_COAP_PORT;
+        node->info.mHopLimit = 64;
+        node->period_ms = config->period_ms;
+        node->next_due_us = start_us + (int64_t)config->period_ms * 1000 * i / config->devices;
+        for (size_t m = 0; m < s_classes[node->cls].count; m++) {
+            node->values[m] = s_classes[node->cls].metrics[m].start;
+        }
+    }
+
+    sim_ot_set_response_handler(on_response, &fleet);
+    for (int64_t now = start_us; now < end_us; now = esp_timer_get_time()) {
+        int64_t next_us = end_us;
+
+        for (uint32_t i = 0; i < config->devices; i++) {
+            fleet_node_t *node = &fleet.nodes[i];
+
+            if (node->next_due_us <= now) {
+                uint32_t late_us = (uint32_t)(now - node->next_due_us);
+                if (late_us > stats->late_us_max) {
+                    stats->late_us_max = late_us;
+                }
+                send_frame(&fleet, node, readings);
+                // Un nodo real no recupera los envíos perdidos: si va tarde,
+                // el siguiente sale un periodo después de este
+                node->next_due_us += (int64_t)node->period_ms * 1000;
+                if (node->next_due_us < now) {
+                    node->next_due_us = now + (int64_t)node->period_ms * 1000;
+                }
+            }
+            if (node->next_due_us < next_us) {
+                next_us = node->next_due_us;
+            }
+        }
+        sleep_until(next_us);
+    }
+    sim_ot_set_response_handler(NULL, NULL);
+    free(fleet.nodes);
+}
@@ -0,0 +1,58 @@
+#ifndef SIM_FLEET_H
+#define SIM_FLEET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Shape of the synthetic Thread fleet
+ *
+ * Every node reports versioned TLV frames (sensor_frame.h) of its class on a
+ * fixed period, with values that random-walk far enough to get past the
+ * deadband. Nodes are named "sim-0000", "sim-0001"... and each has its own
+ * mesh-local address, so the device registry sees them as distinct nodes.
+ */
+typedef struct {
+    uint32_t devices;             /**< Number of nodes */
+    uint32_t period_ms;           /**< Initial report period of every node */
+    uint32_t readings_per_frame;  /**< Readings batched in each frame (clamped to the frame size) */
+    uint32_t duration_ms;         /**< How long sim_fleet_run() keeps sending */
+    uint32_t class_mask;          /**< Bit per sensor_class_t; nodes are spread round-robin */
+    uint32_t seed;                /**< Random walk seed; same seed, same values */
+    bool confirmable;             /**< CON requests (ACK expected) instead of NON */
+    bool obey_rate_control;       /**< Adopt the period the border router assigns in ACKs */
+} sim_fleet_config_t;
+
+/**
+ * @brief What the fleet sent and what the border router answered
+ */
+typedef struct {
+    uint64_t frames;            /**< Requests delivered to a CoAP resource */
+    uint64_t readings;          /**< Readings in those requests */
+    uint64_t acked;             /**< 2.04 Changed */
+    uint64_t unavailable;       /**< 5.03: at least part of the frame was dropped */
+    uint64_t other_codes;       /**< Any other response code */
+    uint64_t undelivered;       /**< Requests the simulated stack refused (server down, no buffers) */
+    uint64_t period_changes;    /**< Report period updates adopted from ACKs */
+    uint32_t late_us_max;       /**< Worst lag of a send behind its schedule */
+} sim_fleet_stats_t;
+
+/**
+ * @brief Run the fleet in the calling thread for config->duration_ms
+ *
+ * The calling thread plays the OpenThread mainloop: each frame is handed to
+ * the CoAP server through sim_ot_request(), with the OpenThread lock held,
+ * and the thread sleeps until the next node is due. It must therefore be
+ * the only producer of the sensor rings.
+ */
+void sim_fleet_run(const sim_fleet_config_t *config, sim_fleet_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_FLEET_H
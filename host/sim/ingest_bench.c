@@ -0,0 +1,301 @@
+// Banco de ingesta en host: flota sintética -> servidor CoAP -> rings ->
+// consumidor que serializa como aws_iot_task, sin MQTT. Mide lecturas/s,
+// latencia desde la llegada al handler CoAP hasta el payload listo y tasa de
+// descarte. Sale con 1 si se superan los umbrales de --max-drop/--max-p99-us.
+#include <getopt.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_openthread.h"
+#include "esp_openthread_lock.h"
+#include "esp_vfs_eventfd.h"
+#include "metrics.h"
+#include "sdkconfig.h"
+#include "sensor_class.h"
+#include "sensor_latency.h"
+#include "sensor_pipeline.h"
+#include "sensor_serializer.h"
+#include "sim_openthread.h"
+#include "thread_coap_task.h"
+#include "fleet.h"
+
+static const char *TAG = "INGEST_BENCH";
+
+#define BENCH_BATCH             CONFIG_SENSOR_BATCH_MAX_READINGS
+#define BENCH_PAYLOAD_SIZE      2048
+#define BENCH_IDLE_WAIT_MS      50
+#define BENCH_DRAIN_TIMEOUT_MS  2000
+
+static _Atomic bool s_stop = false;
+static _Atomic bool s_consumer_done = false;
+static _Atomic uint64_t s_consumed = 0;
+static _Atomic uint64_t s_payloads = 0;
+
+// Llegada al handler CoAP de la lectura más antigua -> payload serializado
+static metric_histogram_t s_ingest_storage;
+static metric_t s_ingest_to_payload = METRIC_HISTOGRAM_INIT("bench.ingest_to_payload", &s_ingest_storage);
+
+static void record_payload(uint32_t oldest_us, size_t readings)
+{
+    metric_histogram_record(&s_ingest_to_payload, sensor_latency_now_us() - oldest_us);
+    atomic_fetch_add(&s_consumed, readings);
+    atomic_fetch_add(&s_payloads, 1);
+}
+
+static size_t drain_environment(uint8_t *payload)
+{
+    sensor_data_t *readings[BENCH_BATCH];
+    size_t count = sensor_pipeline_receive_batch(readings, BENCH_BATCH, 0);
+
+    if (count == 0) {
+        return 0;
+    }
+
+    uint32_t taken_us = sensor_latency_now_us();
+    uint32_t oldest_us = readings[0]->ingest_us;
+    for (size_t i = 0; i < count; i++) {
+        sensor_latency_record(SENSOR_LATENCY_QUEUE, taken_us - readings[i]->ingest_us);
+    }
+
+    size_t len = 0;
+    size_t encoded = sensor_serializer_encode(readings, count, payload, BENCH_PAYLOAD_SIZE, &len);
+    sensor_latency_record(SENSOR_LATENCY_SERIALIZE, sensor_latency_now_us() - taken_us);
+    if (encoded < count) {
+        ESP_LOGW(TAG, "Payload full after %u of %u readings", (unsigned)encoded, (unsigned)count);
+    }
+    record_payload(oldest_us, count);
+    sensor_pipeline_release(count);
+    return count;
+}
+
+static size_t drain_classes(uint8_t *payload)
+{
+    void *records[BENCH_BATCH];
+    size_t total = 0;
+
+    for (int cls = SENSOR_CLASS_ENVIRONMENT + 1; cls < SENSOR_CLASS_COUNT; cls++) {
+        size_t count = sensor_class_receive(cls, records, BENCH_BATCH);
+        if (count == 0) {
+            continue;
+        }
+
+        uint32_t taken_us = sensor_latency_now_us();
+        uint32_t oldest_us = ((const sensor_record_header_t *)records[0])->ingest_us;
+        size_t len = 0;
+        sensor_serializer_encode_records(sensor_class_get(cls), (const void *const *)records, count,
+                                         payload, BENCH_PAYLOAD_SIZE, &len);
+        sensor_latency_record(SENSOR_LATENCY_SERIALIZE, sensor_latency_now_us() - taken_us);
+        record_payload(oldest_us, count);
+        sensor_class_release(cls, count);
+        total += count;
+    }
+    return total;
+}
+
+// Hace de aws_iot_task: duerme en select() sobre los dos eventfd y vacía los
+// rings con los mismos serializadores
+static void consumer_task(void *arg)
+{
+    static uint8_t s_payload[BENCH_PAYLOAD_SIZE];
+    int pipeline_fd = sensor_pipeline_get_eventfd();
+    int class_fd = sensor_class_get_eventfd();
+    int maxfd = (pipeline_fd > class_fd) ? pipeline_fd : class_fd;
+
+    while (!atomic_load(&s_stop)) {
+        size_t class_ready = sensor_class_poll();
+        if (sensor_pipeline_poll(1) == 0 && class_ready == 0) {
+            fd_set read_fds;
+            FD_ZERO(&read_fds);
+            FD_SET(pipeline_fd, &read_fds);
+            FD_SET(class_fd, &read_fds);
+            struct timeval tv = { .tv_sec = 0, .tv_usec = BENCH_IDLE_WAIT_MS * 1000 };
+            select(maxfd + 1, &read_fds, NULL, NULL, &tv);
+        }
+        while (drain_environment(s_payload) + drain_classes(s_payload) > 0) {
+        }
+    }
+    atomic_store(&s_consumer_done, true);
+    vTaskDelete(NULL);
+}
+
+static uint32_t metric_by_name(const char *name)
+{
+    for (const metric_t *metric = metrics_first(); metric != NULL; metric = metrics_next(metric)) {
+        if (strcmp(metric->name, name) == 0) {
+            return metric_value(metric);
+        }
+    }
+    return 0;
+}
+
+static size_t rings_used(void)
+{
+    size_t used = 0;
+
+    for (int cls = 0; cls < SENSOR_CLASS_COUNT; cls++) {
+        spsc_ring_stats_t stats;
+        sensor_class_get_stats(cls, &stats);
+        used += stats.used;
+    }
+    return used;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --devices N          nodes in the fleet (default 48)\n"
+            "  --period-ms MS       report period of each node (default 1000)\n"
+            "  --readings N         readings per frame (default 1)\n"
+            "  --duration-ms MS     run time (default 5000)\n"
+            "  --classes MASK       bit per sensor class, 1 = environment only (default 0xf)\n"
+            "  --seed N             random walk seed (default 1)\n"
+            "  --non                send NON requests instead of CON\n"
+            "  --no-pacing          ignore the report period assigned in ACKs\n"
+            "  --max-drop PCT       fail if more than PCT %% of the readings are dropped\n"
+            "  --max-p99-us US      fail if the ingest to payload p99 exceeds US\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option options[] = {
+        { "devices", required_argument, NULL, 'd' },
+        { "period-ms", required_argument, NULL, 'p' },
+        { "readings", required_argument, NULL, 'r' },
+        { "duration-ms", required_argument, NULL, 't' },
+        { "classes", required_argument, NULL, 'c' },
+        { "seed", required_argument, NULL, 's' },
+        { "non", no_argument, NULL, 'n' },
+        { "no-pacing", no_argument, NULL, 'P' },
+        { "max-drop", required_argument, NULL, 'D' },
+        { "max-p99-us", required_argument, NULL, 'L' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 },
+    };
+    sim_fleet_config_t config = {
+        .devices = 48,
+        .period_ms = 1000,
+        .readings_per_frame = 1,
+        .duration_ms = 5000,
+        .class_mask = (1u << SENSOR_CLASS_COUNT) - 1,
+        .seed = 1,
+        .confirmable = true,
+        .obey_rate_control = true,
+    };
+    double max_drop_pct = -1.0;
+    long max_p99_us = -1;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "h", options, NULL)) != -1) {
+        switch (opt) {
+        case 'd': config.devices = strtoul(optarg, NULL, 0); break;
+        case 'p': config.period_ms = strtoul(optarg, NULL, 0); break;
+        case 'r': config.readings_per_frame = strtoul(optarg, NULL, 0); break;
+        case 't': config.duration_ms = strtoul(optarg, NULL, 0); break;
+        case 'c': config.class_mask = strtoul(optarg, NULL, 0); break;
+        case 's': config.seed = strtoul(optarg, NULL, 0); break;
+        case 'n': config.confirmable = false; break;
+        case 'P': config.obey_rate_control = false; break;
+        case 'D': max_drop_pct = strtod(optarg, NULL); break;
+        case 'L': max_p99_us = strtol(optarg, NULL, 0); break;
+        default: usage(argv[0]); return (opt == 'h') ? 0 : 2;
+        }
+    }
+    if (config.devices == 0 || config.period_ms == 0 || config.duration_ms == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (config.devices > CONFIG_SENSOR_REGISTRY_MAX_DEVICES) {
+        fprintf(stderr, "warning: %lu nodes but the device registry holds %d; the rest are refused "
+                "(build with -DCONFIG_SENSOR_REGISTRY_MAX_DEVICES=N)\n",
+                (unsigned long)config.devices, CONFIG_SENSOR_REGISTRY_MAX_DEVICES);
+    }
+
+    // Mismo orden que app_main() y el lanzamiento del border router
+    esp_vfs_eventfd_config_t eventfd_config = ESP_VFS_EVENTD_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_vfs_eventfd_register(&eventfd_config));
+    ESP_ERROR_CHECK(sensor_pipeline_init());
+    ESP_ERROR_CHECK(sensor_class_init());
+    sensor_latency_init();
+    start_thread_coap_server();
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    ESP_ERROR_CHECK(thread_coap_server_attach(esp_openthread_get_instance()));
+    esp_openthread_lock_release();
+    sim_ot_set_role(OT_DEVICE_ROLE_LEADER);
+
+    if (xTaskCreate(consumer_task, "aws_iot_task", 8192, NULL, 5, NULL) != pdPASS) {
+        fprintf(stderr, "cannot start the consumer task\n");
+        return 2;
+    }
+
+    sim_fleet_stats_t fleet;
+    int64_t start_us = esp_timer_get_time();
+    sim_fleet_run(&config, &fleet);
+    int64_t produced_us = esp_timer_get_time();
+
+    // Lo que quede en los rings cuenta como entregado si el consumidor lo vacía
+    for (int waited = 0; rings_used() > 0 && waited < BENCH_DRAIN_TIMEOUT_MS; waited += 10) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    atomic_store(&s_stop, true);
+    while (!atomic_load(&s_consumer_done)) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    int64_t end_us = esp_timer_get_time();
+
+    uint64_t consumed = atomic_load(&s_consumed);
+    uint64_t dropped = (fleet.readings > consumed) ? fleet.readings - consumed : 0;
+    double seconds = (double)(end_us - start_us) / 1e6;
+    double drop_pct = fleet.readings ? 100.0 * (double)dropped / (double)fleet.readings : 0.0;
+    metric_histogram_summary_t latency;
+    sensor_latency_summary_t queue;
+    sensor_latency_summary_t serialize;
+    metric_histogram_get(&s_ingest_to_payload, &latency);
+    sensor_latency_get(SENSOR_LATENCY_QUEUE, &queue);
+    sensor_latency_get(SENSOR_LATENCY_SERIALIZE, &serialize);
+
+    printf("===== Ingest benchmark (%s payload) =====\n", sensor_serializer_is_text() ? "JSON" : "CBOR");
+    printf("  Fleet: %lu nodes, period %lu ms, %lu readings/frame, classes 0x%lx, %s%s\n",
+           (unsigned long)config.devices, (unsigned long)config.period_ms,
+           (unsigned long)config.readings_per_frame, (unsigned long)config.class_mask,
+           config.confirmable ? "CON" : "NON", config.obey_rate_control ? ", paced" : "");
+    printf("  Offered: %llu readings in %llu frames over %.2f s (%llu refused by the stack, worst send lag %lu us)\n",
+           (unsigned long long)fleet.readings, (unsigned long long)fleet.frames,
+           (double)(produced_us - start_us) / 1e6, (unsigned long long)fleet.undelivered,
+           (unsigned long)fleet.late_us_max);
+    printf("  ACKs: %llu x 2.04, %llu x 5.03, %llu other; %llu period changes\n",
+           (unsigned long long)fleet.acked, (unsigned long long)fleet.unavailable,
+           (unsigned long long)fleet.other_codes, (unsigned long long)fleet.period_changes);
+    printf("  Delivered: %llu readings in %llu payloads (%.0f msgs/s)\n",
+           (unsigned long long)consumed, (unsigned long long)atomic_load(&s_payloads), (double)consumed / seconds);
+    printf("  Dropped: %llu readings (%.3f %%); coap.dropped %lu, coap.rejected %lu, queue.class_dropped %lu\n",
+           (unsigned long long)dropped, drop_pct, (unsigned long)metric_by_name("coap.dropped"),
+           (unsigned long)metric_by_name("coap.rejected"), (unsigned long)metric_by_name("queue.class_dropped"));
+    printf("  Ingest to payload: p50 %lu us | p99 %lu us | max %lu us\n",
+           (unsigned long)latency.p50, (unsigned long)latency.p99, (unsigned long)latency.max);
+    printf("  Queue: p99 %lu us | serialize: p99 %lu us\n",
+           (unsigned long)queue.p99_us, (unsigned long)serialize.p99_us);
+    printf("RESULT msgs_per_s=%.0f p99_us=%lu drop_pct=%.3f\n",
+           (double)consumed / seconds, (unsigned long)latency.p99, drop_pct);
+
+    int status = 0;
+    if (fleet.readings == 0) {
+        fprintf(stderr, "FAIL: the fleet sent nothing\n");
+        status = 1;
+    }
+    if (max_drop_pct >= 0.0 && drop_pct > max_drop_pct) {
+        fprintf(stderr, "FAIL: drop rate %.3f %% above %.3f %%\n", drop_pct, max_drop_pct);
+        status = 1;
+    }
+    if (max_p99_us >= 0 && latency.p99 > (uint32_t)max_p99_us) {
+        fprintf(stderr, "FAIL: p99 %lu us above %ld us\n", (unsigned long)latency.p99, max_p99_us);
+        status = 1;
+    }
+    return status;
+}
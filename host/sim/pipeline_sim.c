@@ -0,0 +1,264 @@
+// Pipeline completo en host: flota sintética -> servidor CoAP -> rings ->
+// aws_task.c real (coreMQTT, ventana QoS1, spool) -> broker MQTT local en
+// TCP plano (p. ej. mosquitto -p 1883). Sale con 77 si no hay broker, para
+// que ctest lo marque como omitido, y con 1 si se superan los umbrales.
+#include <getopt.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_openthread.h"
+#include "esp_openthread_lock.h"
+#include "esp_vfs_eventfd.h"
+#include "metrics.h"
+#include "sdkconfig.h"
+#include "sensor_class.h"
+#include "sensor_latency.h"
+#include "sensor_pipeline.h"
+#include "sim_openthread.h"
+#include "thread_coap_task.h"
+#include "wifi_onboarding.h"
+#include "fleet.h"
+
+#define SIM_EXIT_SKIP           77
+#define SIM_DRAIN_TIMEOUT_MS    10000
+
+extern void start_aws_client(void);
+
+// Certificados que EMBED_TXTFILES incrusta en el firmware; el transporte
+// del host no usa TLS, basta con que los símbolos existan
+#define SIM_EMBED_TXTFILE(name) \
+    __asm__(".section .rodata\n" \
+            ".global _binary_" name "_start\n" \
+            "_binary_" name "_start:\n" \
+            ".asciz \"\"\n" \
+            ".global _binary_" name "_end\n" \
+            "_binary_" name "_end:\n" \
+            ".previous\n")
+
+SIM_EMBED_TXTFILE("aws_root_ca_pem");
+SIM_EMBED_TXTFILE("device_crt");
+SIM_EMBED_TXTFILE("device_key");
+
+bool wifi_onboarding_is_connected(void)
+{
+    return true;
+}
+
+static const char *env_or(const char *name, const char *fallback)
+{
+    const char *value = getenv(name);
+
+    return (value != NULL && value[0] != '\0') ? value : fallback;
+}
+
+// aws_iot_task reintenta para siempre; sin broker no tiene sentido empezar
+static bool broker_reachable(const char *host, const char *port)
+{
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *list = NULL;
+    bool reachable = false;
+
+    if (getaddrinfo(host, port, &hints, &list) != 0) {
+        return false;
+    }
+    for (const struct addrinfo *ai = list; ai != NULL && !reachable; ai = ai->ai_next) {
+        int fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd >= 0) {
+            reachable = (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0);
+            close(fd);
+        }
+    }
+    freeaddrinfo(list);
+    return reachable;
+}
+
+static const metric_t *metric_find(const char *name)
+{
+    for (const metric_t *metric = metrics_first(); metric != NULL; metric = metrics_next(metric)) {
+        if (strcmp(metric->name, name) == 0) {
+            return metric;
+        }
+    }
+    return NULL;
+}
+
+static uint32_t metric_by_name(const char *name)
+{
+    const metric_t *metric = metric_find(name);
+
+    return (metric != NULL) ? metric_value(metric) : 0;
+}
+
+static size_t rings_used(void)
+{
+    size_t used = 0;
+
+    for (int cls = 0; cls < SENSOR_CLASS_COUNT; cls++) {
+        spsc_ring_stats_t stats;
+        sensor_class_get_stats(cls, &stats);
+        used += stats.used;
+    }
+    return used;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --devices N          nodes in the fleet (default 48)\n"
+            "  --period-ms MS       report period of each node (default 1000)\n"
+            "  --readings N         readings per frame (default 1)\n"
+            "  --duration-ms MS     run time (default 10000)\n"
+            "  --classes MASK       bit per sensor class, 1 = environment only (default 0xf)\n"
+            "  --seed N             random walk seed (default 1)\n"
+            "  --non                send NON requests instead of CON\n"
+            "  --no-pacing          ignore the report period assigned in ACKs\n"
+            "  --max-drop PCT       fail if the border router drops more than PCT %% of the readings\n"
+            "  --max-p99-us US      fail if the CoAP to PUBACK p99 exceeds US\n"
+            "Broker: SIM_BROKER_HOST / SIM_BROKER_PORT (default 127.0.0.1:1883)\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option options[] = {
+        { "devices", required_argument, NULL, 'd' },
+        { "period-ms", required_argument, NULL, 'p' },
+        { "readings", required_argument, NULL, 'r' },
+        { "duration-ms", required_argument, NULL, 't' },
+        { "classes", required_argument, NULL, 'c' },
+        { "seed", required_argument, NULL, 's' },
+        { "non", no_argument, NULL, 'n' },
+        { "no-pacing", no_argument, NULL, 'P' },
+        { "max-drop", required_argument, NULL, 'D' },
+        { "max-p99-us", required_argument, NULL, 'L' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 },
+    };
+    sim_fleet_config_t config = {
+        .devices = 48,
+        .period_ms = 1000,
+        .readings_per_frame = 1,
+        .duration_ms = 10000,
+        .class_mask = (1u << SENSOR_CLASS_COUNT) - 1,
+        .seed = 1,
+        .confirmable = true,
+        .obey_rate_control = true,
+    };
+    double max_drop_pct = -1.0;
+    long max_p99_us = -1;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "h", options, NULL)) != -1) {
+        switch (opt) {
+        case 'd': config.devices = strtoul(optarg, NULL, 0); break;
+        case 'p': config.period_ms = strtoul(optarg, NULL, 0); break;
+        case 'r': config.readings_per_frame = strtoul(optarg, NULL, 0); break;
+        case 't': config.duration_ms = strtoul(optarg, NULL, 0); break;
+        case 'c': config.class_mask = strtoul(optarg, NULL, 0); break;
+        case 's': config.seed = strtoul(optarg, NULL, 0); break;
+        case 'n': config.confirmable = false; break;
+        case 'P': config.obey_rate_control = false; break;
+        case 'D': max_drop_pct = strtod(optarg, NULL); break;
+        case 'L': max_p99_us = strtol(optarg, NULL, 0); break;
+        default: usage(argv[0]); return (opt == 'h') ? 0 : 2;
+        }
+    }
+    if (config.devices == 0 || config.period_ms == 0 || config.duration_ms == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    const char *host = env_or("SIM_BROKER_HOST", "127.0.0.1");
+    const char *port = env_or("SIM_BROKER_PORT", "1883");
+    if (!broker_reachable(host, port)) {
+        fprintf(stderr, "no MQTT broker at %s:%s, skipping (start one with: mosquitto -p %s)\n", host, port, port);
+        return SIM_EXIT_SKIP;
+    }
+
+    // Mismo orden que app_main() y el lanzamiento del border router
+    esp_vfs_eventfd_config_t eventfd_config = ESP_VFS_EVENTD_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_vfs_eventfd_register(&eventfd_config));
+    ESP_ERROR_CHECK(sensor_pipeline_init());
+    ESP_ERROR_CHECK(sensor_class_init());
+    start_thread_coap_server();
+    start_aws_client();
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    ESP_ERROR_CHECK(thread_coap_server_attach(esp_openthread_get_instance()));
+    esp_openthread_lock_release();
+
+    // La flota empieza cuando aws_iot_task ya está conectado
+    for (int waited = 0; metric_by_name("tls.connects") == 0; waited += 10) {
+        if (waited >= 10000) {
+            fprintf(stderr, "aws_iot_task did not connect to %s:%s\n", host, port);
+            return 1;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    sim_ot_set_role(OT_DEVICE_ROLE_LEADER);
+
+    sim_fleet_stats_t fleet;
+    int64_t start_us = esp_timer_get_time();
+    sim_fleet_run(&config, &fleet);
+    int64_t produced_us = esp_timer_get_time();
+
+    // Esperar a que se vacíen los rings y lleguen los PUBACK pendientes
+    for (int waited = 0; waited < SIM_DRAIN_TIMEOUT_MS; waited += 10) {
+        if (rings_used() == 0 && metric_by_name("mqtt.inflight") == 0) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    int64_t end_us = esp_timer_get_time();
+
+    double seconds = (double)(end_us - start_us) / 1e6;
+    uint32_t dropped = metric_by_name("coap.dropped");
+    double drop_pct = fleet.readings ? 100.0 * dropped / (double)fleet.readings : 0.0;
+    uint32_t pubacks = metric_by_name("mqtt.pubacks");
+    sensor_latency_summary_t e2e;
+    sensor_latency_get(SENSOR_LATENCY_END_TO_END, &e2e);
+
+    printf("===== Pipeline simulation (broker %s:%s) =====\n", host, port);
+    printf("  Fleet: %lu nodes, period %lu ms, %lu readings/frame, classes 0x%lx, %s%s\n",
+           (unsigned long)config.devices, (unsigned long)config.period_ms,
+           (unsigned long)config.readings_per_frame, (unsigned long)config.class_mask,
+           config.confirmable ? "CON" : "NON", config.obey_rate_control ? ", paced" : "");
+    printf("  Offered: %llu readings in %llu frames over %.2f s; ACKs %llu x 2.04, %llu x 5.03\n",
+           (unsigned long long)fleet.readings, (unsigned long long)fleet.frames,
+           (double)(produced_us - start_us) / 1e6, (unsigned long long)fleet.acked,
+           (unsigned long long)fleet.unavailable);
+    printf("  MQTT: %lu published, %lu PUBACKs (%.0f msgs/s), %lu readings, %lu bytes, %lu retransmits, "
+           "%lu reconnects, %lu still in flight\n",
+           (unsigned long)metric_by_name("mqtt.published"), (unsigned long)pubacks, pubacks / seconds,
+           (unsigned long)metric_by_name("mqtt.readings"), (unsigned long)metric_by_name("mqtt.bytes"),
+           (unsigned long)metric_by_name("mqtt.retransmits"), (unsigned long)metric_by_name("mqtt.reconnects"),
+           (unsigned long)metric_by_name("mqtt.inflight"));
+    printf("  Dropped at the border router: %lu readings (%.3f %%); coap.rejected %lu frames, queue.class_dropped %lu\n",
+           (unsigned long)dropped, drop_pct, (unsigned long)metric_by_name("coap.rejected"),
+           (unsigned long)metric_by_name("queue.class_dropped"));
+    printf("  CoAP to PUBACK: p50 %lu us | p99 %lu us | max %lu us (%lu payloads)\n",
+           (unsigned long)e2e.p50_us, (unsigned long)e2e.p99_us, (unsigned long)e2e.max_us,
+           (unsigned long)e2e.count);
+    printf("RESULT msgs_per_s=%.0f p99_us=%lu drop_pct=%.3f\n", pubacks / seconds, (unsigned long)e2e.p99_us,
+           drop_pct);
+
+    int status = 0;
+    if (pubacks == 0) {
+        fprintf(stderr, "FAIL: no PUBACK received\n");
+        status = 1;
+    }
+    if (max_drop_pct >= 0.0 && drop_pct > max_drop_pct) {
+        fprintf(stderr, "FAIL: drop rate %.3f %% above %.3f %%\n", drop_pct, max_drop_pct);
+        status = 1;
+    }
+    if (max_p99_us >= 0 && e2e.p99_us > (uint32_t)max_p99_us) {
+        fprintf(stderr, "FAIL: p99 %lu us above %ld us\n", (unsigned long)e2e.p99_us, max_p99_us);
+        status = 1;
+    }
+    return status;
+}
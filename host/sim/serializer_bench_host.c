@@ -0,0 +1,71 @@
+// Microbenchmark del codificador de lecturas en host: la misma comparación
+// que "serbench" en la consola del border router (serializer_bench.c), con
+// más iteraciones. Sale con 1 si las salidas JSON difieren en más lecturas
+// de las permitidas por --max-mismatch-pct o si no hay mejora de --min-speedup.
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "sensor_serializer.h"
+#include "serializer_bench.h"
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --iterations N        readings encoded by each encoder (default 200000)\n"
+            "  --max-mismatch-pct P  fail if more than P %% of the JSON outputs differ\n"
+            "  --min-speedup X       fail if the serializer is not X times faster than snprintf\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option options[] = {
+        { "iterations", required_argument, NULL, 'i' },
+        { "max-mismatch-pct", required_argument, NULL, 'M' },
+        { "min-speedup", required_argument, NULL, 'S' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 },
+    };
+    uint32_t iterations = 200000;
+    double max_mismatch_pct = -1.0;
+    double min_speedup = -1.0;
+    serializer_bench_result_t result;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "h", options, NULL)) != -1) {
+        switch (opt) {
+        case 'i': iterations = strtoul(optarg, NULL, 0); break;
+        case 'M': max_mismatch_pct = strtod(optarg, NULL); break;
+        case 'S': min_speedup = strtod(optarg, NULL); break;
+        default: usage(argv[0]); return (opt == 'h') ? 0 : 2;
+        }
+    }
+    if (!serializer_bench_run(iterations, &result)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    double speedup = result.serializer_ns ? (double)result.snprintf_ns / (double)result.serializer_ns : 0.0;
+    double mismatch_pct = 100.0 * (double)result.mismatches / (double)result.iterations;
+
+    printf("===== Serializer benchmark (%s payload, %lu readings) =====\n",
+           sensor_serializer_is_text() ? "JSON" : "CBOR", (unsigned long)result.iterations);
+    printf("  snprintf(\"%s\"): %lu ns per reading\n", result.integer_split ? "%lu.%02lu" : "%.2f",
+           (unsigned long)result.snprintf_ns);
+    printf("  sensor_serializer_encode(): %lu ns per reading\n", (unsigned long)result.serializer_ns);
+    printf("  Output mismatches: %lu (%.4f %%)\n", (unsigned long)result.mismatches, mismatch_pct);
+    printf("RESULT snprintf_ns=%lu serializer_ns=%lu speedup=%.2f mismatch_pct=%.4f\n",
+           (unsigned long)result.snprintf_ns, (unsigned long)result.serializer_ns, speedup, mismatch_pct);
+
+    int status = 0;
+    if (max_mismatch_pct >= 0.0 && mismatch_pct > max_mismatch_pct) {
+        fprintf(stderr, "FAIL: %.4f %% of the outputs differ, above %.4f %%\n", mismatch_pct, max_mismatch_pct);
+        status = 1;
+    }
+    if (min_speedup >= 0.0 && speedup < min_speedup) {
+        fprintf(stderr, "FAIL: speedup %.2f below %.2f\n", speedup, min_speedup);
+        status = 1;
+    }
+    return status;
+}
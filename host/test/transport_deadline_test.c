@@ -0,0 +1,172 @@
+// Tests unitarios de transport_deadline.c: reparto de segundos y
+// microsegundos para select(), plazos vencidos, atajo sin select() con datos
+// descifrados en mbedTLS y esperas reales sobre un socketpair. Sale con 1 si
+// falla alguna comprobación.
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "esp_timer.h"
+#include "transport_deadline.h"
+
+// Margen para el planificador del host al medir esperas
+#define SLACK_US    (200 * 1000)
+
+static int s_failures;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            s_failures++;                                                   \
+        }                                                                   \
+    } while (0)
+
+static int64_t timeval_us(const struct timeval *tv)
+{
+    return (int64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+}
+
+static void test_split(void)
+{
+    static const uint32_t timeouts_ms[] = { 1, 999, 1000, 2500, 10000, 65535 };
+    struct timeval tv;
+
+    for (size_t i = 0; i < sizeof(timeouts_ms) / sizeof(timeouts_ms[0]); i++) {
+        int64_t timeout_us = (int64_t)timeouts_ms[i] * 1000;
+
+        CHECK(xTransportTimeLeft(xTransportDeadline(timeouts_ms[i]), &tv));
+        CHECK(tv.tv_usec >= 0 && tv.tv_usec < 1000000);
+        CHECK(timeval_us(&tv) <= timeout_us);
+        CHECK(timeval_us(&tv) > timeout_us - SLACK_US);
+    }
+}
+
+static void test_expired(void)
+{
+    struct timeval tv = { .tv_sec = 5, .tv_usec = 5 };
+
+    CHECK(!xTransportTimeLeft(xTransportDeadline(0), &tv));
+    CHECK(tv.tv_sec == 0 && tv.tv_usec == 0);
+    CHECK(!xTransportTimeLeft(esp_timer_get_time() - 1000000, NULL));
+}
+
+static void test_countdown(void)
+{
+    int64_t deadline = xTransportDeadline(100);
+    struct timeval before;
+    struct timeval after;
+
+    CHECK(xTransportTimeLeft(deadline, &before));
+    usleep(20 * 1000);
+    CHECK(xTransportTimeLeft(deadline, &after));
+    CHECK(timeval_us(&after) <= timeval_us(&before) - 20 * 1000);
+    usleep(100 * 1000);
+    CHECK(!xTransportTimeLeft(deadline, NULL));
+}
+
+// Espera sin datos: vence en el plazo, no antes, y el plazo de más de un
+// segundo no acaba en EINVAL
+static void test_wait_timeout(int fd, uint32_t timeout_ms)
+{
+    int64_t start = esp_timer_get_time();
+    int result = lTransportWait(fd, false, 0, xTransportDeadline(timeout_ms));
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    CHECK(result == 0);
+    CHECK(elapsed >= (int64_t)timeout_ms * 1000);
+    CHECK(elapsed < (int64_t)timeout_ms * 1000 + SLACK_US);
+}
+
+static void test_wait_fast_paths(int fd, int peer)
+{
+    int64_t start = esp_timer_get_time();
+
+    // Datos ya descifrados: listo sin mirar el socket, que está vacío
+    CHECK(lTransportWait(fd, false, 16, xTransportDeadline(1000)) == 1);
+    // Plazo vencido (timeout 0): no se espera ni se consulta select()
+    CHECK(lTransportWait(fd, false, 0, xTransportDeadline(0)) == 0);
+    CHECK(esp_timer_get_time() - start < SLACK_US);
+
+    CHECK(write(peer, "x", 1) == 1);
+    CHECK(lTransportWait(fd, false, 0, xTransportDeadline(1000)) == 1);
+    char byte;
+    CHECK(read(fd, &byte, 1) == 1);
+}
+
+// Los datos descifrados no sirven para escribir: con el buffer de envío
+// lleno se espera al plazo
+static void test_wait_write_full(void)
+{
+    static char chunk[4096];
+    int fds[2];
+
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    CHECK(lTransportWait(fds[0], true, 0, xTransportDeadline(1000)) == 1);
+    while (write(fds[0], chunk, sizeof(chunk)) > 0) {
+    }
+    CHECK(lTransportWait(fds[0], true, 16, xTransportDeadline(50)) == 0);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+static void *late_writer(void *arg)
+{
+    usleep(300 * 1000);
+    (void)!write(*(int *)arg, "y", 1);
+    return NULL;
+}
+
+// Un dato que llega a mitad de espera la termina antes del plazo
+static void test_wait_wakeup(int fd, int peer)
+{
+    pthread_t thread;
+    int64_t start = esp_timer_get_time();
+
+    pthread_create(&thread, NULL, late_writer, &peer);
+    CHECK(lTransportWait(fd, false, 0, xTransportDeadline(5000)) == 1);
+    CHECK(esp_timer_get_time() - start < 300 * 1000 + SLACK_US);
+    pthread_join(thread, NULL);
+}
+
+static void test_wait_error(void)
+{
+    int fds[2];
+
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    close(fds[0]);
+    close(fds[1]);
+    CHECK(lTransportWait(fds[0], false, 0, xTransportDeadline(100)) == -1);
+}
+
+int main(void)
+{
+    int fds[2];
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        perror("socketpair");
+        return 2;
+    }
+
+    test_split();
+    test_expired();
+    test_countdown();
+    test_wait_timeout(fds[0], 50);
+    test_wait_timeout(fds[0], 1200);
+    test_wait_fast_paths(fds[0], fds[1]);
+    test_wait_write_full();
+    test_wait_wakeup(fds[0], fds[1]);
+    test_wait_error();
+
+    close(fds[0]);
+    close(fds[1]);
+
+    if (s_failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", s_failures);
+        return 1;
+    }
+    printf("transport_deadline: all checks passed\n");
+    return 0;
+}
@@ -20,8 +20,9 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_partition.h"
-#include "freertos/queue.h"
-#include "shared_data.h"
+#include "sensor_class.h"
+#include "sensor_pipeline.h"
+#include "thread_coap_task.h"
 #include "wifi_onboarding/wifi_onboarding.h"
 #include "border_router_launch.h"
 #include "wifi_reset_cmd.h"
@@ -29,12 +30,8 @@
 
 #define TAG "esp_ot_br"
 
-// Global AWS queue definition
-QueueHandle_t g_aws_queue = NULL;
-
 // Declaración de funciones externas
 extern void start_aws_client(void);
-extern void start_thread_coap_server(void);
 
 
 static esp_err_t init_spiffs(void)
@@ -57,7 +54,8 @@ void app_main(void)
     // * border router
     // * discovery delegate (WiFi)
     // * additional WiFi events
-    size_t max_eventfd = 6;
+    // * sensor pipeline (AWS task select loop)
+    size_t max_eventfd = 7;
     esp_vfs_eventfd_config_t eventfd_config = {
         .max_fds = max_eventfd,
     };
@@ -68,13 +66,17 @@ void app_main(void)
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
 
-    // Create AWS queue for sensor data before starting tasks
-    g_aws_queue = xQueueCreate(10, sizeof(sensor_data_t));
-    if (g_aws_queue == NULL) {
-        ESP_LOGE(TAG, "Failed to create AWS queue");
+    // Create the sensor pipeline (CoAP -> AWS) before starting tasks
+    if (sensor_pipeline_init() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create sensor pipeline");
+        abort();
+    }
+    if (sensor_class_init() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create sensor class queues");
         abort();
     }
-    ESP_LOGI(TAG, "AWS queue created successfully (capacity: 10)");
+    ESP_LOGI(TAG, "Task placement: OpenThread core %d, cloud core %d, services core %d (-1 = any)",
+             CONFIG_TASK_CORE_OPENTHREAD, CONFIG_TASK_CORE_CLOUD, CONFIG_TASK_CORE_SERVICES);
 
     // ========== WiFi Onboarding Logic ==========
     if (!wifi_onboarding_has_credentials()) {
@@ -109,8 +111,9 @@ void app_main(void)
     ESP_ERROR_CHECK(mdns_init());
     ESP_ERROR_CHECK(mdns_hostname_set("esp-ot-br"));
 
-    // Start CoAP server for receiving Thread sensor data
-    ESP_LOGI(TAG, "Starting Thread CoAP server...");
+    // Prepare the CoAP server for Thread sensor data; it comes up from the
+    // OpenThread state callback as soon as the border router attaches
+    ESP_LOGI(TAG, "Preparing Thread CoAP server...");
     start_thread_coap_server();
 
     // Start AWS IoT client for cloud publishing
@@ -1,15 +1,26 @@
 #include <stdio.h>
 #include <string.h>
+#include <sys/select.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
 #include "esp_log.h"
+#include "esp_system.h"
 #include "esp_random.h"
 #include "core_mqtt.h"
 #include "network_transport.h"
 #include "clock.h"
 #include "backoff_algorithm.h"
-#include "shared_data.h"
+#include "sdkconfig.h"
+#include "device_registry.h"
+#include "metrics.h"
+#include "sensor_aggregate.h"
+#include "sensor_class.h"
+#include "sensor_deadband.h"
+#include "sensor_latency.h"
+#include "sensor_pipeline.h"
+#include "sensor_serializer.h"
+#include "sensor_spool.h"
+#include "task_placement.h"
 #include "wifi_onboarding.h"
 
 // *** IMPORTANTE: Configura estos valores para tu cuenta AWS ***
@@ -31,6 +42,8 @@
 #define AWS_IOT_ENDPOINT    "a216nupm45ewkv-ats.iot.us-east-2.amazonaws.com"
 #define AWS_IOT_THING_NAME  "esp32_thread_border_router"
 #define MQTT_TOPIC          "thread/sensores"
+#define MQTT_TOPIC_SUMMARY  "thread/sensores/resumen"
+#define MQTT_TOPIC_METRICS  "thread/br/metrics"
 #define MQTT_PORT           8883
 
 static const char *TAG = "AWS_TASK";
@@ -48,13 +61,156 @@ static MQTTContext_t mqttContext;
 static NetworkContext_t networkContext;
 static uint8_t networkBuffer[2048];
 static MQTTFixedBuffer_t mqttBuffer;
+// Si el último CONNACK recuperó la sesión persistente
+static bool s_session_present;
 
-// Buffers para QoS1/QoS2 (requeridos para publish con acknowledgement)
-#define OUTGOING_PUBLISH_RECORD_COUNT 10
+// Los vectores de cada paquete MQTT (cabecera, tópico, packet ID, payload)
+// se juntan aquí para salir en un solo registro TLS
+#define MQTT_WRITEV_BUFFER_SIZE CONFIG_MQTT_WRITEV_BUFFER_SIZE
+#if MQTT_WRITEV_BUFFER_SIZE > 0
+static uint8_t s_writev_buffer[MQTT_WRITEV_BUFFER_SIZE];
+#endif
+
+// Lotes de lecturas: hasta SENSOR_BATCH_MAX_READINGS por publicación, esperando
+// como mucho SENSOR_BATCH_LINGER_MS a que el lote se llene
+#define SENSOR_BATCH_MAX_READINGS   CONFIG_SENSOR_BATCH_MAX_READINGS
+#define SENSOR_BATCH_LINGER_MS      CONFIG_SENSOR_BATCH_LINGER_MS
+#define SENSOR_READING_MAX_JSON     128  // también cota superior para CBOR
+static sensor_data_t *s_batch[SENSOR_BATCH_MAX_READINGS];
+
+// Agregación por dispositivo y filtro de banda muerta: cada lote se separa
+// en lecturas que se acumulan (s_batch_agg[i] != NULL), lecturas sin cambios
+// que se descartan y lecturas que se publican tal cual (s_kept, con su
+// posición en el lote en s_kept_pos). s_batch_checked marca las que pasaron
+// por la banda muerta.
+#define SENSOR_SUMMARY_MAX_JSON     384
+static sensor_aggregate_entry_t *s_batch_agg[SENSOR_BATCH_MAX_READINGS];
+static bool s_batch_checked[SENSOR_BATCH_MAX_READINGS];
+static sensor_data_t *s_kept[SENSOR_BATCH_MAX_READINGS];
+static size_t s_kept_pos[SENSOR_BATCH_MAX_READINGS];
+
+// Reenvío desde el spool de flash: lotes acotados y espaciados para no quitar
+// ancho de banda a las lecturas en vivo
+#define SENSOR_SPOOL_REPLAY_BATCH       CONFIG_SENSOR_SPOOL_REPLAY_BATCH
+#define SENSOR_SPOOL_REPLAY_INTERVAL_MS CONFIG_SENSOR_SPOOL_REPLAY_INTERVAL_MS
+static sensor_data_t s_replay[SENSOR_SPOOL_REPLAY_BATCH];
+static sensor_data_t *s_replay_batch[SENSOR_SPOOL_REPLAY_BATCH];
+static bool s_spool_ready = false;
+
+#define SENSOR_PAYLOAD_MAX_READINGS \
+    ((SENSOR_BATCH_MAX_READINGS > SENSOR_SPOOL_REPLAY_BATCH) ? SENSOR_BATCH_MAX_READINGS : SENSOR_SPOOL_REPLAY_BATCH)
+#define SENSOR_PAYLOAD_MAX_SIZE \
+    ((SENSOR_PAYLOAD_MAX_READINGS * SENSOR_READING_MAX_JSON > SENSOR_SUMMARY_MAX_JSON) ? \
+     SENSOR_PAYLOAD_MAX_READINGS * SENSOR_READING_MAX_JSON : SENSOR_SUMMARY_MAX_JSON)
+
+// Lecturas de las clases tipadas (sensor_class.h): cada publicación lleva
+// lecturas consecutivas de un mismo dispositivo, en el tópico de su clase
+#define SENSOR_TOPIC_MAX        64
+static void *s_records[SENSOR_BATCH_MAX_READINGS];
+
+// Resúmenes por publicación: los que caben en el payload de una entrada
+#define SENSOR_SUMMARY_BATCH    (SENSOR_PAYLOAD_MAX_SIZE / SENSOR_SUMMARY_MAX_JSON)
+static sensor_summary_t s_summaries[SENSOR_SUMMARY_BATCH];
+
+// Ventana de publicaciones QoS1 en vuelo: se publican lotes sin esperar al
+// PUBACK del anterior, hasta MQTT_PUBLISH_WINDOW a la vez. Cada entrada guarda
+// su payload hasta recibir el PUBACK para poder retransmitirlo.
+#define MQTT_PUBLISH_WINDOW     CONFIG_MQTT_PUBLISH_WINDOW
+#define MQTT_PUBACK_TIMEOUT_MS  CONFIG_MQTT_PUBACK_TIMEOUT_MS
+
+typedef struct {
+    uint16_t packet_id;  // 0 = entrada libre (MQTT nunca usa el ID 0)
+    uint16_t retries;
+    uint32_t sent_ms;
+    uint32_t first_sent_us;  // primer MQTT_Publish, para la latencia del PUBACK
+    uint32_t ingest_us;      // llegada de la lectura más antigua (0 = desconocida)
+    size_t readings;
+    size_t spooled;          // lecturas del spool: se consumen con el PUBACK
+    uint32_t spool_first;    // posición en el spool de la primera
+    size_t len;
+    char topic[SENSOR_TOPIC_MAX];
+    uint8_t payload[SENSOR_PAYLOAD_MAX_SIZE + 2];
+} inflight_publish_t;
+
+static inflight_publish_t s_inflight[MQTT_PUBLISH_WINDOW];
+static uint32_t s_inflight_count = 0;
+
+// Instantánea del registro de métricas cada SENSOR_METRICS_REPORT_MS en
+// MQTT_TOPIC_METRICS (QoS0, no ocupa la ventana)
+#define SENSOR_METRICS_REPORT_MS    CONFIG_SENSOR_METRICS_REPORT_MS
+static char s_metrics_payload[2048];
+
+// Pausa entre rondas de reconexión cuando se agotan los reintentos
+#define AWS_RECONNECT_PAUSE_MS 32000
+
+// Bucle de E/S: la tarea duerme en select() sobre el socket TLS y el eventfd
+// del pipeline. Sin eventos despierta cada MQTT_IO_IDLE_MS para keep-alive y
+// retransmisiones. Durante la conexión se usa el timeout de recepción normal;
+// conectado, la recepción no bloquea porque solo se lee con datos presentes.
+#define MQTT_IO_IDLE_MS         1000
+// Espera máxima entre pasos de la conexión TLS asíncrona
+#define TLS_CONNECT_POLL_MS     100
+#define MQTT_CONNECT_RECV_MS    2000
+
+// Métricas de MQTT y TLS (metrics.h). Los histogramas solo los escribe esta tarea.
+static metric_histogram_t s_msg_size_storage;
+static metric_histogram_t s_handshake_storage;
+static metric_histogram_t s_resume_storage;
+static metric_t s_metric_published = METRIC_COUNTER_INIT("mqtt.published");
+static metric_t s_metric_readings = METRIC_COUNTER_INIT("mqtt.readings");
+static metric_t s_metric_bytes = METRIC_COUNTER_INIT("mqtt.bytes");
+static metric_t s_metric_msg_size = METRIC_HISTOGRAM_INIT("mqtt.msg_size", &s_msg_size_storage);
+static metric_t s_metric_pubacks = METRIC_COUNTER_INIT("mqtt.pubacks");
+static metric_t s_metric_retransmits = METRIC_COUNTER_INIT("mqtt.retransmits");
+static metric_t s_metric_publish_errors = METRIC_COUNTER_INIT("mqtt.publish_errors");
+static metric_t s_metric_reconnects = METRIC_COUNTER_INIT("mqtt.reconnects");
+static metric_t s_metric_inflight = METRIC_GAUGE_INIT("mqtt.inflight");
+static metric_t s_metric_inflight_max = METRIC_GAUGE_INIT("mqtt.inflight_max");
+static metric_t s_metric_tls_connects = METRIC_COUNTER_INIT("tls.connects");
+static metric_t s_metric_tls_failures = METRIC_COUNTER_INIT("tls.failures");
+// Conexiones con handshake completo y conexiones que ofrecieron una sesión
+// guardada (reanudación), por separado para comparar sus tiempos
+static metric_t s_metric_tls_handshake = METRIC_HISTOGRAM_INIT("tls.handshake_ms", &s_handshake_storage);
+static metric_t s_metric_tls_resume = METRIC_HISTOGRAM_INIT("tls.resume_ms", &s_resume_storage);
+
+// Régimen estable sin heap: pila, TCB y mutex TLS estáticos, y el camino
+// ingesta -> cola -> serialización -> publicación solo usa buffers fijos.
+// Tras SENSOR_HEAP_WARMUP_PUBACKS PUBACKs desde la última conexión se toma
+// sys.heap_min como referencia; si vuelve a bajar, algo reserva memoria por
+// mensaje y la caída queda en sys.heap_steady_loss. Las reservas de esp-tls
+// al conectar quedan fuera: cada reconexión vuelve a calentar.
+#define AWS_TASK_STACK_SIZE         8192
+#define SENSOR_HEAP_WARMUP_PUBACKS  CONFIG_SENSOR_HEAP_WARMUP_PUBACKS
+static StackType_t s_task_stack[AWS_TASK_STACK_SIZE];
+static StaticTask_t s_task_tcb;
+static StaticSemaphore_t s_tls_mutex;
+static uint32_t s_heap_warmup_start;  // mqtt.pubacks al conectar
+static uint32_t s_heap_baseline;      // 0 = calentando
+static metric_t s_metric_heap_loss = METRIC_GAUGE_INIT("sys.heap_steady_loss");
+
+// Buffers para QoS1/QoS2 (requeridos para publish con acknowledgement).
+// Un registro saliente por cada publicación que puede estar en vuelo.
+#define OUTGOING_PUBLISH_RECORD_COUNT MQTT_PUBLISH_WINDOW
 #define INCOMING_PUBLISH_RECORD_COUNT 10
 static MQTTPubAckInfo_t outgoingPublishRecords[OUTGOING_PUBLISH_RECORD_COUNT];
 static MQTTPubAckInfo_t incomingPublishRecords[INCOMING_PUBLISH_RECORD_COUNT];
 
+static inflight_publish_t *inflight_find(uint16_t packet_id)
+{
+    for (size_t i = 0; i < MQTT_PUBLISH_WINDOW; i++) {
+        if (s_inflight[i].packet_id == packet_id) {
+            return &s_inflight[i];
+        }
+    }
+    return NULL;
+}
+
+// Hueco libre de la ventana, o NULL si está llena
+static inline inflight_publish_t *inflight_acquire(void)
+{
+    return inflight_find(0);
+}
+
 // Callback de eventos MQTT
 static void mqtt_event_callback(MQTTContext_t *pMqttContext,
                                  MQTTPacketInfo_t *pPacketInfo,
@@ -66,9 +222,32 @@ static void mqtt_event_callback(MQTTContext_t *pMqttContext,
         case MQTT_PACKET_TYPE_CONNACK:
             ESP_LOGI(TAG, "CONNACK received");
             break;
-        case MQTT_PACKET_TYPE_PUBACK:
-            ESP_LOGI(TAG, "PUBACK received for packet ID: %u", packetIdentifier);
+        case MQTT_PACKET_TYPE_PUBACK: {
+            // Liberar la entrada de la ventana para el siguiente lote
+            inflight_publish_t *entry = inflight_find(packetIdentifier);
+            if (entry != NULL && packetIdentifier != 0) {
+                uint32_t now_us = sensor_latency_now_us();
+                ESP_LOGD(TAG, "PUBACK received for packet ID: %u (%lu ms)", packetIdentifier,
+                         (unsigned long)(Clock_GetTimeMs() - entry->sent_ms));
+                sensor_latency_record(SENSOR_LATENCY_PUBACK, now_us - entry->first_sent_us);
+                if (entry->ingest_us != 0) {
+                    sensor_latency_record(SENSOR_LATENCY_END_TO_END, now_us - entry->ingest_us);
+                }
+                if (entry->spooled > 0) {
+                    // Solo ahora dejan de estar pendientes en flash: sin PUBACK
+                    // (reinicio, sesión perdida) se vuelven a reenviar
+                    sensor_spool_consume(entry->spool_first, entry->spooled);
+                    entry->spooled = 0;
+                }
+                entry->packet_id = 0;
+                s_inflight_count--;
+                metric_set(&s_metric_inflight, s_inflight_count);
+                metric_inc(&s_metric_pubacks);
+            } else {
+                ESP_LOGW(TAG, "PUBACK for unknown packet ID: %u", packetIdentifier);
+            }
             break;
+        }
         case MQTT_PACKET_TYPE_PINGRESP:
             ESP_LOGD(TAG, "PINGRESP received (keep-alive)");
             break;
@@ -94,9 +273,13 @@ static bool initialize_network_context(void)
     networkContext.xPort = MQTT_PORT;
     networkContext.disableSni = false;  // SNI es requerido por AWS IoT
     networkContext.pAlpnProtos = NULL;   // Solo necesario para puerto 443
+#if MQTT_WRITEV_BUFFER_SIZE > 0
+    networkContext.pucWritevBuffer = s_writev_buffer;
+    networkContext.uxWritevBufferSize = sizeof(s_writev_buffer);
+#endif
 
     // Crear semáforo para contexto TLS
-    networkContext.xTlsContextSemaphore = xSemaphoreCreateMutex();
+    networkContext.xTlsContextSemaphore = xSemaphoreCreateMutexStatic(&s_tls_mutex);
     if (networkContext.xTlsContextSemaphore == NULL) {
         ESP_LOGE(TAG, "Failed to create TLS context semaphore");
         return false;
@@ -106,23 +289,10 @@ static bool initialize_network_context(void)
     return true;
 }
 
-// Función para conectar TLS
-static bool connect_tls(void)
-{
-    ESP_LOGI(TAG, "Connecting to AWS IoT endpoint: %s:%d", AWS_IOT_ENDPOINT, MQTT_PORT);
-
-    TlsTransportStatus_t tlsStatus = xTlsConnect(&networkContext);
-
-    if (tlsStatus != TLS_TRANSPORT_SUCCESS) {
-        ESP_LOGE(TAG, "TLS connection failed with status: %d", tlsStatus);
-        return false;
-    }
-
-    ESP_LOGI(TAG, "TLS connection established successfully");
-    return true;
-}
-
-// Función para inicializar MQTT
+// Función para inicializar MQTT (solo una vez). Al reconectar basta con
+// MQTT_Connect: volver a llamar a MQTT_Init reiniciaría el contador de packet
+// IDs y borraría los registros QoS1, y una publicación nueva podría llevar el
+// ID de otra que sigue en la ventana esperando su PUBACK.
 static bool initialize_mqtt(void)
 {
     ESP_LOGI(TAG, "Initializing MQTT context...");
@@ -136,7 +306,7 @@ static bool initialize_mqtt(void)
     transport.pNetworkContext = &networkContext;
     transport.send = espTlsTransportSend;
     transport.recv = espTlsTransportRecv;
-    transport.writev = NULL;
+    transport.writev = espTlsTransportWritev;
 
     MQTTStatus_t mqttStatus = MQTT_Init(&mqttContext,
                                          &transport,
@@ -194,11 +364,171 @@ static bool connect_mqtt(void)
         return false;
     }
 
+    s_session_present = sessionPresent;
     ESP_LOGI(TAG, "Connected to AWS IoT Core successfully!");
     ESP_LOGI(TAG, "Session present: %s", sessionPresent ? "YES" : "NO");
     return true;
 }
 
+// Guarda lecturas en el spool de flash; false si no hay spool o falla la escritura
+static bool spool_readings(sensor_data_t *const *readings, size_t count)
+{
+    if (!s_spool_ready || sensor_spool_append(readings, count) != ESP_OK) {
+        return false;
+    }
+    ESP_LOGI(TAG, "%u reading(s) spooled to flash (pending: %u)",
+             (unsigned)count, (unsigned)sensor_spool_pending());
+    return true;
+}
+
+// Separa las count lecturas de s_batch: las de dispositivos agregados quedan
+// apuntadas en s_batch_agg, las que no superan la banda muerta se descartan y
+// el resto va a s_kept. Todavía no se acumula nada y la banda muerta solo
+// evalúa: lo confirma absorb_batch().
+static size_t split_batch(size_t count)
+{
+    uint32_t now = Clock_GetTimeMs();
+    size_t kept = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        s_batch_agg[i] = sensor_aggregate_lookup(s_batch[i], now);
+        s_batch_checked[i] = (s_batch_agg[i] == NULL);
+        if (s_batch_checked[i] && sensor_deadband_check(s_batch[i], now)) {
+            s_kept[kept] = s_batch[i];
+            s_kept_pos[kept] = i;
+            kept++;
+        }
+    }
+    return kept;
+}
+
+// Acumula las lecturas agregadas de las primeras count posiciones del lote,
+// cuenta las que salen en crudo y confirma la banda muerta de esas mismas,
+// justo antes de devolverlas al ring: así una lectura que se queda en el
+// ring para el siguiente lote no se cuenta dos veces ni deja movida la
+// referencia de su dispositivo. Con drop_last, la última posición es una
+// lectura que no cabía en el payload y se descarta: su evaluación se deshace
+// igual que las de las que se quedan.
+static void absorb_batch(size_t count, bool drop_last)
+{
+    size_t checked = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (s_batch_agg[i] != NULL) {
+            sensor_aggregate_add(s_batch_agg[i], s_batch[i]);
+        } else {
+            sensor_aggregate_count_raw(s_batch[i]);
+        }
+        checked += s_batch_checked[i];
+    }
+    sensor_deadband_commit(drop_last ? checked - 1 : checked);
+}
+
+// Desvía al spool las count lecturas tomadas del pipeline mientras no hay
+// conexión. Las agregadas siguen acumulándose; el resumen sale al reconectar.
+static void spool_batch(size_t count)
+{
+    size_t kept = split_batch(count);
+    absorb_batch(count, false);
+    if (kept > 0) {
+        spool_readings(s_kept, kept);
+    }
+    sensor_pipeline_release(count);
+}
+
+// Espera ms milisegundos sin dejar que el pipeline se desborde: lo que llega
+// mientras no hay conexión va al spool. Sin spool, las lecturas se quedan en
+// el ring como antes.
+static void spool_pipeline_for(uint32_t ms)
+{
+    TickType_t start = xTaskGetTickCount();
+    TickType_t wait = pdMS_TO_TICKS(ms);
+    TickType_t elapsed;
+
+    if (!s_spool_ready) {
+        vTaskDelay(wait);
+        return;
+    }
+
+    while ((elapsed = xTaskGetTickCount() - start) < wait) {
+        size_t count = sensor_pipeline_receive_batch(s_batch, SENSOR_BATCH_MAX_READINGS, wait - elapsed);
+        if (count > 0) {
+            spool_batch(count);
+        }
+    }
+}
+
+// Entre pasos del handshake la tarea duerme en el socket que se está
+// conectando y en el eventfd del pipeline: lo que llega mientras tanto va al
+// spool en lugar de llenar el ring
+static void wait_connect_progress(void)
+{
+    int pipeline_fd = sensor_pipeline_get_eventfd();
+    bool want_write = false;
+    int sock_fd = lTlsConnectPollFd(&networkContext, &want_write);
+    fd_set read_fds;
+    fd_set write_fds;
+    int maxfd = -1;
+
+    if (s_spool_ready) {
+        size_t count = sensor_pipeline_receive_batch(s_batch, SENSOR_BATCH_MAX_READINGS, 0);
+        if (count > 0) {
+            spool_batch(count);
+        }
+    }
+
+    FD_ZERO(&read_fds);
+    FD_ZERO(&write_fds);
+    if (sock_fd >= 0) {
+        FD_SET(sock_fd, want_write ? &write_fds : &read_fds);
+        maxfd = sock_fd;
+    }
+    if (s_spool_ready && pipeline_fd >= 0) {
+        if (sensor_pipeline_poll(1) > 0) {
+            return;
+        }
+        FD_SET(pipeline_fd, &read_fds);
+        if (pipeline_fd > maxfd) {
+            maxfd = pipeline_fd;
+        }
+    }
+    struct timeval tv = { .tv_sec = 0, .tv_usec = TLS_CONNECT_POLL_MS * 1000 };
+    select(maxfd + 1, &read_fds, &write_fds, NULL, &tv);
+}
+
+// Función para conectar TLS: conexión asíncrona de esp-tls, avanzada paso a
+// paso sin retener el mutex TLS durante el handshake
+static bool connect_tls(void)
+{
+    ESP_LOGI(TAG, "Connecting to AWS IoT endpoint: %s:%d", AWS_IOT_ENDPOINT, MQTT_PORT);
+
+    uint32_t start = Clock_GetTimeMs();
+    TlsTransportStatus_t tlsStatus = xTlsConnectStart(&networkContext);
+
+    while (tlsStatus == TLS_TRANSPORT_CONNECT_IN_PROGRESS) {
+        tlsStatus = xTlsConnectStep(&networkContext);
+        if (tlsStatus == TLS_TRANSPORT_CONNECT_IN_PROGRESS) {
+            wait_connect_progress();
+        }
+    }
+
+    if (tlsStatus != TLS_TRANSPORT_SUCCESS) {
+        ESP_LOGE(TAG, "TLS connection failed with status: %d", tlsStatus);
+        metric_inc(&s_metric_tls_failures);
+        return false;
+    }
+    uint32_t elapsed = Clock_GetTimeMs() - start;
+    metric_inc(&s_metric_tls_connects);
+    metric_histogram_record(networkContext.xSessionOffered ? &s_metric_tls_resume : &s_metric_tls_handshake,
+                            elapsed);
+
+    // Un servidor que no acepta la sesión hace un handshake completo: se nota
+    // en que tls.resume_ms se parece a tls.handshake_ms
+    ESP_LOGI(TAG, "TLS connection established in %lu ms (%s)", (unsigned long)elapsed,
+             networkContext.xSessionOffered ? "cached session offered" : "full handshake");
+    return true;
+}
+
 // Función para conectar con reintentos
 static bool connect_with_backoff(void)
 {
@@ -221,14 +551,7 @@ static bool connect_with_backoff(void)
             goto retry;
         }
 
-        // Paso 2: Inicializar MQTT
-        if (!initialize_mqtt()) {
-            ESP_LOGW(TAG, "MQTT initialization failed on attempt %d", attempt + 1);
-            xTlsDisconnect(&networkContext);
-            goto retry;
-        }
-
-        // Paso 3: Conectar MQTT
+        // Paso 2: Conectar MQTT sobre el contexto ya inicializado
         if (!connect_mqtt()) {
             ESP_LOGW(TAG, "MQTT connection failed on attempt %d", attempt + 1);
             xTlsDisconnect(&networkContext);
@@ -248,7 +571,7 @@ retry:
 
         if (backoffStatus == BackoffAlgorithmSuccess) {
             ESP_LOGW(TAG, "Retrying in %u ms...", nextRetryBackoff);
-            vTaskDelay(pdMS_TO_TICKS(nextRetryBackoff));
+            spool_pipeline_for(nextRetryBackoff);
         } else if (backoffStatus == BackoffAlgorithmRetriesExhausted) {
             ESP_LOGE(TAG, "All retry attempts exhausted");
             break;
@@ -258,26 +581,537 @@ retry:
     return connected;
 }
 
+// Envía (o reenvía con dup) la publicación guardada en entry
+static bool inflight_send(inflight_publish_t *entry, bool dup)
+{
+    // Configurar información de publicación
+    MQTTPublishInfo_t publishInfo;
+    memset(&publishInfo, 0, sizeof(publishInfo));
+    publishInfo.qos = MQTTQoS1;  // QoS 1: at least once
+    publishInfo.retain = false;
+    publishInfo.dup = dup;
+    publishInfo.pTopicName = entry->topic;
+    publishInfo.topicNameLength = strlen(entry->topic);
+    publishInfo.pPayload = entry->payload;
+    publishInfo.payloadLength = entry->len;
+
+    entry->sent_ms = Clock_GetTimeMs();
+    uint32_t start_us = sensor_latency_now_us();
+    MQTTStatus_t mqttStatus = MQTT_Publish(&mqttContext, &publishInfo, entry->packet_id);
+    sensor_latency_record(SENSOR_LATENCY_PUBLISH, sensor_latency_now_us() - start_us);
+
+    if (mqttStatus != MQTTSuccess) {
+        ESP_LOGE(TAG, "MQTT_Publish failed with status: %d", mqttStatus);
+        metric_inc(&s_metric_publish_errors);
+        return false;
+    }
+    return true;
+}
+
+// Mete en la ventana el payload ya codificado en entry y lo publica. La
+// entrada queda ocupada hasta su PUBACK aunque el envío falle: se reenviará
+// por timeout o tras reconectar. ingest_us es la llegada de la lectura más
+// antigua del payload, o 0 si no se conoce.
+static void publish_readings(inflight_publish_t *entry, const char *topic, size_t len, size_t readings,
+                             uint32_t ingest_us)
+{
+    // Obtener un packet ID único: tras dar la vuelta a los 16 bits no debe
+    // coincidir con otra publicación que siga esperando su PUBACK
+    uint16_t packet_id;
+    do {
+        packet_id = MQTT_GetPacketId(&mqttContext);
+    } while (inflight_find(packet_id) != NULL);
+    entry->packet_id = packet_id;
+    snprintf(entry->topic, sizeof(entry->topic), "%s", topic);
+    entry->len = len;
+    entry->readings = readings;
+    entry->spooled = 0;
+    entry->retries = 0;
+    entry->first_sent_us = sensor_latency_now_us();
+    entry->ingest_us = ingest_us;
+    s_inflight_count++;
+    metric_set(&s_metric_inflight, s_inflight_count);
+    if (s_inflight_count > metric_value(&s_metric_inflight_max)) {
+        metric_set(&s_metric_inflight_max, s_inflight_count);
+    }
+
+    if (!inflight_send(entry, false)) {
+        return;
+    }
+
+    // Estadísticas de tamaño y de amortización del lote
+    metric_inc(&s_metric_published);
+    metric_add(&s_metric_readings, readings);
+    metric_add(&s_metric_bytes, len);
+    metric_histogram_record(&s_metric_msg_size, len);
+
+    ESP_LOGD(TAG, "Published %u reading(s), %u bytes, packet ID: %u (in flight: %lu)",
+             (unsigned)readings, (unsigned)len, entry->packet_id, (unsigned long)s_inflight_count);
+
+    // Log de resumen cada 10 mensajes; el detalle está en el comando CLI
+    // "metrics" y en MQTT_TOPIC_METRICS
+    uint32_t msg_count = metric_value(&s_metric_published);
+    if (msg_count % 10 == 0) {
+        metric_histogram_summary_t size;
+        metric_histogram_get(&s_metric_msg_size, &size);
+        uint32_t readings_total = metric_value(&s_metric_readings);
+        ESP_LOGI(TAG, "===== MQTT Message Size Summary (last %lu messages) =====", (unsigned long)msg_count);
+        ESP_LOGI(TAG, "  Average: %lu bytes", (unsigned long)(metric_value(&s_metric_bytes) / msg_count));
+        ESP_LOGI(TAG, "  Median: <= %lu bytes | p99: <= %lu bytes", (unsigned long)size.p50, (unsigned long)size.p99);
+        ESP_LOGI(TAG, "  Maximum: %lu bytes", (unsigned long)size.max);
+        ESP_LOGI(TAG, "  Total published: %lu messages", (unsigned long)msg_count);
+        ESP_LOGI(TAG, "  Readings published: %lu (%lu.%02lu per publish)",
+                 (unsigned long)readings_total,
+                 (unsigned long)(readings_total / msg_count),
+                 (unsigned long)((readings_total * 100 / msg_count) % 100));
+        ESP_LOGI(TAG, "  In flight: max %lu of %d | Retransmits: %lu",
+                 (unsigned long)metric_value(&s_metric_inflight_max), MQTT_PUBLISH_WINDOW,
+                 (unsigned long)metric_value(&s_metric_retransmits));
+        if (sensor_deadband_enabled()) {
+            sensor_deadband_stats_t db;
+            sensor_deadband_get_stats(&db);
+            uint32_t seen = db.passed + db.suppressed;
+            ESP_LOGI(TAG, "  Deadband: suppressed %lu of %lu (%lu%%) | heartbeats: %lu | new: %lu",
+                     (unsigned long)db.suppressed, (unsigned long)seen,
+                     (unsigned long)(seen ? (uint64_t)db.suppressed * 100 / seen : 0),
+                     (unsigned long)db.heartbeats, (unsigned long)db.first_seen);
+            ESP_LOGI(TAG, "  Deadband triggers: temp %lu | hum %lu | press %lu | gas %lu",
+                     (unsigned long)db.triggered[SENSOR_METRIC_TEMPERATURE],
+                     (unsigned long)db.triggered[SENSOR_METRIC_HUMIDITY],
+                     (unsigned long)db.triggered[SENSOR_METRIC_PRESSURE],
+                     (unsigned long)db.triggered[SENSOR_METRIC_GAS]);
+        }
+        ESP_LOGI(TAG, "========================================================");
+    }
+}
+
+// Reenvía las publicaciones sin PUBACK: las vencidas, o todas tras reconectar.
+// Con la sesión recuperada coreMQTT conserva sus registros QoS1 y el reenvío
+// va con dup; si el broker abrió una sesión nueva los registros se borraron
+// al conectar y se publica como nuevo (mismo ID) para volver a reservarlos.
+static void inflight_retransmit(bool all)
+{
+    uint32_t now = Clock_GetTimeMs();
+
+    for (size_t i = 0; i < MQTT_PUBLISH_WINDOW; i++) {
+        inflight_publish_t *entry = &s_inflight[i];
+        if (entry->packet_id == 0 || (!all && now - entry->sent_ms < MQTT_PUBACK_TIMEOUT_MS)) {
+            continue;
+        }
+        entry->retries++;
+        metric_inc(&s_metric_retransmits);
+        ESP_LOGW(TAG, "Retransmitting packet ID %u (%u reading(s), retry %u)",
+                 entry->packet_id, (unsigned)entry->readings, entry->retries);
+        inflight_send(entry, !all || s_session_present);
+    }
+}
+
+// Reenvía un lote del spool si toca y el pipeline en vivo tiene holgura
+static void replay_from_spool(TickType_t *last_replay)
+{
+    spsc_ring_stats_t stats;
+
+    if (!s_spool_ready || sensor_spool_pending() == 0 ||
+        xTaskGetTickCount() - *last_replay < pdMS_TO_TICKS(SENSOR_SPOOL_REPLAY_INTERVAL_MS)) {
+        return;
+    }
+    sensor_pipeline_get_stats(&stats);
+    if (stats.used > stats.capacity / 2) {
+        return;
+    }
+    // Un solo lote del spool en vuelo: hasta su PUBACK sus lecturas siguen
+    // pendientes y otro peek las volvería a leer
+    for (size_t i = 0; i < MQTT_PUBLISH_WINDOW; i++) {
+        if (s_inflight[i].packet_id != 0 && s_inflight[i].spooled > 0) {
+            return;
+        }
+    }
+    inflight_publish_t *entry = inflight_acquire();
+    if (entry == NULL) {
+        return;
+    }
+    *last_replay = xTaskGetTickCount();
+
+    uint32_t first = 0;
+    size_t count = sensor_spool_peek(s_replay, SENSOR_SPOOL_REPLAY_BATCH, &first);
+    if (count == 0) {
+        return;
+    }
+    if (s_replay[0].device == DEVICE_HANDLE_INVALID) {
+        // Registro sin ID (firmware anterior): no se publica una lectura anónima
+        ESP_LOGW(TAG, "Spooled reading without device ID discarded");
+        sensor_spool_consume(first, 1);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (s_replay[i].device == DEVICE_HANDLE_INVALID) {
+            count = i;
+            break;
+        }
+        s_replay_batch[i] = &s_replay[i];
+    }
+
+    size_t len = 0;
+    uint32_t start_us = sensor_latency_now_us();
+    size_t encoded = sensor_serializer_encode(s_replay_batch, count, entry->payload, sizeof(entry->payload), &len);
+    sensor_latency_record(SENSOR_LATENCY_SERIALIZE, sensor_latency_now_us() - start_us);
+    if (encoded == 0) {
+        // Registro imposible de codificar: descartarlo para no atascar el spool
+        sensor_spool_consume(first, 1);
+        return;
+    }
+
+    // Desde aquí la entrega es cosa de la ventana, que guarda su copia y
+    // consume las lecturas del spool al llegar el PUBACK. Las lecturas del
+    // spool no cuentan en la latencia extremo a extremo
+    publish_readings(entry, MQTT_TOPIC, len, encoded, 0);
+    entry->spool_first = first;
+    entry->spooled = encoded;
+    ESP_LOGI(TAG, "Replaying %u reading(s) from spool (%u pending)",
+             (unsigned)encoded, (unsigned)sensor_spool_pending());
+}
+
+// Conecta (o reconecta) sin rendirse: mientras tanto las lecturas van al spool
+static void connect_until_success(void)
+{
+    vTlsSetRecvTimeout(MQTT_CONNECT_RECV_MS);
+    while (!connect_with_backoff()) {
+        ESP_LOGE(TAG, "Failed to connect after all retries. Retrying in %d ms...", AWS_RECONNECT_PAUSE_MS);
+        spool_pipeline_for(AWS_RECONNECT_PAUSE_MS);
+    }
+    vTlsSetRecvTimeout(0);
+}
+
+// Tiempo en cola de las count primeras lecturas del lote, que salen del ring.
+// Las que se quedan para el siguiente lote se miden cuando salgan.
+static void trace_dequeue(size_t count, uint32_t taken_us)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (s_batch[i]->ingest_us != 0) {
+            sensor_latency_record(SENSOR_LATENCY_QUEUE, taken_us - s_batch[i]->ingest_us);
+        }
+    }
+}
+
+// Llegada de la lectura más antigua, o 0 si ninguna lleva marca
+static uint32_t oldest_ingest(sensor_data_t *const *readings, size_t count)
+{
+    uint32_t now_us = sensor_latency_now_us();
+    uint32_t oldest = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        uint32_t ingest = readings[i]->ingest_us;
+        if (ingest != 0 && (oldest == 0 || now_us - ingest > now_us - oldest)) {
+            oldest = ingest;
+        }
+    }
+    return oldest;
+}
+
+// Publica lotes del pipeline mientras haya hueco en la ventana. Un lote
+// incompleto espera hasta SENSOR_BATCH_LINGER_MS a llenarse; devuelve los ms
+// que le quedan de espera, o UINT32_MAX si no hay ninguno esperando.
+static uint32_t fill_window(void)
+{
+    static bool s_lingering = false;
+    static uint32_t s_linger_start = 0;
+    inflight_publish_t *entry;
+
+    while ((entry = inflight_acquire()) != NULL) {
+        size_t batch_count = sensor_pipeline_receive_batch(s_batch, SENSOR_BATCH_MAX_READINGS, 0);
+        if (batch_count == 0) {
+            s_lingering = false;
+            break;
+        }
+
+        // Si el lote no está lleno, esperar un poco más a que lleguen otras lecturas
+        if (batch_count < SENSOR_BATCH_MAX_READINGS && SENSOR_BATCH_LINGER_MS > 0) {
+            uint32_t now = Clock_GetTimeMs();
+            if (!s_lingering) {
+                s_lingering = true;
+                s_linger_start = now;
+            }
+            if (now - s_linger_start < SENSOR_BATCH_LINGER_MS) {
+                return SENSOR_BATCH_LINGER_MS - (now - s_linger_start);
+            }
+        }
+        s_lingering = false;
+
+        ESP_LOGI(TAG, "%u dato(s) recibido(s) de la cola", (unsigned)batch_count);
+        uint32_t taken_us = sensor_latency_now_us();
+
+        // Las lecturas de dispositivos agregados no se publican sueltas
+        size_t kept = split_batch(batch_count);
+        if (kept == 0) {
+            trace_dequeue(batch_count, taken_us);
+            absorb_batch(batch_count, false);
+            sensor_pipeline_release(batch_count);
+            continue;
+        }
+
+        // Serializar leyendo directamente de los slots del pipeline a la
+        // entrada de la ventana, que conserva el payload hasta el PUBACK
+        size_t len = 0;
+        uint32_t start_us = sensor_latency_now_us();
+        size_t encoded = sensor_serializer_encode(s_kept, kept,
+                                                  entry->payload, sizeof(entry->payload), &len);
+        sensor_latency_record(SENSOR_LATENCY_SERIALIZE, sensor_latency_now_us() - start_us);
+
+        if (encoded > 0) {
+            if (sensor_serializer_is_text()) {
+                ESP_LOGD(TAG, "Publishing: %.*s", (int)len, (const char *)entry->payload);
+            }
+            publish_readings(entry, MQTT_TOPIC, len, encoded, oldest_ingest(s_kept, encoded));
+        }
+
+        // Los slots serializados ya no se necesitan: devolverlos cuanto antes
+        // al productor, hasta la primera lectura que no entró en el payload.
+        // Si una no cabe ni sola, se descarta para no bloquear el ring.
+        size_t release = batch_count;
+        if (encoded == 0) {
+            release = s_kept_pos[0] + 1;
+        } else if (encoded < kept) {
+            release = s_kept_pos[encoded];
+        }
+        trace_dequeue(release, taken_us);
+        absorb_batch(release, encoded == 0);
+        sensor_pipeline_release(release);
+
+        if (encoded == 0) {
+            ESP_LOGW(TAG, "Payload too large or encoding error");
+        }
+    }
+    return UINT32_MAX;
+}
+
+// Publica las lecturas de las clases tipadas mientras haya hueco en la
+// ventana, una publicación por clase y vuelta para que ninguna acapare la
+// ventana. Sin agregación, banda muerta ni spool: si la conexión cae, las
+// lecturas esperan en su cola hasta que se llena.
+static void fill_window_classes(void)
+{
+    bool progress = true;
+
+    while (progress) {
+        progress = false;
+        for (int cls = SENSOR_CLASS_ENVIRONMENT + 1; cls < SENSOR_CLASS_COUNT; cls++) {
+            inflight_publish_t *entry = inflight_acquire();
+            if (entry == NULL) {
+                return;
+            }
+            size_t count = sensor_class_receive(cls, s_records, SENSOR_BATCH_MAX_READINGS);
+            if (count == 0) {
+                continue;
+            }
+            progress = true;
+
+            // Solo las lecturas consecutivas del primer dispositivo, de la
+            // misma generación de su handle, comparten tópico
+            const sensor_class_info_t *info = sensor_class_get(cls);
+            const sensor_record_header_t *first = s_records[0];
+            uint16_t device = first->device;
+            uint32_t taken_us = sensor_latency_now_us();
+            uint32_t oldest = 0;
+            size_t run = 0;
+            while (run < count && ((const sensor_record_header_t *)s_records[run])->device == device &&
+                   ((const sensor_record_header_t *)s_records[run])->generation == first->generation) {
+                uint32_t ingest = ((const sensor_record_header_t *)s_records[run])->ingest_us;
+                if (ingest != 0 && (oldest == 0 || taken_us - ingest > taken_us - oldest)) {
+                    oldest = ingest;
+                }
+                run++;
+            }
+
+            size_t len = 0;
+            uint32_t start_us = sensor_latency_now_us();
+            size_t encoded = sensor_serializer_encode_records(info, (const void *const *)s_records, run,
+                                                              entry->payload, sizeof(entry->payload), &len);
+            sensor_latency_record(SENSOR_LATENCY_SERIALIZE, sensor_latency_now_us() - start_us);
+
+            char topic[SENSOR_TOPIC_MAX];
+            snprintf(topic, sizeof(topic), info->topic, device_registry_name(device));
+            // Si el registro dio el handle a otro dispositivo mientras las
+            // lecturas esperaban en la cola, el nombre ya no es el suyo: se
+            // descartan. Se comprueba después de leer el nombre para cubrir
+            // también un cambio de dueño durante la serialización.
+            if (first->generation != device_registry_generation(device)) {
+                ESP_LOGW(TAG, "%u %s reading(s) of a reused device handle dropped", (unsigned)run, info->name);
+                encoded = run;
+            } else if (encoded > 0) {
+                publish_readings(entry, topic, len, encoded, oldest);
+            } else {
+                // Un registro que no cabe ni solo se descarta para no bloquear la cola
+                ESP_LOGW(TAG, "%s reading of %s too large, dropped", info->name, device_registry_name(device));
+                encoded = 1;
+            }
+            for (size_t i = 0; i < encoded; i++) {
+                uint32_t ingest = ((const sensor_record_header_t *)s_records[i])->ingest_us;
+                if (ingest != 0) {
+                    sensor_latency_record(SENSOR_LATENCY_QUEUE, taken_us - ingest);
+                }
+            }
+            sensor_class_release(cls, encoded);
+        }
+    }
+}
+
+// Publica los resúmenes de las ventanas de agregación que han vencido
+static void publish_summaries(void)
+{
+    inflight_publish_t *entry = inflight_acquire();
+    if (entry == NULL) {
+        return;
+    }
+
+    uint32_t now = Clock_GetTimeMs();
+    size_t count = sensor_aggregate_peek_due(now, s_summaries, SENSOR_SUMMARY_BATCH);
+    if (count == 0) {
+        return;
+    }
+
+    size_t len = 0;
+    uint32_t start_us = sensor_latency_now_us();
+    size_t encoded = sensor_serializer_encode_summaries(s_summaries, count,
+                                                        entry->payload, sizeof(entry->payload), &len);
+    sensor_latency_record(SENSOR_LATENCY_SERIALIZE, sensor_latency_now_us() - start_us);
+    if (encoded == 0) {
+        // Un resumen que no cabe ni solo se descarta para no atascar su ventana
+        ESP_LOGW(TAG, "Summary of %s too large, dropped", device_registry_name(s_summaries[0].device));
+        sensor_aggregate_flushed(s_summaries, 1, now);
+        return;
+    }
+
+    publish_readings(entry, MQTT_TOPIC_SUMMARY, len, encoded, 0);
+    sensor_aggregate_flushed(s_summaries, encoded, now);
+}
+
+// Publica la instantánea de métricas cada SENSOR_METRICS_REPORT_MS; devuelve
+// los ms hasta el siguiente envío, o UINT32_MAX si está desactivada
+static uint32_t publish_metrics(void)
+{
+    static uint32_t s_last_report = 0;
+
+    if (SENSOR_METRICS_REPORT_MS == 0) {
+        return UINT32_MAX;
+    }
+    uint32_t now = Clock_GetTimeMs();
+    if (now - s_last_report < SENSOR_METRICS_REPORT_MS) {
+        return SENSOR_METRICS_REPORT_MS - (now - s_last_report);
+    }
+    s_last_report = now;
+
+    size_t len = metrics_format_json(s_metrics_payload, sizeof(s_metrics_payload));
+    if (len == 0) {
+        ESP_LOGW(TAG, "Metrics snapshot does not fit in %u bytes", (unsigned)sizeof(s_metrics_payload));
+        return SENSOR_METRICS_REPORT_MS;
+    }
+
+    MQTTPublishInfo_t publishInfo;
+    memset(&publishInfo, 0, sizeof(publishInfo));
+    publishInfo.qos = MQTTQoS0;
+    publishInfo.pTopicName = MQTT_TOPIC_METRICS;
+    publishInfo.topicNameLength = strlen(MQTT_TOPIC_METRICS);
+    publishInfo.pPayload = s_metrics_payload;
+    publishInfo.payloadLength = len;
+
+    MQTTStatus_t mqttStatus = MQTT_Publish(&mqttContext, &publishInfo, 0);
+    if (mqttStatus != MQTTSuccess) {
+        ESP_LOGW(TAG, "Metrics publish failed with status: %d", mqttStatus);
+    }
+    return SENSOR_METRICS_REPORT_MS;
+}
+
+static uint32_t sample_spool_pending(void)
+{
+    return s_spool_ready ? (uint32_t)sensor_spool_pending() : 0;
+}
+
+static metric_t s_metric_spool_pending = METRIC_SAMPLED_INIT("spool.pending", METRIC_TYPE_GAUGE, sample_spool_pending);
+
+// Vuelve a calentar tras (re)conectar: el handshake reserva y libera memoria
+static void heap_check_rearm(void)
+{
+    s_heap_warmup_start = metric_value(&s_metric_pubacks);
+    s_heap_baseline = 0;
+}
+
+// Compara sys.heap_min con la referencia tomada al acabar el calentamiento
+static void heap_check(void)
+{
+    if (SENSOR_HEAP_WARMUP_PUBACKS == 0) {
+        return;
+    }
+    uint32_t messages = metric_value(&s_metric_pubacks) - s_heap_warmup_start;
+    if (messages < SENSOR_HEAP_WARMUP_PUBACKS) {
+        return;
+    }
+
+    uint32_t heap_min = esp_get_minimum_free_heap_size();
+    if (s_heap_baseline == 0) {
+        s_heap_baseline = heap_min;
+        ESP_LOGI(TAG, "Heap baseline after %lu messages: %lu bytes free at worst",
+                 (unsigned long)messages, (unsigned long)heap_min);
+        return;
+    }
+
+    uint32_t loss = (heap_min < s_heap_baseline) ? s_heap_baseline - heap_min : 0;
+    if (loss > metric_value(&s_metric_heap_loss)) {
+        ESP_LOGW(TAG, "Heap low watermark fell %lu bytes after warm-up (%lu messages)",
+                 (unsigned long)loss, (unsigned long)(messages - SENSOR_HEAP_WARMUP_PUBACKS));
+        metric_set(&s_metric_heap_loss, loss);
+    }
+}
+
+// Registra las métricas de esta tarea y de los módulos que solo ella usa
+static void register_metrics(void)
+{
+    static metric_t *const metrics[] = {
+        &s_metric_published, &s_metric_readings, &s_metric_bytes, &s_metric_msg_size,
+        &s_metric_pubacks, &s_metric_retransmits, &s_metric_publish_errors, &s_metric_reconnects,
+        &s_metric_inflight, &s_metric_inflight_max,
+        &s_metric_tls_connects, &s_metric_tls_failures, &s_metric_tls_handshake, &s_metric_tls_resume,
+        &s_metric_spool_pending, &s_metric_heap_loss,
+    };
+
+    for (size_t i = 0; i < sizeof(metrics) / sizeof(metrics[0]); i++) {
+        metrics_register(metrics[i]);
+    }
+    sensor_latency_init();
+}
+
+// Procesa todo lo recibido: PUBACKs, PINGRESP y keep-alive. mbedTLS puede
+// tener registros ya descifrados que select() no ve, así que se sigue
+// mientras queden bytes en la sesión TLS.
+static MQTTStatus_t service_socket(void)
+{
+    MQTTStatus_t mqttStatus;
+
+    do {
+        mqttStatus = MQTT_ProcessLoop(&mqttContext);
+    } while ((mqttStatus == MQTTSuccess || mqttStatus == MQTTNeedMoreBytes) &&
+             networkContext.pxTls != NULL && esp_tls_get_bytes_avail(networkContext.pxTls) > 0);
+
+    return mqttStatus;
+}
+
 // Tarea principal de AWS IoT
 void aws_iot_task(void *param)
 {
     ESP_LOGI(TAG, "AWS IoT Task started");
+    register_metrics();
 
-    // Esperar activamente hasta que WiFi obtenga IP
+    // Spool de flash para no perder lecturas mientras no hay nube
+    s_spool_ready = (sensor_spool_init() == ESP_OK);
+
+    // Esperar activamente hasta que WiFi obtenga IP, guardando lo que llegue
     ESP_LOGI(TAG, "Waiting for WiFi connection...");
     int wait_count = 0;
     while (!wifi_onboarding_is_connected()) {
-        vTaskDelay(pdMS_TO_TICKS(1000));  // Check every second
+        spool_pipeline_for(1000);  // Check every second
         wait_count++;
         if (wait_count % 5 == 0) {
             ESP_LOGI(TAG, "Still waiting for WiFi... (%d seconds)", wait_count);
         }
-        // Timeout after 60 seconds
-        if (wait_count > 60) {
-            ESP_LOGE(TAG, "WiFi connection timeout after 60 seconds. Exiting task.");
-            vTaskDelete(NULL);
-            return;
-        }
     }
     ESP_LOGI(TAG, "WiFi connected! Proceeding with AWS connection...");
 
@@ -288,123 +1122,139 @@ void aws_iot_task(void *param)
         return;
     }
 
-    // Conectar con backoff exponencial
-    if (!connect_with_backoff()) {
-        ESP_LOGE(TAG, "Failed to connect after all retries. Exiting task.");
+    if (!initialize_mqtt()) {
+        ESP_LOGE(TAG, "Failed to initialize MQTT context. Exiting task.");
         vTaskDelete(NULL);
         return;
     }
 
-    ESP_LOGI(TAG, "Connection established. Entering main loop...");
+    // Conectar con backoff exponencial
+    connect_until_success();
+    heap_check_rearm();
 
-    sensor_data_t sensor_data;
-    char json_payload[256];
+    ESP_LOGI(TAG, "Connection established. Entering main loop...");
 
-    // Estadísticas de tamaño de mensajes MQTT
-    uint32_t msg_count = 0;
-    uint32_t msg_size_min = UINT32_MAX;
-    uint32_t msg_size_max = 0;
-    uint64_t msg_size_total = 0;
+    int pipeline_fd = sensor_pipeline_get_eventfd();
+    int class_fd = sensor_class_get_eventfd();
+    if (pipeline_fd < 0 || class_fd < 0) {
+        ESP_LOGE(TAG, "Failed to get pipeline eventfd. Exiting task.");
+        vTaskDelete(NULL);
+        return;
+    }
 
-    // Bucle principal: Publicar datos desde la cola
-    uint32_t loop_count = 0;
+    // Bucle principal orientado a eventos: publicar en cuanto llegan datos y
+    // procesar PUBACKs en cuanto llegan al socket
+    uint32_t idle_count = 0;
+    uint32_t last_service = Clock_GetTimeMs();
+    TickType_t last_replay = 0;
+    bool socket_ready = false;
     while (1) {
-        // Intentar recibir datos de la cola (espera máximo 1 segundo)
-        if (xQueueReceive(g_aws_queue, &sensor_data, pdMS_TO_TICKS(1000)) == pdTRUE) {
-            ESP_LOGI(TAG, "Dato recibido de la cola");
-            // Formatear JSON con los datos del sensor
-            int len = snprintf(json_payload, sizeof(json_payload),
-                "{\"id\":\"%s\",\"temp\":%.2f,\"hum\":%.2f,\"press\":%.2f,\"gas\":%.2f}",
-                sensor_data.device_id,
-                sensor_data.temperature,
-                sensor_data.humidity,
-                sensor_data.pressure,
-                sensor_data.gas_concentration);
-
-            if (len > 0 && len < sizeof(json_payload)) {
-                ESP_LOGI(TAG, "Publishing: %s", json_payload);
-
-                // Configurar información de publicación
-                MQTTPublishInfo_t publishInfo;
-                memset(&publishInfo, 0, sizeof(publishInfo));
-                publishInfo.qos = MQTTQoS1;  // QoS 1: at least once
-                publishInfo.retain = false;
-                publishInfo.dup = false;
-                publishInfo.pTopicName = MQTT_TOPIC;
-                publishInfo.topicNameLength = strlen(MQTT_TOPIC);
-                publishInfo.pPayload = json_payload;
-                publishInfo.payloadLength = len;
-
-                // Obtener un packet ID único
-                uint16_t packetId = MQTT_GetPacketId(&mqttContext);
-
-                // Publicar
-                MQTTStatus_t mqttStatus = MQTT_Publish(&mqttContext, &publishInfo, packetId);
-
-                if (mqttStatus != MQTTSuccess) {
-                    ESP_LOGE(TAG, "MQTT_Publish failed with status: %d", mqttStatus);
-                } else {
-                    // Actualizar estadísticas de tamaño
-                    msg_count++;
-                    msg_size_total += len;
-                    if (len < msg_size_min) {
-                        msg_size_min = len;
-                    }
-                    if (len > msg_size_max) {
-                        msg_size_max = len;
-                    }
-                    uint32_t msg_size_avg = (uint32_t)(msg_size_total / msg_count);
-
-                    ESP_LOGI(TAG, "Published successfully with packet ID: %u", packetId);
-                    ESP_LOGI(TAG, "Message size: %d bytes | Min: %lu | Max: %lu | Avg: %lu | Count: %lu",
-                             len, (unsigned long)msg_size_min, (unsigned long)msg_size_max,
-                             (unsigned long)msg_size_avg, (unsigned long)msg_count);
-
-                    // Log de resumen cada 10 mensajes
-                    if (msg_count % 10 == 0) {
-                        ESP_LOGI(TAG, "===== MQTT Message Size Summary (last %lu messages) =====", (unsigned long)msg_count);
-                        ESP_LOGI(TAG, "  Average: %lu bytes", (unsigned long)msg_size_avg);
-                        ESP_LOGI(TAG, "  Minimum: %lu bytes", (unsigned long)msg_size_min);
-                        ESP_LOGI(TAG, "  Maximum: %lu bytes", (unsigned long)msg_size_max);
-                        ESP_LOGI(TAG, "  Total published: %lu messages", (unsigned long)msg_count);
-                        ESP_LOGI(TAG, "========================================================");
-                    }
+        // Procesar MQTT si el socket tiene datos o toca el keep-alive
+        if (socket_ready || Clock_GetTimeMs() - last_service >= MQTT_IO_IDLE_MS) {
+            last_service = Clock_GetTimeMs();
+            MQTTStatus_t mqttStatus = service_socket();
+
+            if (mqttStatus != MQTTSuccess && mqttStatus != MQTTNeedMoreBytes) {
+                ESP_LOGW(TAG, "MQTT_ProcessLoop returned status: %d", mqttStatus);
+
+                // Si hay un error crítico, intentar reconectar
+                if (mqttStatus == MQTTSendFailed || mqttStatus == MQTTRecvFailed ||
+                    mqttStatus == MQTTBadResponse || mqttStatus == MQTTKeepAliveTimeout) {
+
+                    ESP_LOGE(TAG, "Connection lost! Attempting to reconnect...");
+                    metric_inc(&s_metric_reconnects);
+
+                    // Desconectar limpiamente
+                    MQTT_Disconnect(&mqttContext);
+                    xTlsDisconnect(&networkContext);
+
+                    // Intentar reconectar con backoff; lo que estaba en vuelo se
+                    // reenvía enseguida y el spool después
+                    connect_until_success();
+                    heap_check_rearm();
+                    ESP_LOGI(TAG, "Reconnected successfully!");
+                    inflight_retransmit(true);
                 }
-            } else {
-                ESP_LOGW(TAG, "JSON payload too large or formatting error");
-            }
-        } else {
-            // Solo loguear cada 30 segundos para no saturar logs
-            loop_count++;
-            if (loop_count % 30 == 0) {
-                ESP_LOGI(TAG, "Esperando datos en la cola... (loop %lu)", (unsigned long)loop_count);
             }
         }
 
-        // Procesar loop de MQTT para keep-alive y ACKs (especialmente PUBACK para QoS1)
-        MQTTStatus_t mqttStatus = MQTT_ProcessLoop(&mqttContext);
+        // Llenar la ventana con lo que haya en el pipeline
+        uint32_t timeout_ms = MQTT_IO_IDLE_MS;
+        uint32_t linger_ms = fill_window();
+        if (linger_ms < timeout_ms) {
+            timeout_ms = linger_ms;
+        }
 
-        if (mqttStatus != MQTTSuccess && mqttStatus != MQTTNeedMoreBytes) {
-            ESP_LOGW(TAG, "MQTT_ProcessLoop returned status: %d", mqttStatus);
+        // Y con las lecturas de las demás clases de sensor
+        fill_window_classes();
 
-            // Si hay un error crítico, intentar reconectar
-            if (mqttStatus == MQTTSendFailed || mqttStatus == MQTTRecvFailed ||
-                mqttStatus == MQTTBadResponse || mqttStatus == MQTTKeepAliveTimeout) {
+        // Resúmenes de agregación vencidos; si la ventana MQTT está llena se
+        // esperan sus PUBACK en lugar de despertar para nada
+        publish_summaries();
+        uint32_t due_ms = sensor_aggregate_next_due_ms(Clock_GetTimeMs());
+        if (due_ms < timeout_ms && inflight_acquire() != NULL) {
+            timeout_ms = due_ms;
+        }
 
-                ESP_LOGE(TAG, "Connection lost! Attempting to reconnect...");
+        // Instantánea de métricas, a intervalo fijo
+        uint32_t report_ms = publish_metrics();
+        if (report_ms < timeout_ms) {
+            timeout_ms = report_ms;
+        }
 
-                // Desconectar limpiamente
-                MQTT_Disconnect(&mqttContext);
-                xTlsDisconnect(&networkContext);
+        // Reenviar lecturas guardadas durante cortes, a ritmo acotado
+        replay_from_spool(&last_replay);
+        if (s_spool_ready && sensor_spool_pending() > 0 && SENSOR_SPOOL_REPLAY_INTERVAL_MS < timeout_ms) {
+            timeout_ms = SENSOR_SPOOL_REPLAY_INTERVAL_MS;
+        }
 
-                // Intentar reconectar con backoff
-                if (connect_with_backoff()) {
-                    ESP_LOGI(TAG, "Reconnected successfully!");
-                } else {
-                    ESP_LOGE(TAG, "Reconnection failed after all retries. Exiting task.");
-                    vTaskDelete(NULL);
-                    return;
-                }
+        // Reenviar publicaciones cuyo PUBACK no ha llegado a tiempo
+        inflight_retransmit(false);
+
+        heap_check();
+
+        // Armar el eventfd: con un lote esperando a llenarse solo interesa
+        // el lote completo; si no, cualquier lectura nueva. Si ya hay lo que
+        // se espera y hueco en la ventana, no dormir.
+        size_t wanted = (linger_ms != UINT32_MAX) ? SENSOR_BATCH_MAX_READINGS : 1;
+        size_t class_ready = sensor_class_poll();
+        if ((sensor_pipeline_poll(wanted) >= wanted || class_ready > 0) && inflight_acquire() != NULL) {
+            timeout_ms = 0;
+        }
+
+        // Esperar a que llegue algo al socket, al pipeline o a las colas de clase
+        int sock_fd = -1;
+        esp_tls_get_conn_sockfd(networkContext.pxTls, &sock_fd);
+        fd_set read_fds;
+        FD_ZERO(&read_fds);
+        FD_SET(pipeline_fd, &read_fds);
+        FD_SET(class_fd, &read_fds);
+        if (sock_fd >= 0) {
+            FD_SET(sock_fd, &read_fds);
+        }
+        struct timeval tv = {
+            .tv_sec = timeout_ms / 1000,
+            .tv_usec = (timeout_ms % 1000) * 1000,
+        };
+        int maxfd = (sock_fd > pipeline_fd) ? sock_fd : pipeline_fd;
+        if (class_fd > maxfd) {
+            maxfd = class_fd;
+        }
+        int ready = select(maxfd + 1, &read_fds, NULL, NULL, &tv);
+
+        if (ready < 0) {
+            ESP_LOGE(TAG, "select() failed");
+            vTaskDelay(pdMS_TO_TICKS(100));
+            socket_ready = false;
+            continue;
+        }
+        socket_ready = (sock_fd >= 0 && FD_ISSET(sock_fd, &read_fds));
+
+        // Solo loguear cada 30 segundos sin actividad para no saturar logs
+        if (ready == 0 && s_inflight_count == 0 && timeout_ms == MQTT_IO_IDLE_MS) {
+            idle_count++;
+            if (idle_count % 30 == 0) {
+                ESP_LOGI(TAG, "Esperando datos en la cola... (idle %lu s)", (unsigned long)idle_count);
             }
         }
     }
@@ -418,5 +1268,7 @@ void aws_iot_task(void *param)
 // Función pública para iniciar el cliente AWS
 void start_aws_client(void)
 {
-    xTaskCreate(aws_iot_task, "aws_iot_task", 8192, NULL, 5, NULL);
+    // Serialización, TLS y MQTT en el núcleo opuesto al mainloop de OpenThread
+    xTaskCreateStaticPinnedToCore(aws_iot_task, "aws_iot_task", AWS_TASK_STACK_SIZE, NULL, 5,
+                                  s_task_stack, &s_task_tcb, TASK_CORE_CLOUD);
 }
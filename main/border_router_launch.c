@@ -41,6 +41,9 @@
 #include "esp_ot_wifi_cmd.h"
 #endif
 
+#include "pipeline_cli.h"
+#include "task_placement.h"
+#include "thread_coap_task.h"
 #include "wifi_reset_cmd.h"
 
 #if CONFIG_OPENTHREAD_BR_AUTO_START
@@ -51,9 +54,15 @@
 
 #define TAG "esp_ot_br"
 #define RCP_VERSION_MAX_SIZE 100
+#define OT_MAIN_TASK_STACK_SIZE 8192
 
 static esp_openthread_platform_config_t s_openthread_platform_config;
 
+// The mainloop (and with it the CoAP ingest path) runs for the whole uptime,
+// so its stack and TCB are static instead of coming from the heap
+static StackType_t s_ot_main_stack[OT_MAIN_TASK_STACK_SIZE];
+static StaticTask_t s_ot_main_tcb;
+
 #if CONFIG_AUTO_UPDATE_RCP
 static void update_rcp(void)
 {
@@ -200,11 +209,15 @@ static void ot_task_worker(void *ctx)
 
     // Register custom WiFi reset command
     register_wifi_reset_command();
+    // Register sensor pipeline diagnostics (latency, metrics, bench)
+    register_pipeline_commands();
+    // Bring the sensor CoAP server up on every attach to the Thread network
+    ESP_ERROR_CHECK(thread_coap_server_attach(esp_openthread_get_instance()));
 
     esp_openthread_cli_create_task();
     esp_openthread_lock_release();
 
-    xTaskCreate(ot_br_init, "ot_br_init", 6144, NULL, 4, NULL);
+    xTaskCreatePinnedToCore(ot_br_init, "ot_br_init", 6144, NULL, 4, NULL, TASK_CORE_OPENTHREAD);
     // Run the main loop
     esp_openthread_launch_mainloop();
 
@@ -227,5 +240,7 @@ void launch_openthread_border_router(const esp_openthread_platform_config_t *pla
     OT_UNUSED_VARIABLE(update_config);
 #endif
 
-    xTaskCreate(ot_task_worker, "ot_br_main", 8192, xTaskGetCurrentTaskHandle(), 5, NULL);
+    // Keep the OpenThread mainloop (CoAP ingest, spinel) off the core that runs TLS
+    xTaskCreateStaticPinnedToCore(ot_task_worker, "ot_br_main", OT_MAIN_TASK_STACK_SIZE, xTaskGetCurrentTaskHandle(),
+                                  5, s_ot_main_stack, &s_ot_main_tcb, TASK_CORE_OPENTHREAD);
 }
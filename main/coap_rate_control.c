@@ -0,0 +1,197 @@
+#include "coap_rate_control.h"
+#include <stdbool.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "device_registry.h"
+#include "sdkconfig.h"
+#include "sensor_pipeline.h"
+
+static const char *TAG = "COAP_RATE";
+
+#define RATE_MAX_DEVICES        CONFIG_SENSOR_REGISTRY_MAX_DEVICES
+#define RATE_BUDGET_RPS         CONFIG_SENSOR_RATE_BUDGET_RPS
+#define RATE_MIN_PERIOD_MS      CONFIG_SENSOR_RATE_MIN_PERIOD_MS
+#define RATE_MAX_PERIOD_MS      CONFIG_SENSOR_RATE_MAX_PERIOD_MS
+#define RATE_NOMINAL_PERIOD_MS  CONFIG_SENSOR_COAP_REPORT_INTERVAL_MS
+#define RATE_UPDATE_US          1000000  // recalcular el reparto como mucho 1 vez/s
+#define RATE_EWMA_WEIGHT        0.25f    // peso de la última muestra en la media
+
+// Un dispositivo se considera inactivo si lleva más de RATE_IDLE_FACTOR
+// datagramas sin reportar (intervalo medio por lecturas por datagrama)
+#define RATE_IDLE_FACTOR        4
+
+// Un dispositivo frenado ya no muestra su demanda real, así que la limitación
+// se relaja poco a poco (-15% por recálculo) y solo se levanta del todo tras
+// RATE_RELEASE_UPDATES recálculos seguidos en el mínimo sin congestión
+#define RATE_RELEASE_PERCENT    85
+#define RATE_RELEASE_UPDATES    30
+
+typedef struct {
+    int64_t last_us;
+    float interval_ms;   // media móvil exponencial del tiempo entre lecturas
+    uint16_t batch;      // lecturas del último datagrama
+    uint16_t generation; // del handle en el registro: otra = otro dispositivo
+} rate_device_t;
+
+// Indexado por el handle del registro de dispositivos
+static rate_device_t s_devices[RATE_MAX_DEVICES];
+static int64_t s_last_update_us = 0;
+static uint32_t s_period_ms = 0;  // 0 = sin limitación
+static uint32_t s_calm_updates = 0;
+
+static bool device_active(const rate_device_t *dev, int64_t now_us)
+{
+    return dev->interval_ms > 0 &&
+           (now_us - dev->last_us) / 1000 < RATE_IDLE_FACTOR * dev->interval_ms * dev->batch;
+}
+
+// Reparto max-min justo del presupuesto: el límite c cumple
+// sum(min(tasa_i, c)) = presupuesto. Devuelve el periodo 1/c en ms, o 0 si la
+// demanda total cabe en el presupuesto.
+static uint32_t fair_period_ms(int64_t now_us, size_t *active)
+{
+    static float rates[RATE_MAX_DEVICES];  // fuera de la pila de OpenThread
+    float demand = 0;
+    size_t n = 0;
+
+    for (size_t i = 0; i < RATE_MAX_DEVICES; i++) {
+        if (device_active(&s_devices[i], now_us)) {
+            float rate = 1000.0f / s_devices[i].interval_ms;
+            // Inserción ordenada: como mucho RATE_MAX_DEVICES elementos
+            size_t j = n++;
+            while (j > 0 && rates[j - 1] > rate) {
+                rates[j] = rates[j - 1];
+                j--;
+            }
+            rates[j] = rate;
+            demand += rate;
+        }
+    }
+
+    *active = n;
+    if (demand <= RATE_BUDGET_RPS) {
+        return 0;
+    }
+
+    float remaining = RATE_BUDGET_RPS;
+    for (size_t i = 0; i < n; i++) {
+        if (rates[i] * (n - i) > remaining) {
+            return (uint32_t)(1000.0f * (n - i) / remaining);
+        }
+        remaining -= rates[i];
+    }
+    return 0;
+}
+
+static uint32_t clamp_period(uint32_t period)
+{
+    if (period < RATE_MIN_PERIOD_MS) {
+        period = RATE_MIN_PERIOD_MS;
+    }
+    if (period > RATE_MAX_PERIOD_MS) {
+        period = RATE_MAX_PERIOD_MS;
+    }
+    return period;
+}
+
+static void update_period(int64_t now_us)
+{
+    size_t active = 0;
+    uint32_t target = fair_period_ms(now_us, &active);
+
+    // Backlog: por encima de la mitad del pipeline se alarga el periodo
+    // linealmente hasta x3 con el pipeline lleno
+    spsc_ring_stats_t stats;
+    sensor_pipeline_get_stats(&stats);
+    if (stats.used * 2 > stats.capacity && active > 0) {
+        if (target == 0) {
+            target = (uint32_t)(1000.0f * active / RATE_BUDGET_RPS);
+        }
+        float occupancy = (float)stats.used / stats.capacity;
+        target = (uint32_t)(target * (1.0f + 4.0f * (occupancy - 0.5f)));
+    }
+    if (target != 0) {
+        target = clamp_period(target);
+    }
+
+    uint32_t period = s_period_ms;
+    if (target > s_period_ms) {
+        // Más congestión: frenar ya (con un 10% de histéresis para no
+        // notificar a los observadores en cada ajuste)
+        if (s_period_ms == 0 || (target - s_period_ms) * 10 > s_period_ms) {
+            period = target;
+        }
+        s_calm_updates = 0;
+    } else if (s_period_ms != 0) {
+        // Menos congestión: relajar gradualmente
+        period = clamp_period(s_period_ms * RATE_RELEASE_PERCENT / 100);
+        if (period < target) {
+            period = target;
+        }
+        if (target == 0 && period == RATE_MIN_PERIOD_MS) {
+            if (++s_calm_updates >= RATE_RELEASE_UPDATES) {
+                period = 0;
+            }
+        } else {
+            s_calm_updates = 0;
+        }
+    }
+
+    // Una limitación por debajo del periodo nominal no limita nada
+    if (period != 0 && period <= RATE_NOMINAL_PERIOD_MS) {
+        period = 0;
+    }
+
+    if (period != s_period_ms) {
+        ESP_LOGI(TAG, "Periodo de reporte: %lu ms (%u dispositivos activos, %lu/%lu en el pipeline)",
+                 (unsigned long)period, (unsigned)active,
+                 (unsigned long)stats.used, (unsigned long)stats.capacity);
+        s_period_ms = period;
+    }
+}
+
+uint32_t rate_control_on_reading(uint16_t device, size_t count)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    if (device >= RATE_MAX_DEVICES || count == 0) {
+        return RATE_NOMINAL_PERIOD_MS;
+    }
+    rate_device_t *dev = &s_devices[device];
+    uint16_t generation = device_registry_generation(device);
+
+    if (dev->generation != generation) {
+        *dev = (rate_device_t){ .generation = generation };
+    }
+    if (dev->last_us != 0) {
+        // count lecturas juntas cuentan como count muestras de un intervalo
+        // repartido entre ellas: la media pesa igual una ráfaga que las mismas
+        // lecturas llegadas de una en una
+        float sample = (float)(now_us - dev->last_us) / 1000.0f / count;
+        float keep = 1.0f;
+        for (size_t i = 0; i < count && keep > 0.001f; i++) {
+            keep *= 1.0f - RATE_EWMA_WEIGHT;
+        }
+        dev->interval_ms = (dev->interval_ms > 0) ?
+                           dev->interval_ms + (1.0f - keep) * (sample - dev->interval_ms) : sample;
+    }
+    dev->last_us = now_us;
+    dev->batch = (count > UINT16_MAX) ? UINT16_MAX : (uint16_t)count;
+
+    if (now_us - s_last_update_us >= RATE_UPDATE_US) {
+        s_last_update_us = now_us;
+        update_period(now_us);
+    }
+
+    // Solo se frena a quien reporta más rápido que el límite (con un 10% de
+    // margen, porque un dispositivo ya frenado reporta justo en el límite)
+    if (s_period_ms != 0 && dev->interval_ms > 0 && dev->interval_ms * 10 < s_period_ms * 11) {
+        return s_period_ms;
+    }
+    return RATE_NOMINAL_PERIOD_MS;
+}
+
+uint32_t rate_control_fleet_period(void)
+{
+    return (s_period_ms != 0) ? s_period_ms : RATE_NOMINAL_PERIOD_MS;
+}
@@ -0,0 +1,46 @@
+#ifndef COAP_RATE_CONTROL_H
+#define COAP_RATE_CONTROL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Record the readings of one datagram from a device and get the
+ *        reporting period to announce to it
+ *
+ * The controller tracks each device's arrival rate and the backlog of the
+ * sensor pipeline. When the fleet's total demand exceeds
+ * CONFIG_SENSOR_RATE_BUDGET_RPS, it computes a max-min fair cap: devices
+ * reporting faster than the cap are slowed down to it, and slower devices
+ * are left alone. A pipeline more than half full stretches the period
+ * further. Must be called from the OpenThread task only, including for
+ * readings that end up dropped, since they are still demand.
+ *
+ * The rate is tracked per reading: a datagram carrying count readings counts
+ * as count arrivals spread evenly since the previous datagram.
+ *
+ * @param device Device handle from the device registry
+ * @param count  Readings of this device in the datagram (0 is ignored)
+ * @return Period in ms for this device, or CONFIG_SENSOR_COAP_REPORT_INTERVAL_MS
+ *         when it does not need throttling (0 = keep the device's own period)
+ */
+uint32_t rate_control_on_reading(uint16_t device, size_t count);
+
+/**
+ * @brief Fleet-wide period currently imposed on fast devices
+ *
+ * Sent to nodes that observe the sensordata resource.
+ *
+ * @return Period in ms, or CONFIG_SENSOR_COAP_REPORT_INTERVAL_MS when there is no throttling
+ */
+uint32_t rate_control_fleet_period(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // COAP_RATE_CONTROL_H
@@ -0,0 +1,398 @@
+#include "device_registry.h"
+#include <stdatomic.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "DEVICE_REGISTRY";
+
+#define REGISTRY_MAX_DEVICES    CONFIG_SENSOR_REGISTRY_MAX_DEVICES
+#define REGISTRY_INDEX_SIZE     (2 * REGISTRY_MAX_DEVICES)  // carga máxima 50%
+#define REGISTRY_ID_LEN         16
+#define REGISTRY_IDLE_S         CONFIG_SENSOR_REGISTRY_IDLE_S
+#define REGISTRY_REPLAY_SLOTS   DEVICE_REGISTRY_REPLAY_SLOTS
+
+_Static_assert((REGISTRY_MAX_DEVICES & (REGISTRY_MAX_DEVICES - 1)) == 0,
+               "CONFIG_SENSOR_REGISTRY_MAX_DEVICES must be a power of two");
+_Static_assert(REGISTRY_MAX_DEVICES <= DEVICE_HANDLE_REPLAY_BASE, "too many devices for a uint16 handle");
+
+// El ID tiene dos copias: al reutilizar el handle se escribe la que no está
+// en uso y luego se publica name_index, así quien lee el nombre sin lock
+// nunca ve uno a medio escribir. La copia anterior solo se vuelve a escribir
+// en la siguiente reutilización, al menos CONFIG_SENSOR_REGISTRY_IDLE_S después.
+typedef struct {
+    char device_id[2][REGISTRY_ID_LEN];
+    _Atomic uint8_t name_index;            // copia vigente de device_id
+    uint8_t iid[DEVICE_REGISTRY_IID_LEN];  // solo cambia con s_lock tomado
+    _Atomic uint16_t generation;           // +1 cada vez que se reutiliza el handle
+    _Atomic uint32_t last_seen_s;
+    _Atomic uint32_t datagrams;
+    _Atomic uint32_t readings;
+    _Atomic uint32_t dropped;
+} registry_entry_t;
+
+// Los handles son índices en s_entries. Los índices hash guardan handle + 1
+// (0 = hueco libre) y se recorren sin lock: una entrada nueva se escribe
+// entera antes de publicar su handle con semántica release. Con el registro
+// lleno se reutiliza el handle del dispositivo que más tiempo lleva callado,
+// si pasa de CONFIG_SENSOR_REGISTRY_IDLE_S; los índices se reconstruyen y
+// s_epoch (impar mientras tanto) invalida las búsquedas sin lock en curso.
+static registry_entry_t s_entries[REGISTRY_MAX_DEVICES];
+static _Atomic uint16_t s_count = 0;
+static _Atomic uint16_t s_by_name[REGISTRY_INDEX_SIZE];
+static _Atomic uint16_t s_by_iid[REGISTRY_INDEX_SIZE];
+static _Atomic uint32_t s_epoch = 0;
+static size_t s_iid_used = 0;  // huecos ocupados en s_by_iid, con s_lock tomado
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Nombres de lecturas reenviadas desde el spool (solo aws_iot_task)
+static char s_replay_names[REGISTRY_REPLAY_SLOTS][REGISTRY_ID_LEN];
+static size_t s_replay_used = 0;
+
+static const uint8_t s_no_iid[DEVICE_REGISTRY_IID_LEN] = { 0 };
+
+// FNV-1a
+static uint32_t hash_bytes(const uint8_t *data, size_t len)
+{
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static inline const char *entry_name(const registry_entry_t *entry)
+{
+    return entry->device_id[atomic_load_explicit(&entry->name_index, memory_order_acquire)];
+}
+
+static inline size_t name_len(const char *device_id)
+{
+    return strnlen(device_id, REGISTRY_ID_LEN - 1);
+}
+
+// Sondeo lineal; devuelve el handle o, si no está, deja en *free_slot el
+// primer hueco libre del racimo
+static uint16_t probe_name(const char *device_id, size_t len, size_t *free_slot)
+{
+    size_t index = hash_bytes((const uint8_t *)device_id, len) & (REGISTRY_INDEX_SIZE - 1);
+
+    for (;;) {
+        uint16_t value = atomic_load_explicit(&s_by_name[index], memory_order_acquire);
+        if (value == 0) {
+            *free_slot = index;
+            return DEVICE_HANDLE_INVALID;
+        }
+        const char *name = entry_name(&s_entries[value - 1]);
+        if (strncmp(name, device_id, len) == 0 && name[len] == '\0') {
+            return value - 1;
+        }
+        index = (index + 1) & (REGISTRY_INDEX_SIZE - 1);
+    }
+}
+
+// Un mismo IID puede quedar en el índice apuntando a un dispositivo que ya
+// no lo usa (cambio de ML-EID): se comprueba contra la entrada. Deja en *slot
+// el hueco encontrado o, si no está, el primer hueco libre
+static uint16_t probe_iid(const uint8_t *iid, size_t *slot)
+{
+    size_t index = hash_bytes(iid, DEVICE_REGISTRY_IID_LEN) & (REGISTRY_INDEX_SIZE - 1);
+
+    for (;;) {
+        uint16_t value = atomic_load_explicit(&s_by_iid[index], memory_order_acquire);
+        if (value == 0) {
+            *slot = index;
+            return DEVICE_HANDLE_INVALID;
+        }
+        if (memcmp(s_entries[value - 1].iid, iid, DEVICE_REGISTRY_IID_LEN) == 0) {
+            *slot = index;
+            return value - 1;
+        }
+        index = (index + 1) & (REGISTRY_INDEX_SIZE - 1);
+    }
+}
+
+// Asocia el IID al dispositivo; con s_lock tomado
+static void bind_iid(uint16_t handle, const uint8_t *iid)
+{
+    size_t slot;
+    registry_entry_t *entry = &s_entries[handle];
+
+    if (memcmp(entry->iid, iid, DEVICE_REGISTRY_IID_LEN) == 0) {
+        return;
+    }
+    uint16_t previous = probe_iid(iid, &slot);
+    if (previous != DEVICE_HANDLE_INVALID) {
+        // La dirección pasó a otro dispositivo: el anterior la pierde
+        memset(s_entries[previous].iid, 0, DEVICE_REGISTRY_IID_LEN);
+        memcpy(entry->iid, iid, DEVICE_REGISTRY_IID_LEN);
+        atomic_store_explicit(&s_by_iid[slot], handle + 1, memory_order_release);
+        return;
+    }
+    memcpy(entry->iid, iid, DEVICE_REGISTRY_IID_LEN);
+    // Si el índice se llena de IIDs viejos, el dispositivo solo pierde la
+    // búsqueda por dirección y tendrá que enviar su ID. Siempre queda un
+    // hueco libre para que el sondeo termine.
+    if (s_iid_used + 1 < REGISTRY_INDEX_SIZE) {
+        atomic_store_explicit(&s_by_iid[slot], handle + 1, memory_order_release);
+        s_iid_used++;
+    }
+}
+
+static inline uint32_t now_s(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+// Cada búsqueda con éxito cuenta como contacto: un handle recién devuelto
+// no se puede desalojar aunque la trama que lo trae no se haya anotado aún
+static inline void touch(uint16_t handle)
+{
+    atomic_store_explicit(&s_entries[handle].last_seen_s, now_s(), memory_order_relaxed);
+}
+
+// Comienzo de una búsqueda sin lock: false si hay una reconstrucción en curso
+static inline bool read_begin(uint32_t *epoch)
+{
+    *epoch = atomic_load_explicit(&s_epoch, memory_order_acquire);
+    return (*epoch & 1) == 0;
+}
+
+// La búsqueda vale si ninguna reconstrucción empezó mientras tanto
+static inline bool read_valid(uint32_t epoch)
+{
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&s_epoch, memory_order_relaxed) == epoch;
+}
+
+// Vuelve a llenar los índices con las entradas vivas; con s_lock tomado
+static void rebuild_indexes(void)
+{
+    uint16_t count = atomic_load(&s_count);
+    size_t slot;
+
+    for (size_t i = 0; i < REGISTRY_INDEX_SIZE; i++) {
+        atomic_store_explicit(&s_by_name[i], 0, memory_order_relaxed);
+        atomic_store_explicit(&s_by_iid[i], 0, memory_order_relaxed);
+    }
+    s_iid_used = 0;
+    for (uint16_t handle = 0; handle < count; handle++) {
+        const registry_entry_t *entry = &s_entries[handle];
+        const char *name = entry_name(entry);
+        probe_name(name, strlen(name), &slot);
+        atomic_store_explicit(&s_by_name[slot], handle + 1, memory_order_relaxed);
+        if (memcmp(entry->iid, s_no_iid, DEVICE_REGISTRY_IID_LEN) != 0 &&
+            probe_iid(entry->iid, &slot) == DEVICE_HANDLE_INVALID) {
+            atomic_store_explicit(&s_by_iid[slot], handle + 1, memory_order_relaxed);
+            s_iid_used++;
+        }
+    }
+}
+
+// Dispositivo callado desde hace más tiempo, si supera el umbral; con s_lock tomado
+static uint16_t find_idle(uint32_t now)
+{
+    uint16_t count = atomic_load(&s_count);
+    uint16_t oldest = DEVICE_HANDLE_INVALID;
+    uint32_t oldest_idle = 0;
+
+    for (uint16_t handle = 0; handle < count; handle++) {
+        uint32_t idle = now - atomic_load_explicit(&s_entries[handle].last_seen_s, memory_order_relaxed);
+        if (idle >= REGISTRY_IDLE_S && idle >= oldest_idle) {
+            oldest = handle;
+            oldest_idle = idle;
+        }
+    }
+    return oldest;
+}
+
+// Prepara la entrada para un dispositivo; con s_lock tomado. La generación
+// se guarda antes de publicar el nombre: quien vea el nombre nuevo ve
+// también la generación nueva.
+static void fill_entry(registry_entry_t *entry, const char *device_id, size_t len, uint16_t generation,
+                       uint32_t now)
+{
+    uint8_t next = atomic_load_explicit(&entry->name_index, memory_order_relaxed) ^ 1;
+
+    memset(entry->device_id[next], 0, REGISTRY_ID_LEN);
+    memcpy(entry->device_id[next], device_id, len);
+    memset(entry->iid, 0, DEVICE_REGISTRY_IID_LEN);
+    atomic_store_explicit(&entry->generation, generation, memory_order_relaxed);
+    atomic_store_explicit(&entry->last_seen_s, now, memory_order_relaxed);
+    atomic_store_explicit(&entry->datagrams, 0, memory_order_relaxed);
+    atomic_store_explicit(&entry->readings, 0, memory_order_relaxed);
+    atomic_store_explicit(&entry->dropped, 0, memory_order_relaxed);
+    atomic_store_explicit(&entry->name_index, next, memory_order_release);
+}
+
+uint16_t device_registry_resolve(const char *device_id, const uint8_t *iid)
+{
+    size_t len = name_len(device_id);
+    size_t slot;
+    uint32_t epoch;
+
+    if (len == 0) {
+        return DEVICE_HANDLE_INVALID;
+    }
+    if (iid != NULL && memcmp(iid, s_no_iid, DEVICE_REGISTRY_IID_LEN) == 0) {
+        iid = NULL;
+    }
+
+    // Camino rápido: dispositivo conocido desde la misma dirección
+    if (read_begin(&epoch)) {
+        uint16_t handle = probe_name(device_id, len, &slot);
+        if (handle != DEVICE_HANDLE_INVALID &&
+            (iid == NULL || memcmp(s_entries[handle].iid, iid, DEVICE_REGISTRY_IID_LEN) == 0) &&
+            read_valid(epoch)) {
+            touch(handle);
+            return handle;
+        }
+    }
+
+    uint32_t now = now_s();
+    char evicted[REGISTRY_ID_LEN] = "";
+    bool created = false;
+    portENTER_CRITICAL(&s_lock);
+    // Otra tarea pudo registrarlo entre la búsqueda y el lock
+    uint16_t handle = probe_name(device_id, len, &slot);
+    if (handle == DEVICE_HANDLE_INVALID) {
+        uint16_t count = atomic_load(&s_count);
+        if (count < REGISTRY_MAX_DEVICES) {
+            handle = count;
+            created = true;
+            fill_entry(&s_entries[handle], device_id, len, 0, now);
+            atomic_store_explicit(&s_count, count + 1, memory_order_release);
+            atomic_store_explicit(&s_by_name[slot], handle + 1, memory_order_release);
+        } else if ((handle = find_idle(now)) != DEVICE_HANDLE_INVALID) {
+            registry_entry_t *entry = &s_entries[handle];
+            created = true;
+            memcpy(evicted, entry_name(entry), sizeof(evicted));
+            atomic_store_explicit(&s_epoch, atomic_load(&s_epoch) + 1, memory_order_relaxed);
+            atomic_thread_fence(memory_order_release);
+            fill_entry(entry, device_id, len, atomic_load(&entry->generation) + 1, now);
+            rebuild_indexes();
+            atomic_store_explicit(&s_epoch, atomic_load(&s_epoch) + 1, memory_order_release);
+        }
+    }
+    if (handle != DEVICE_HANDLE_INVALID) {
+        touch(handle);
+        if (iid != NULL) {
+            bind_iid(handle, iid);
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (handle == DEVICE_HANDLE_INVALID) {
+        ESP_LOGW(TAG, "Registry full (%d devices active in the last %d s), refusing %.*s",
+                 REGISTRY_MAX_DEVICES, REGISTRY_IDLE_S, (int)len, device_id);
+    } else if (evicted[0] != '\0') {
+        ESP_LOGI(TAG, "Device %s registered as handle %u (idle %s evicted)",
+                 entry_name(&s_entries[handle]), handle, evicted);
+    } else if (created) {
+        ESP_LOGI(TAG, "Device %s registered as handle %u", entry_name(&s_entries[handle]), handle);
+    }
+    return handle;
+}
+
+uint16_t device_registry_find_by_iid(const uint8_t *iid)
+{
+    size_t slot;
+    uint32_t epoch;
+    uint16_t handle;
+
+    // Una reconstrucción dura lo que la sección crítica: se reintenta
+    do {
+        while (!read_begin(&epoch)) {
+        }
+        handle = probe_iid(iid, &slot);
+    } while (!read_valid(epoch));
+    if (handle != DEVICE_HANDLE_INVALID) {
+        touch(handle);
+    }
+    return handle;
+}
+
+uint16_t device_registry_generation(uint16_t handle)
+{
+    if (handle >= atomic_load(&s_count)) {
+        return 0;
+    }
+    return atomic_load_explicit(&s_entries[handle].generation, memory_order_relaxed);
+}
+
+const char *device_registry_name(uint16_t handle)
+{
+    if (handle == DEVICE_HANDLE_BENCH) {
+        return "bench";
+    }
+    if (handle >= DEVICE_HANDLE_REPLAY_BASE && handle < DEVICE_HANDLE_REPLAY_BASE + s_replay_used) {
+        return s_replay_names[handle - DEVICE_HANDLE_REPLAY_BASE];
+    }
+    if (handle >= atomic_load_explicit(&s_count, memory_order_acquire)) {
+        return "";
+    }
+    return entry_name(&s_entries[handle]);
+}
+
+uint16_t device_registry_replay_handle(const char *device_id)
+{
+    size_t len = name_len(device_id);
+
+    if (len == 0) {
+        return DEVICE_HANDLE_INVALID;
+    }
+    for (size_t i = 0; i < s_replay_used; i++) {
+        if (strncmp(s_replay_names[i], device_id, len) == 0 && s_replay_names[i][len] == '\0') {
+            return DEVICE_HANDLE_REPLAY_BASE + i;
+        }
+    }
+    if (s_replay_used >= REGISTRY_REPLAY_SLOTS) {
+        return DEVICE_HANDLE_INVALID;
+    }
+    memcpy(s_replay_names[s_replay_used], device_id, len);
+    s_replay_names[s_replay_used][len] = '\0';
+    return DEVICE_HANDLE_REPLAY_BASE + s_replay_used++;
+}
+
+void device_registry_replay_reset(void)
+{
+    s_replay_used = 0;
+}
+
+void device_registry_note(uint16_t handle, uint32_t accepted, uint32_t dropped)
+{
+    if (handle >= atomic_load(&s_count)) {
+        return;
+    }
+    registry_entry_t *entry = &s_entries[handle];
+
+    atomic_store_explicit(&entry->last_seen_s, now_s(), memory_order_relaxed);
+    atomic_fetch_add_explicit(&entry->datagrams, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&entry->readings, accepted, memory_order_relaxed);
+    atomic_fetch_add_explicit(&entry->dropped, dropped, memory_order_relaxed);
+}
+
+size_t device_registry_count(void)
+{
+    return atomic_load(&s_count);
+}
+
+bool device_registry_get_info(uint16_t handle, device_registry_info_t *info)
+{
+    if (handle >= atomic_load(&s_count)) {
+        return false;
+    }
+    const registry_entry_t *entry = &s_entries[handle];
+
+    memcpy(info->device_id, entry_name(entry), sizeof(info->device_id));
+    memcpy(info->iid, entry->iid, sizeof(info->iid));
+    info->last_seen_s = atomic_load_explicit(&entry->last_seen_s, memory_order_relaxed);
+    info->datagrams = atomic_load_explicit(&entry->datagrams, memory_order_relaxed);
+    info->readings = atomic_load_explicit(&entry->readings, memory_order_relaxed);
+    info->dropped = atomic_load_explicit(&entry->dropped, memory_order_relaxed);
+    return true;
+}
@@ -0,0 +1,131 @@
+#ifndef DEVICE_REGISTRY_H
+#define DEVICE_REGISTRY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Handle returned when a device cannot be registered */
+#define DEVICE_HANDLE_INVALID   0xFFFF
+
+/** Handle of the synthetic "bench" device; never takes a registry slot */
+#define DEVICE_HANDLE_BENCH     0xFFFE
+
+/** First of the temporary handles given to readings replayed from the spool */
+#define DEVICE_HANDLE_REPLAY_BASE 0xFF00
+
+/** Temporary handles available to one spool replay batch */
+#define DEVICE_REGISTRY_REPLAY_SLOTS CONFIG_SENSOR_SPOOL_REPLAY_BATCH
+
+/** Length of the mesh interface identifier kept per device */
+#define DEVICE_REGISTRY_IID_LEN 8
+
+/**
+ * @brief Diagnostic snapshot of one registered device
+ */
+typedef struct {
+    char device_id[16];                   /**< First-seen ID string */
+    uint8_t iid[DEVICE_REGISTRY_IID_LEN]; /**< IID of the last source address (all 0 if unknown) */
+    uint32_t last_seen_s;                 /**< Seconds since boot of the last datagram */
+    uint32_t datagrams;                   /**< CoAP requests received */
+    uint32_t readings;                    /**< Readings accepted into the pipeline */
+    uint32_t dropped;                     /**< Readings refused because the pipeline was full */
+} device_registry_info_t;
+
+/**
+ * @brief Map a device ID string to its compact handle, registering it if new
+ *
+ * Handles are dense (0, 1, 2...), assigned in order of first contact, so
+ * per-device state elsewhere can be kept in plain arrays of
+ * CONFIG_SENSOR_REGISTRY_MAX_DEVICES entries. Only the handle travels
+ * through the pipeline; the string is looked up again when a reading is
+ * serialized.
+ *
+ * Once the registry is full, a new device takes over the handle of the
+ * device that has been silent longest, provided it has been silent for at
+ * least CONFIG_SENSOR_REGISTRY_IDLE_S. The handle's generation is then
+ * incremented so per-device state keyed by it can be reset (see
+ * device_registry_generation()). Every successful lookup counts as contact.
+ *
+ * Lookups are lock-free. Registering takes a short critical section, so
+ * any task may call this.
+ *
+ * @param device_id NUL-terminated ID, at most 15 characters are kept
+ * @param iid       Interface identifier of the sender's mesh address, or
+ *                  NULL; binds the device so later frames may omit the ID
+ * @return Handle, or DEVICE_HANDLE_INVALID if the ID is empty or every
+ *         device has been active within CONFIG_SENSOR_REGISTRY_IDLE_S
+ */
+uint16_t device_registry_resolve(const char *device_id, const uint8_t *iid);
+
+/**
+ * @brief Find a device by the interface identifier of its mesh address
+ *
+ * @return Handle, or DEVICE_HANDLE_INVALID if no device sent from it yet
+ */
+uint16_t device_registry_find_by_iid(const uint8_t *iid);
+
+/**
+ * @brief Times a handle has been handed over to a new device
+ *
+ * Per-device state stored by handle belongs to the device only while the
+ * generation it was created with is still current.
+ */
+uint16_t device_registry_generation(uint16_t handle);
+
+/**
+ * @brief ID string of a handle (never NULL; "" for an invalid handle)
+ *
+ * Also resolves DEVICE_HANDLE_BENCH and the temporary replay handles. The
+ * string is read without a lock: when the handle is reused the new ID is
+ * written to a second buffer, so the returned one is never modified while
+ * current and stays intact for at least CONFIG_SENSOR_REGISTRY_IDLE_S
+ * afterwards. Look it up once per use (e.g. once per serialized reading).
+ */
+const char *device_registry_name(uint16_t handle);
+
+/**
+ * @brief Temporary handle for a device ID read back from the spool
+ *
+ * Spooled readings carry their ID string and may belong to devices no
+ * longer (or not yet) registered, so they never take a registry slot. The
+ * same ID gets the same handle until device_registry_replay_reset(). The
+ * handles carry no per-device state. aws_iot_task only.
+ *
+ * @return Handle, or DEVICE_HANDLE_INVALID if the ID is empty or the
+ *         DEVICE_REGISTRY_REPLAY_SLOTS handles are in use
+ */
+uint16_t device_registry_replay_handle(const char *device_id);
+
+/**
+ * @brief Release the temporary replay handles (before peeking a new batch)
+ */
+void device_registry_replay_reset(void);
+
+/**
+ * @brief Account one datagram from a device and the fate of its readings
+ */
+void device_registry_note(uint16_t handle, uint32_t accepted, uint32_t dropped);
+
+/**
+ * @brief Number of registry slots in use (registry handles are below this)
+ */
+size_t device_registry_count(void);
+
+/**
+ * @brief Copy the diagnostic counters of a device
+ *
+ * @return false if the handle is not registered
+ */
+bool device_registry_get_info(uint16_t handle, device_registry_info_t *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DEVICE_REGISTRY_H
@@ -0,0 +1,115 @@
+#include "json_writer.h"
+#include <math.h>
+#include <string.h>
+
+// La parte entera tiene que caber en uint32_t
+#define FIXED2_LIMIT 4294967296.0f
+
+static const char s_hex[] = "0123456789abcdef";
+
+void json_writer_raw(json_writer_t *writer, const char *text, size_t len)
+{
+    if (writer->overflow || len > writer->size - writer->pos) {
+        writer->overflow = true;
+        return;
+    }
+    memcpy(writer->buf + writer->pos, text, len);
+    writer->pos += len;
+}
+
+void json_writer_key(json_writer_t *writer, const char *key)
+{
+    json_writer_literal(writer, ",\"");
+    json_writer_raw(writer, key, strlen(key));
+    json_writer_literal(writer, "\":");
+}
+
+void json_writer_string(json_writer_t *writer, const char *text)
+{
+    json_writer_literal(writer, "\"");
+    for (const char *run = text; !writer->overflow; text++) {
+        unsigned char c = (unsigned char)*text;
+        if (c != '\0' && c != '"' && c != '\\' && c >= 0x20) {
+            continue;
+        }
+        // Copiar de una vez el tramo que no necesita escape
+        json_writer_raw(writer, run, text - run);
+        run = text + 1;
+        if (c == '\0') {
+            break;
+        }
+        if (c == '"' || c == '\\') {
+            char escaped[2] = { '\\', (char)c };
+            json_writer_raw(writer, escaped, sizeof(escaped));
+        } else {
+            char escaped[6] = { '\\', 'u', '0', '0', s_hex[c >> 4], s_hex[c & 0xF] };
+            json_writer_raw(writer, escaped, sizeof(escaped));
+        }
+    }
+    json_writer_literal(writer, "\"");
+}
+
+// Dígitos de value al final de digits; devuelve dónde empiezan
+static char *format_u32(char digits[10], uint32_t value)
+{
+    char *p = digits + 10;
+
+    do {
+        *--p = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    return p;
+}
+
+void json_writer_u32(json_writer_t *writer, uint32_t value)
+{
+    char digits[10];
+    char *start = format_u32(digits, value);
+
+    json_writer_raw(writer, start, digits + sizeof(digits) - start);
+}
+
+void json_writer_i32(json_writer_t *writer, int32_t value)
+{
+    char digits[11];
+    uint32_t magnitude = (value < 0) ? 0u - (uint32_t)value : (uint32_t)value;
+    char *start = format_u32(digits + 1, magnitude);
+
+    if (value < 0) {
+        *--start = '-';
+    }
+    json_writer_raw(writer, start, digits + sizeof(digits) - start);
+}
+
+void json_writer_fixed2(json_writer_t *writer, float value)
+{
+    float magnitude = fabsf(value);
+
+    if (!(magnitude < FIXED2_LIMIT)) {
+        json_writer_literal(writer, "null");
+        return;
+    }
+
+    // Parte entera y fracción por separado: restar la parte entera es exacto
+    // en float, así que la fracción escalada conserva toda la precisión.
+    // rintf redondea los empates al par, como printf.
+    float whole = truncf(magnitude);
+    uint32_t integer = (uint32_t)whole;
+    uint32_t hundredths = (uint32_t)rintf((magnitude - whole) * 100.0f);
+    if (hundredths == 100) {
+        integer++;
+        hundredths = 0;
+    }
+
+    // Signo, hasta 10 dígitos enteros, punto y dos decimales
+    char digits[14];
+    char *start = format_u32(digits + 1, integer);
+    digits[11] = '.';
+    digits[12] = (char)('0' + hundredths / 10);
+    digits[13] = (char)('0' + hundredths % 10);
+    // printf escribe "-0.00" para los negativos que redondean a cero
+    if (signbit(value)) {
+        *--start = '-';
+    }
+    json_writer_raw(writer, start, digits + sizeof(digits) - start);
+}
@@ -0,0 +1,100 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Allocation-free JSON writer over a caller buffer
+ *
+ * Every append is bounds-checked: once something does not fit the writer
+ * stops writing and json_writer_finish() reports -1, so a chain of appends
+ * needs a single check at the end. Numbers are formatted with integer
+ * arithmetic only (no printf, no double): newlib nano printf has no %f and
+ * the full one is slow on the ESP32-S3.
+ *
+ * Output is not NUL-terminated.
+ */
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t pos;
+    bool overflow;
+} json_writer_t;
+
+/**
+ * @brief Precomputed fragment, typically ,"key": for a fixed key
+ */
+typedef struct {
+    const char *text;
+    uint8_t len;
+} json_fragment_t;
+
+/** Fragment for a string literal, length computed at compile time */
+#define JSON_FRAGMENT(literal) { (literal), sizeof(literal) - 1 }
+
+/** ,"key": for a literal key */
+#define JSON_KEY(key) JSON_FRAGMENT(",\"" key "\":")
+
+static inline void json_writer_init(json_writer_t *writer, void *buf, size_t size)
+{
+    writer->buf = buf;
+    writer->size = size;
+    writer->pos = 0;
+    writer->overflow = false;
+}
+
+/**
+ * @return Bytes written, or -1 if any append did not fit
+ */
+static inline int json_writer_finish(const json_writer_t *writer)
+{
+    return writer->overflow ? -1 : (int)writer->pos;
+}
+
+/**
+ * @brief Append len bytes as they are
+ */
+void json_writer_raw(json_writer_t *writer, const char *text, size_t len);
+
+static inline void json_writer_fragment(json_writer_t *writer, const json_fragment_t *fragment)
+{
+    json_writer_raw(writer, fragment->text, fragment->len);
+}
+
+/** Append a string literal as is */
+#define json_writer_literal(writer, literal) json_writer_raw((writer), (literal), sizeof(literal) - 1)
+
+/**
+ * @brief Append ,"key": for a key only known at run time
+ */
+void json_writer_key(json_writer_t *writer, const char *key);
+
+/**
+ * @brief Append a quoted string, escaping quotes, backslashes and control characters
+ */
+void json_writer_string(json_writer_t *writer, const char *text);
+
+void json_writer_u32(json_writer_t *writer, uint32_t value);
+void json_writer_i32(json_writer_t *writer, int32_t value);
+
+/**
+ * @brief Append value with exactly two decimals, as printf("%.2f") would
+ *
+ * Integer and fractional parts are handled separately in single precision
+ * and ties round to even, so the output matches printf except, at most in
+ * the last digit, for values within float rounding of a half hundredth.
+ * Non-finite values and magnitudes of 2^32 or more are written as null.
+ */
+void json_writer_fixed2(json_writer_t *writer, float value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,171 @@
+#include "metrics.h"
+#include <stdio.h>
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+// Histograma log-lineal de tamaño fijo: cada potencia de dos se parte en 4
+// cubetas, así el error relativo es como mucho del 25% en todo el rango de
+// 32 bits. Los valores 0..7 tienen cubeta propia.
+#define HISTOGRAM_SUB_BITS  2
+#define HISTOGRAM_SUB_COUNT (1 << HISTOGRAM_SUB_BITS)
+
+_Static_assert(METRIC_HISTOGRAM_BUCKETS == (32 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_COUNT,
+               "METRIC_HISTOGRAM_BUCKETS does not match the bucket layout");
+
+static uint32_t uptime_s(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+// Métricas del sistema, siempre presentes al principio de la lista
+static metric_t s_heap_min = {
+    .name = "sys.heap_min",
+    .type = METRIC_TYPE_GAUGE,
+    .sample = esp_get_minimum_free_heap_size,
+    .registered = true,
+};
+static metric_t s_heap_free = {
+    .name = "sys.heap_free",
+    .type = METRIC_TYPE_GAUGE,
+    .sample = esp_get_free_heap_size,
+    .next = &s_heap_min,
+    .registered = true,
+};
+static metric_t s_uptime = {
+    .name = "sys.uptime_s",
+    .type = METRIC_TYPE_GAUGE,
+    .sample = uptime_s,
+    .next = &s_heap_free,
+    .registered = true,
+};
+
+// Se añade por la cola con s_lock tomado para que el volcado salga en orden
+// de registro; se recorre sin lock
+static metric_t *s_head = &s_uptime;
+static metric_t *s_tail = &s_heap_min;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void metrics_register(metric_t *metric)
+{
+    portENTER_CRITICAL(&s_lock);
+    if (!metric->registered) {
+        metric->registered = true;
+        atomic_store_explicit(&metric->next, NULL, memory_order_relaxed);
+        atomic_store_explicit(&s_tail->next, metric, memory_order_release);
+        s_tail = metric;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+const metric_t *metrics_first(void)
+{
+    return s_head;
+}
+
+uint32_t metric_value(const metric_t *metric)
+{
+    if (metric->sample != NULL) {
+        return metric->sample();
+    }
+    return atomic_load_explicit(&metric->value, memory_order_relaxed);
+}
+
+static inline size_t bucket_index(uint32_t value)
+{
+    if (value < 2 * HISTOGRAM_SUB_COUNT) {
+        return value;
+    }
+    int exponent = 31 - __builtin_clz(value);
+    uint32_t sub = (value >> (exponent - HISTOGRAM_SUB_BITS)) & (HISTOGRAM_SUB_COUNT - 1);
+    return (size_t)(exponent - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_COUNT + sub;
+}
+
+// Mayor valor que cae en la cubeta
+static uint32_t bucket_upper(size_t index)
+{
+    if (index < 2 * HISTOGRAM_SUB_COUNT) {
+        return (uint32_t)index;
+    }
+    int shift = (int)(index / HISTOGRAM_SUB_COUNT) - 1;
+    uint64_t low = (uint64_t)(HISTOGRAM_SUB_COUNT + index % HISTOGRAM_SUB_COUNT) << shift;
+    uint64_t high = low + ((uint64_t)1 << shift) - 1;
+    return (high > UINT32_MAX) ? UINT32_MAX : (uint32_t)high;
+}
+
+void metric_histogram_record(metric_t *metric, uint32_t value)
+{
+    metric_histogram_t *hist = metric->histogram;
+    _Atomic uint32_t *bucket = &hist->buckets[bucket_index(value)];
+
+    // Un solo escritor: load + store relajados, sin read-modify-write
+    atomic_store_explicit(bucket, atomic_load_explicit(bucket, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    if (value > atomic_load_explicit(&hist->max, memory_order_relaxed)) {
+        atomic_store_explicit(&hist->max, value, memory_order_relaxed);
+    }
+}
+
+void metric_histogram_get(const metric_t *metric, metric_histogram_summary_t *summary)
+{
+    const metric_histogram_t *hist = metric->histogram;
+    static const uint32_t percentiles[] = { 50, 90, 99 };
+    uint32_t *results[] = { &summary->p50, &summary->p90, &summary->p99 };
+    uint32_t counts[METRIC_HISTOGRAM_BUCKETS];
+    uint64_t total = 0;
+
+    // Copia de las cubetas: el total sale de la misma copia, así los
+    // percentiles son coherentes aunque el escritor siga sumando
+    for (size_t i = 0; i < METRIC_HISTOGRAM_BUCKETS; i++) {
+        counts[i] = atomic_load_explicit(&hist->buckets[i], memory_order_relaxed);
+        total += counts[i];
+    }
+    summary->count = (uint32_t)total;
+    summary->max = atomic_load_explicit(&hist->max, memory_order_relaxed);
+
+    size_t bucket = 0;
+    uint64_t seen = 0;
+    for (size_t p = 0; p < sizeof(percentiles) / sizeof(percentiles[0]); p++) {
+        uint64_t rank = (total * percentiles[p] + 99) / 100;
+        if (rank == 0) {
+            *results[p] = 0;
+            continue;
+        }
+        while (bucket < METRIC_HISTOGRAM_BUCKETS && seen + counts[bucket] < rank) {
+            seen += counts[bucket++];
+        }
+        uint32_t upper = bucket_upper(bucket);
+        *results[p] = (upper < summary->max) ? upper : summary->max;
+    }
+}
+
+size_t metrics_format_json(char *buf, size_t size)
+{
+    size_t len = 0;
+    int written;
+
+    for (const metric_t *metric = metrics_first(); metric != NULL; metric = metrics_next(metric)) {
+        const char *sep = (len == 0) ? "{" : ",";
+        if (metric->type == METRIC_TYPE_HISTOGRAM) {
+            metric_histogram_summary_t summary;
+            metric_histogram_get(metric, &summary);
+            written = snprintf(buf + len, size - len, "%s\"%s\":[%lu,%lu,%lu,%lu,%lu]", sep, metric->name,
+                               (unsigned long)summary.count, (unsigned long)summary.p50,
+                               (unsigned long)summary.p90, (unsigned long)summary.p99,
+                               (unsigned long)summary.max);
+        } else {
+            written = snprintf(buf + len, size - len, "%s\"%s\":%lu", sep, metric->name,
+                               (unsigned long)metric_value(metric));
+        }
+        if (written < 0 || (size_t)written >= size - len) {
+            return 0;
+        }
+        len += written;
+    }
+    if (len + 2 > size) {
+        return 0;
+    }
+    buf[len++] = '}';
+    buf[len] = '\0';
+    return len;
+}
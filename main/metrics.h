@@ -0,0 +1,141 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Buckets of a histogram: 4 per power of two over the 32-bit range */
+#define METRIC_HISTOGRAM_BUCKETS 124
+
+typedef enum {
+    METRIC_TYPE_COUNTER = 0,  /**< Monotonic count since boot */
+    METRIC_TYPE_GAUGE,        /**< Current value */
+    METRIC_TYPE_HISTOGRAM,    /**< Distribution, reported as percentiles */
+} metric_type_t;
+
+/**
+ * @brief Storage of a histogram metric
+ */
+typedef struct {
+    _Atomic uint32_t buckets[METRIC_HISTOGRAM_BUCKETS];
+    _Atomic uint32_t max;
+} metric_histogram_t;
+
+/**
+ * @brief Percentiles of a histogram; within 25% of the true value
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t p50;
+    uint32_t p90;
+    uint32_t p99;
+    uint32_t max;
+} metric_histogram_summary_t;
+
+/**
+ * @brief One registered metric
+ *
+ * Declare it static in the owning module with one of the METRIC_*_INIT
+ * initializers and pass it to metrics_register() once at startup.
+ */
+typedef struct metric {
+    const char *name;                /**< "subsystem.name", shown as is */
+    metric_type_t type;
+    _Atomic uint32_t value;          /**< Counter or gauge value */
+    uint32_t (*sample)(void);        /**< If set, read at dump time instead of value */
+    metric_histogram_t *histogram;   /**< Histogram storage */
+    struct metric *_Atomic next;
+    bool registered;
+} metric_t;
+
+#define METRIC_COUNTER_INIT(metric_name)        { .name = (metric_name), .type = METRIC_TYPE_COUNTER }
+#define METRIC_GAUGE_INIT(metric_name)          { .name = (metric_name), .type = METRIC_TYPE_GAUGE }
+#define METRIC_SAMPLED_INIT(metric_name, type_, fn) \
+    { .name = (metric_name), .type = (type_), .sample = (fn) }
+#define METRIC_HISTOGRAM_INIT(metric_name, storage) \
+    { .name = (metric_name), .type = METRIC_TYPE_HISTOGRAM, .histogram = (storage) }
+
+/**
+ * @brief Add a metric to the registry (any task, idempotent)
+ *
+ * Registration takes a short critical section; updates and dumps never lock.
+ */
+void metrics_register(metric_t *metric);
+
+/**
+ * @brief First registered metric; follow metric->next for the rest
+ *
+ * Safe from any task while others register: a metric is fully initialized
+ * before it becomes reachable.
+ */
+const metric_t *metrics_first(void);
+
+/**
+ * @brief Next registered metric, or NULL
+ */
+static inline const metric_t *metrics_next(const metric_t *metric)
+{
+    return atomic_load_explicit(&metric->next, memory_order_acquire);
+}
+
+/**
+ * @brief Add n to a counter (any task, one relaxed atomic add)
+ */
+static inline void metric_add(metric_t *metric, uint32_t n)
+{
+    atomic_fetch_add_explicit(&metric->value, n, memory_order_relaxed);
+}
+
+static inline void metric_inc(metric_t *metric)
+{
+    metric_add(metric, 1);
+}
+
+/**
+ * @brief Set a gauge
+ */
+static inline void metric_set(metric_t *metric, uint32_t value)
+{
+    atomic_store_explicit(&metric->value, value, memory_order_relaxed);
+}
+
+/**
+ * @brief Current value of a counter or gauge (calls its sample function if any)
+ */
+uint32_t metric_value(const metric_t *metric);
+
+/**
+ * @brief Add one sample to a histogram
+ *
+ * Each histogram must have a single writer task: the update is a relaxed
+ * load and store, with no read-modify-write.
+ */
+void metric_histogram_record(metric_t *metric, uint32_t value);
+
+/**
+ * @brief Compute the percentiles of a histogram (any task)
+ */
+void metric_histogram_get(const metric_t *metric, metric_histogram_summary_t *summary);
+
+/**
+ * @brief Write a compact JSON snapshot of every metric into buf
+ *
+ * Counters and gauges are plain numbers; histograms are arrays
+ * [count, p50, p90, p99, max]:
+ * {"coap.requests":120,...,"latency.queue":[118,1535,6143,12287,15001]}
+ *
+ * @return Length written, or 0 if buf is too small
+ */
+size_t metrics_format_json(char *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METRICS_H
@@ -0,0 +1,114 @@
+#include "pipeline_bench.h"
+#include <stdatomic.h>
+#include "esp_log.h"
+#include "esp_openthread_lock.h"
+#include "esp_timer.h"
+#include "device_registry.h"
+#include "sensor_class.h"
+#include "sensor_latency.h"
+#include "sdkconfig.h"
+#include "sensor_pipeline.h"
+#include "task_placement.h"
+
+static const char *TAG = "PIPELINE_BENCH";
+
+// Lecturas por toma del lock de OpenThread: el mainloop sigue atendiendo la
+// radio entre ráfagas
+#define BENCH_BURST         16
+#define BENCH_DRAIN_TIMEOUT_US  (60 * 1000 * 1000)
+
+static _Atomic bool s_running = false;
+
+// Productor sintético: hace de handler CoAP (mismo núcleo, mismo lock) y
+// mide cuánto tarda aws_iot_task en vaciar el pipeline
+static void bench_task(void *arg)
+{
+    uint32_t count = (uint32_t)(uintptr_t)arg;
+    // Handle reservado: el benchmark no ocupa un hueco del registro
+    uint16_t device = DEVICE_HANDLE_BENCH;
+    spsc_ring_stats_t stats;
+    uint32_t sent = 0;
+    uint32_t full_waits = 0;
+
+    ESP_LOGI(TAG, "Ingest benchmark: %lu readings on core %d", (unsigned long)count, xPortGetCoreID());
+    int64_t start = esp_timer_get_time();
+
+    while (sent < count) {
+        // Solo se reserva lo que cabe, para no inflar el contador de descartes
+        sensor_pipeline_get_stats(&stats);
+        uint32_t room = stats.capacity - stats.used;
+        uint32_t burst = (room < BENCH_BURST) ? room : BENCH_BURST;
+        if (burst > count - sent) {
+            burst = count - sent;
+        }
+        if (burst == 0) {
+            full_waits++;
+            vTaskDelay(1);
+            continue;
+        }
+
+        esp_openthread_lock_acquire(portMAX_DELAY);
+        for (uint32_t i = 0; i < burst; i++) {
+            sensor_data_t *slot = sensor_class_reserve(SENSOR_CLASS_ENVIRONMENT);
+            if (slot == NULL) {
+                break;
+            }
+            // Valores que cambian en cada lectura para que la banda muerta no los filtre
+            slot->temperature = 20.0f + (float)(sent % 100) / 10.0f;
+            slot->humidity = 40.0f + (float)(sent % 50) / 10.0f;
+            slot->pressure = 1000.0f + (float)(sent % 200) / 10.0f;
+            slot->gas_concentration = (float)(sent % 300);
+            sensor_class_commit(SENSOR_CLASS_ENVIRONMENT, slot, device, sensor_latency_now_us());
+            sent++;
+        }
+        esp_openthread_lock_release();
+    }
+    int64_t produced = esp_timer_get_time();
+
+    // Esperar a que el consumidor vacíe el ring
+    do {
+        sensor_pipeline_get_stats(&stats);
+        if (stats.used == 0) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(5));
+    } while (esp_timer_get_time() - produced < BENCH_DRAIN_TIMEOUT_US);
+    int64_t drained = esp_timer_get_time();
+
+    uint64_t total_us = (drained > start) ? (uint64_t)(drained - start) : 1;
+    sensor_latency_summary_t queue;
+    sensor_latency_get(SENSOR_LATENCY_QUEUE, &queue);
+
+    ESP_LOGI(TAG, "===== Ingest benchmark (%lu readings) =====", (unsigned long)count);
+    ESP_LOGI(TAG, "  Placement: OpenThread core %d | cloud core %d (-1 = any)",
+             CONFIG_TASK_CORE_OPENTHREAD, CONFIG_TASK_CORE_CLOUD);
+    ESP_LOGI(TAG, "  Produce: %lu ms | drain: %lu ms | ring full waits: %lu",
+             (unsigned long)((produced - start) / 1000), (unsigned long)((drained - produced) / 1000),
+             (unsigned long)full_waits);
+    ESP_LOGI(TAG, "  Ingest capacity: %lu readings/s",
+             (unsigned long)((uint64_t)count * 1000000 / total_us));
+    ESP_LOGI(TAG, "  Queue latency since boot: p50 %lu us | p99 %lu us",
+             (unsigned long)queue.p50_us, (unsigned long)queue.p99_us);
+    if (stats.used > 0) {
+        ESP_LOGW(TAG, "  %lu readings still queued after %d s (is MQTT connected?)",
+                 (unsigned long)stats.used, BENCH_DRAIN_TIMEOUT_US / 1000000);
+    }
+
+    atomic_store(&s_running, false);
+    vTaskDelete(NULL);
+}
+
+bool pipeline_bench_start(uint32_t count)
+{
+    bool expected = false;
+
+    if (count == 0 || !atomic_compare_exchange_strong(&s_running, &expected, true)) {
+        return false;
+    }
+    if (xTaskCreatePinnedToCore(bench_task, "pipeline_bench", 3072, (void *)(uintptr_t)count, 5, NULL,
+                                TASK_CORE_OPENTHREAD) != pdPASS) {
+        atomic_store(&s_running, false);
+        return false;
+    }
+    return true;
+}
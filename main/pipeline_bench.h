@@ -0,0 +1,30 @@
+#ifndef PIPELINE_BENCH_H
+#define PIPELINE_BENCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start an ingest capacity benchmark in the background
+ *
+ * A task pinned like the OpenThread mainloop pushes count synthetic
+ * readings (device "bench") into the sensor pipeline under the OpenThread
+ * lock, as the CoAP handler would, as fast as the ring accepts them. It
+ * then waits for aws_iot_task to drain the ring and logs readings per
+ * second, so task placement plans can be compared on the same board. The
+ * readings are published like real ones.
+ *
+ * @return false if count is 0, a benchmark is already running, or the task
+ *         could not be created
+ */
+bool pipeline_bench_start(uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PIPELINE_BENCH_H
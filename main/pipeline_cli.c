@@ -0,0 +1,119 @@
+#include "pipeline_cli.h"
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_openthread.h"
+#include "openthread/cli.h"
+#include "metrics.h"
+#include "pipeline_bench.h"
+#include "sensor_latency.h"
+#include "serializer_bench.h"
+
+static const char *TAG = "PIPELINE_CLI";
+
+// serbench corre en la tarea de OpenThread: tope para no retener la radio
+#define SERBENCH_MAX_ITERATIONS 5000
+
+// latency: histogramas de la llegada CoAP al PUBACK, en microsegundos
+static otError latency_command(void *context, uint8_t argc, char *argv[])
+{
+    (void)context;
+    (void)argc;
+    (void)argv;
+
+    otCliOutputFormat("%-10s %10s %10s %10s %10s %10s\r\n", "stage", "count", "p50_us", "p90_us", "p99_us", "max_us");
+    for (int stage = 0; stage < SENSOR_LATENCY_STAGE_COUNT; stage++) {
+        sensor_latency_summary_t summary;
+        sensor_latency_get((sensor_latency_stage_t)stage, &summary);
+        otCliOutputFormat("%-10s %10lu %10lu %10lu %10lu %10lu\r\n",
+                          sensor_latency_stage_name((sensor_latency_stage_t)stage),
+                          (unsigned long)summary.count, (unsigned long)summary.p50_us,
+                          (unsigned long)summary.p90_us, (unsigned long)summary.p99_us,
+                          (unsigned long)summary.max_us);
+    }
+    return OT_ERROR_NONE;
+}
+
+// metrics: volcado del registro de métricas en orden de registro
+static otError metrics_command(void *context, uint8_t argc, char *argv[])
+{
+    static const char *const types[] = {
+        [METRIC_TYPE_COUNTER] = "counter",
+        [METRIC_TYPE_GAUGE] = "gauge",
+        [METRIC_TYPE_HISTOGRAM] = "hist",
+    };
+    (void)context;
+
+    for (const metric_t *metric = metrics_first(); metric != NULL; metric = metrics_next(metric)) {
+        // Con argumento solo se muestran las métricas con ese prefijo (p. ej. "metrics mqtt")
+        if (argc > 0 && strncmp(metric->name, argv[0], strlen(argv[0])) != 0) {
+            continue;
+        }
+        if (metric->type == METRIC_TYPE_HISTOGRAM) {
+            metric_histogram_summary_t summary;
+            metric_histogram_get(metric, &summary);
+            otCliOutputFormat("%-22s %-7s n=%lu p50=%lu p90=%lu p99=%lu max=%lu\r\n", metric->name,
+                              types[metric->type], (unsigned long)summary.count,
+                              (unsigned long)summary.p50, (unsigned long)summary.p90,
+                              (unsigned long)summary.p99, (unsigned long)summary.max);
+        } else {
+            otCliOutputFormat("%-22s %-7s %lu\r\n", metric->name, types[metric->type],
+                              (unsigned long)metric_value(metric));
+        }
+    }
+    return OT_ERROR_NONE;
+}
+
+// bench <n>: prueba de capacidad de ingesta con n lecturas sintéticas; el
+// resultado sale por el log al terminar
+static otError bench_command(void *context, uint8_t argc, char *argv[])
+{
+    (void)context;
+
+    if (argc != 1) {
+        otCliOutputFormat("usage: bench <readings>\r\n");
+        return OT_ERROR_INVALID_ARGS;
+    }
+    uint32_t count = (uint32_t)strtoul(argv[0], NULL, 10);
+    if (!pipeline_bench_start(count)) {
+        otCliOutputFormat("benchmark not started (busy or invalid count)\r\n");
+        return OT_ERROR_INVALID_STATE;
+    }
+    otCliOutputFormat("benchmark started, results in the log\r\n");
+    return OT_ERROR_NONE;
+}
+
+// serbench <n>: codificador de lecturas frente al snprintf de referencia
+// ("%.2f", o entero y centésimas con el printf de newlib nano)
+static otError serbench_command(void *context, uint8_t argc, char *argv[])
+{
+    serializer_bench_result_t result;
+    (void)context;
+
+    uint32_t iterations = (argc == 1) ? (uint32_t)strtoul(argv[0], NULL, 10) : 0;
+    if (iterations == 0 || iterations > SERBENCH_MAX_ITERATIONS) {
+        otCliOutputFormat("usage: serbench <iterations 1..%d>\r\n", SERBENCH_MAX_ITERATIONS);
+        return OT_ERROR_INVALID_ARGS;
+    }
+    serializer_bench_run(iterations, &result);
+    otCliOutputFormat("snprintf%s %lu ns | serializer %lu ns per reading | mismatches %lu\r\n",
+                      result.integer_split ? " (int.frac)" : "", (unsigned long)result.snprintf_ns,
+                      (unsigned long)result.serializer_ns, (unsigned long)result.mismatches);
+    return OT_ERROR_NONE;
+}
+
+static const otCliCommand s_commands[] = {
+    { "latency", latency_command },
+    { "metrics", metrics_command },
+    { "bench", bench_command },
+    { "serbench", serbench_command },
+};
+
+void register_pipeline_commands(void)
+{
+    otError error = otCliSetUserCommands(s_commands, sizeof(s_commands) / sizeof(s_commands[0]),
+                                         esp_openthread_get_instance());
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to register pipeline CLI commands (error %d)", error);
+    }
+}
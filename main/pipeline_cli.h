@@ -0,0 +1,23 @@
+#ifndef PIPELINE_CLI_H
+#define PIPELINE_CLI_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Register the sensor pipeline diagnostic commands in the OpenThread CLI
+ *
+ * Adds "latency" (per-stage p50/p90/p99/max since boot), "metrics [prefix]"
+ * (dump of the metrics registry), "bench <readings>" (ingest capacity
+ * benchmark, see pipeline_bench.h) and "serbench <iterations>" (reading
+ * encoder against snprintf, see serializer_bench.h). Must be called with the
+ * OpenThread lock held, after esp_openthread_cli_init().
+ */
+void register_pipeline_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PIPELINE_CLI_H
@@ -0,0 +1,274 @@
+#include "sensor_aggregate.h"
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+#include "device_registry.h"
+#include "sdkconfig.h"
+
+#define AGGREGATE_WINDOW_MS     CONFIG_SENSOR_AGGREGATE_WINDOW_MS
+#define AGGREGATE_MAX_DEVICES   CONFIG_SENSOR_AGGREGATE_MAX_DEVICES
+#define AGGREGATE_PASSTHROUGH   CONFIG_SENSOR_AGGREGATE_PASSTHROUGH
+
+_Static_assert((AGGREGATE_MAX_DEVICES & (AGGREGATE_MAX_DEVICES - 1)) == 0,
+               "CONFIG_SENSOR_AGGREGATE_MAX_DEVICES must be a power of two");
+// Una entrada se borra tras una ventana entera sin lecturas: cuando el
+// registro reutiliza el handle de un dispositivo callado ya no quedan
+// lecturas suyas por resumir. Si la entrada aún no se ha borrado, la
+// generación del handle delata el cambio de dueño y se rehace.
+_Static_assert(2ULL * AGGREGATE_WINDOW_MS < CONFIG_SENSOR_REGISTRY_IDLE_S * 1000ULL,
+               "CONFIG_SENSOR_REGISTRY_IDLE_S must exceed twice CONFIG_SENSOR_AGGREGATE_WINDOW_MS");
+
+// El resumen publicado se construye en sitio; la media se calcula al vaciar.
+// En una entrada de paso start_ms es la última lectura, para que caduque
+// como las demás.
+struct sensor_aggregate_entry {
+    bool in_use;
+    bool passthrough;
+    uint16_t generation;  // del handle en el registro: otra = otro dispositivo
+    uint32_t start_ms;
+    float sum[SENSOR_METRIC_COUNT];
+    sensor_summary_t summary;
+};
+
+// Tabla hash de direccionamiento abierto con sondeo lineal. Se deja siempre
+// un hueco libre para que toda búsqueda termine.
+static sensor_aggregate_entry_t s_table[AGGREGATE_MAX_DEVICES];
+static uint32_t s_used = 0;
+static sensor_aggregate_stats_t s_stats;
+
+// Hash multiplicativo (Fibonacci) del handle: los handles son consecutivos
+static inline uint32_t hash_device(uint16_t device)
+{
+    return (device * 2654435769u) >> 16;
+}
+
+// ¿Está el dispositivo en la lista separada por comas de CONFIG_SENSOR_AGGREGATE_PASSTHROUGH?
+static bool is_passthrough(uint16_t device)
+{
+    const char *list = AGGREGATE_PASSTHROUGH;
+    const char *device_id = device_registry_name(device);
+    size_t len = strlen(device_id);
+
+    while (*list != '\0') {
+        const char *end = strchr(list, ',');
+        size_t token = end ? (size_t)(end - list) : strlen(list);
+        if (token == len && strncmp(list, device_id, len) == 0) {
+            return true;
+        }
+        if (end == NULL) {
+            break;
+        }
+        list = end + 1;
+    }
+    return false;
+}
+
+static void reset_window(sensor_aggregate_entry_t *entry, uint32_t now_ms)
+{
+    entry->start_ms = now_ms;
+    entry->summary.readings = 0;
+    memset(entry->sum, 0, sizeof(entry->sum));
+    memset(entry->summary.metrics, 0, sizeof(entry->summary.metrics));
+}
+
+static void init_entry(sensor_aggregate_entry_t *entry, uint16_t device, uint16_t generation, uint32_t now_ms)
+{
+    memset(entry, 0, sizeof(*entry));
+    entry->in_use = true;
+    entry->generation = generation;
+    entry->summary.device = device;
+    entry->passthrough = is_passthrough(device);
+    reset_window(entry, now_ms);
+}
+
+// Borrado con desplazamiento hacia atrás: las entradas siguientes del mismo
+// racimo se recolocan para no dejar lápidas
+static void remove_entry(size_t index)
+{
+    const uint32_t mask = AGGREGATE_MAX_DEVICES - 1;
+    size_t hole = index;
+    size_t next = (index + 1) & mask;
+
+    while (s_table[next].in_use) {
+        size_t home = hash_device(s_table[next].summary.device) & mask;
+        // La entrada puede ocupar el hueco si su posición ideal no está
+        // entre el hueco (exclusive) y ella misma (inclusive)
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            s_table[hole] = s_table[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    memset(&s_table[hole], 0, sizeof(s_table[hole]));
+    s_used--;
+}
+
+// Entrada del dispositivo, o NULL dejando en *free_slot el hueco libre que
+// cierra su racimo
+static sensor_aggregate_entry_t *find_entry(uint16_t device, size_t *free_slot)
+{
+    const uint32_t mask = AGGREGATE_MAX_DEVICES - 1;
+    size_t index = hash_device(device) & mask;
+
+    while (s_table[index].in_use) {
+        if (s_table[index].summary.device == device) {
+            return &s_table[index];
+        }
+        index = (index + 1) & mask;
+    }
+    *free_slot = index;
+    return NULL;
+}
+
+sensor_aggregate_entry_t *sensor_aggregate_lookup(const sensor_data_t *reading, uint32_t now_ms)
+{
+    size_t index;
+
+    if (AGGREGATE_WINDOW_MS == 0) {
+        return NULL;
+    }
+
+    uint16_t generation = device_registry_generation(reading->device);
+    sensor_aggregate_entry_t *entry = find_entry(reading->device, &index);
+    if (entry == NULL) {
+        if (s_used >= AGGREGATE_MAX_DEVICES - 1) {
+            return NULL;
+        }
+        entry = &s_table[index];
+        init_entry(entry, reading->device, generation, now_ms);
+        s_used++;
+    } else if (entry->generation != generation) {
+        init_entry(entry, reading->device, generation, now_ms);
+    }
+
+    if (entry->passthrough) {
+        entry->start_ms = now_ms;
+        return NULL;
+    }
+    return entry;
+}
+
+void sensor_aggregate_count_raw(const sensor_data_t *reading)
+{
+    size_t index;
+
+    if (AGGREGATE_WINDOW_MS == 0) {
+        return;
+    }
+    // La tabla no ha cambiado desde sensor_aggregate_lookup(): sin entrada,
+    // la lectura se quedó fuera porque estaba llena
+    const sensor_aggregate_entry_t *entry = find_entry(reading->device, &index);
+    if (entry == NULL) {
+        s_stats.overflow++;
+    } else if (entry->passthrough) {
+        s_stats.passthrough++;
+    }
+}
+
+void sensor_aggregate_add(sensor_aggregate_entry_t *entry, const sensor_data_t *reading)
+{
+    sensor_summary_t *summary = &entry->summary;
+
+    for (int m = 0; m < SENSOR_METRIC_COUNT; m++) {
+        float value = sensor_data_metric(reading, (sensor_metric_t)m);
+        if (!isfinite(value)) {
+            continue;
+        }
+        sensor_metric_summary_t *metric = &summary->metrics[m];
+        if (metric->count == 0 || value < metric->min) {
+            metric->min = value;
+        }
+        if (metric->count == 0 || value > metric->max) {
+            metric->max = value;
+        }
+        metric->last = value;
+        metric->count++;
+        entry->sum[m] += value;
+    }
+    summary->readings++;
+    summary->boot = reading->boot;
+    summary->seq = reading->seq;
+    s_stats.absorbed++;
+}
+
+static inline bool window_elapsed(const sensor_aggregate_entry_t *entry, uint32_t now_ms)
+{
+    return entry->in_use && now_ms - entry->start_ms >= AGGREGATE_WINDOW_MS;
+}
+
+static inline bool window_due(const sensor_aggregate_entry_t *entry, uint32_t now_ms)
+{
+    return !entry->passthrough && window_elapsed(entry, now_ms);
+}
+
+size_t sensor_aggregate_peek_due(uint32_t now_ms, sensor_summary_t *out, size_t max)
+{
+    size_t count = 0;
+
+    // Dispositivos callados durante toda su ventana, también los de paso:
+    // liberar su hueco. Tras un borrado se vuelve a mirar la misma posición,
+    // que puede haber recibido una entrada desplazada.
+    for (size_t i = 0; i < AGGREGATE_MAX_DEVICES;) {
+        if (window_elapsed(&s_table[i], now_ms) && s_table[i].summary.readings == 0) {
+            remove_entry(i);
+        } else {
+            i++;
+        }
+    }
+
+    for (size_t i = 0; i < AGGREGATE_MAX_DEVICES && count < max; i++) {
+        sensor_aggregate_entry_t *entry = &s_table[i];
+        if (!window_due(entry, now_ms)) {
+            continue;
+        }
+        out[count] = entry->summary;
+        out[count].window_ms = now_ms - entry->start_ms;
+        for (int m = 0; m < SENSOR_METRIC_COUNT; m++) {
+            sensor_metric_summary_t *metric = &out[count].metrics[m];
+            metric->mean = (metric->count > 0) ? entry->sum[m] / metric->count : NAN;
+        }
+        count++;
+    }
+    return count;
+}
+
+void sensor_aggregate_flushed(const sensor_summary_t *summaries, size_t count, uint32_t now_ms)
+{
+    for (size_t i = 0; i < AGGREGATE_MAX_DEVICES && count > 0; i++) {
+        sensor_aggregate_entry_t *entry = &s_table[i];
+        if (!entry->in_use) {
+            continue;
+        }
+        for (size_t j = 0; j < count; j++) {
+            if (entry->summary.device == summaries[j].device) {
+                reset_window(entry, now_ms);
+                s_stats.summaries++;
+                break;
+            }
+        }
+    }
+}
+
+uint32_t sensor_aggregate_next_due_ms(uint32_t now_ms)
+{
+    uint32_t next = UINT32_MAX;
+
+    for (size_t i = 0; i < AGGREGATE_MAX_DEVICES; i++) {
+        const sensor_aggregate_entry_t *entry = &s_table[i];
+        if (!entry->in_use || entry->passthrough) {
+            continue;
+        }
+        uint32_t elapsed = now_ms - entry->start_ms;
+        uint32_t remaining = (elapsed >= AGGREGATE_WINDOW_MS) ? 0 : AGGREGATE_WINDOW_MS - elapsed;
+        if (remaining < next) {
+            next = remaining;
+        }
+    }
+    return next;
+}
+
+void sensor_aggregate_get_stats(sensor_aggregate_stats_t *stats)
+{
+    *stats = s_stats;
+    stats->devices = s_used;
+}
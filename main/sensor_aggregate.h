@@ -0,0 +1,117 @@
+#ifndef SENSOR_AGGREGATE_H
+#define SENSOR_AGGREGATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "shared_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Running statistics of one metric over an aggregation window
+ */
+typedef struct {
+    float min;
+    float max;
+    float mean;
+    float last;
+    uint32_t count;  /**< Readings that carried this metric (0 = omitted) */
+} sensor_metric_summary_t;
+
+/**
+ * @brief One device's summary for one aggregation window
+ */
+typedef struct {
+    uint16_t device;     /**< Device handle (see device_registry.h) */
+    uint32_t readings;   /**< Readings folded into the summary */
+    uint32_t window_ms;  /**< Time covered, from the window start to the flush */
+    uint16_t boot;       /**< Boot counter of the last reading */
+    uint32_t seq;        /**< Sequence number of the last reading */
+    sensor_metric_summary_t metrics[SENSOR_METRIC_COUNT];
+} sensor_summary_t;
+
+/**
+ * @brief Aggregation counters
+ */
+typedef struct {
+    uint32_t devices;      /**< Devices currently in the table */
+    uint32_t absorbed;     /**< Readings folded into summaries */
+    uint32_t summaries;    /**< Summaries flushed */
+    uint32_t passthrough;  /**< Readings published raw */
+    uint32_t overflow;     /**< Readings published raw because the table was full */
+} sensor_aggregate_stats_t;
+
+/**
+ * @brief Opaque per-device aggregation entry
+ */
+typedef struct sensor_aggregate_entry sensor_aggregate_entry_t;
+
+/**
+ * @brief Find or create the aggregation entry for a reading's device
+ *
+ * The table is a fixed-size open-addressing hash table keyed by device handle,
+ * sized with CONFIG_SENSOR_AGGREGATE_MAX_DEVICES. An entry left by an earlier
+ * owner of the handle (see device_registry_generation()) is rebuilt for the
+ * new device. All aggregation functions must be called from the AWS task
+ * only.
+ *
+ * @param reading Reading whose device is looked up
+ * @param now_ms  Current time, starts the window of a new device
+ * @return Entry to pass to sensor_aggregate_add(), or NULL if the reading
+ *         must be published raw: aggregation disabled
+ *         (CONFIG_SENSOR_AGGREGATE_WINDOW_MS = 0), device listed in
+ *         CONFIG_SENSOR_AGGREGATE_PASSTHROUGH, or table full
+ */
+sensor_aggregate_entry_t *sensor_aggregate_lookup(const sensor_data_t *reading, uint32_t now_ms);
+
+/**
+ * @brief Count a reading that sensor_aggregate_lookup() sent raw
+ *
+ * Adds it to the passthrough or overflow counter. Call it once the reading
+ * is released, next to sensor_aggregate_add() for the aggregated ones and
+ * before the table changes again, so a reading looked up more than once
+ * (left in the ring for the next batch) is counted only once.
+ */
+void sensor_aggregate_count_raw(const sensor_data_t *reading);
+
+/**
+ * @brief Fold a reading into its device's running min/max/mean/last
+ */
+void sensor_aggregate_add(sensor_aggregate_entry_t *entry, const sensor_data_t *reading);
+
+/**
+ * @brief Copy the summaries whose window has elapsed, without resetting them
+ *
+ * Devices that sent nothing during their last window, passthrough ones
+ * included, are dropped from the table here, so quiet devices free their
+ * slot.
+ *
+ * @return Number of summaries copied into out
+ */
+size_t sensor_aggregate_peek_due(uint32_t now_ms, sensor_summary_t *out, size_t max);
+
+/**
+ * @brief Start a new window for the first count summaries returned by
+ *        sensor_aggregate_peek_due(), once they have been handed to MQTT
+ */
+void sensor_aggregate_flushed(const sensor_summary_t *summaries, size_t count, uint32_t now_ms);
+
+/**
+ * @brief Milliseconds until the next window closes
+ *
+ * @return Time to wait, or UINT32_MAX if no window is open
+ */
+uint32_t sensor_aggregate_next_due_ms(uint32_t now_ms);
+
+/**
+ * @brief Read the aggregation counters
+ */
+void sensor_aggregate_get_stats(sensor_aggregate_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SENSOR_AGGREGATE_H
@@ -0,0 +1,222 @@
+#include "sensor_class.h"
+#include <stdatomic.h>
+#include <unistd.h>
+#include "device_registry.h"
+#include "esp_log.h"
+#include "esp_vfs_eventfd.h"
+#include "metrics.h"
+#include "sdkconfig.h"
+#include "sensor_pipeline.h"
+
+static const char *TAG = "SENSOR_CLASS";
+
+#define SENSOR_CLASS_QUEUE_DEPTH CONFIG_SENSOR_CLASS_QUEUE_DEPTH
+
+_Static_assert((SENSOR_CLASS_QUEUE_DEPTH & (SENSOR_CLASS_QUEUE_DEPTH - 1)) == 0,
+               "CONFIG_SENSOR_CLASS_QUEUE_DEPTH must be a power of two");
+
+#define FIELD(record, member, frame_type, decimals, key) \
+    { (frame_type), (decimals), offsetof(record, member), (key) }
+
+static const sensor_frame_field_t s_air_quality_fields[] = {
+    FIELD(air_quality_data_t, co2_ppm, SENSOR_FRAME_M_CO2, 0, "co2"),
+    FIELD(air_quality_data_t, voc_index, SENSOR_FRAME_M_VOC_INDEX, 0, "voc"),
+    FIELD(air_quality_data_t, pm2_5, SENSOR_FRAME_M_PM2_5, 2, "pm25"),
+    FIELD(air_quality_data_t, pm10, SENSOR_FRAME_M_PM10, 2, "pm10"),
+};
+
+static const sensor_frame_field_t s_energy_fields[] = {
+    FIELD(energy_data_t, voltage, SENSOR_FRAME_M_VOLTAGE, 2, "v"),
+    FIELD(energy_data_t, current, SENSOR_FRAME_M_CURRENT, 2, "a"),
+    FIELD(energy_data_t, power, SENSOR_FRAME_M_POWER, 2, "w"),
+    FIELD(energy_data_t, energy_wh, SENSOR_FRAME_M_ENERGY, 0, "wh"),
+};
+
+static const sensor_frame_field_t s_occupancy_fields[] = {
+    FIELD(occupancy_data_t, occupied, SENSOR_FRAME_M_OCCUPIED, 0, "occ"),
+    FIELD(occupancy_data_t, people, SENSOR_FRAME_M_PEOPLE, 0, "people"),
+    FIELD(occupancy_data_t, illuminance, SENSOR_FRAME_M_ILLUMINANCE, 0, "lux"),
+};
+
+#define FIELDS(table) (table), sizeof(table) / sizeof((table)[0])
+
+// Tabla de clases: un recurso CoAP, un decodificador, una cola y un tópico
+// por clase. Añadir una clase es añadir su registro, su tabla de campos y
+// una entrada aquí.
+static const sensor_class_info_t s_classes[SENSOR_CLASS_COUNT] = {
+    [SENSOR_CLASS_ENVIRONMENT] = {
+        .name = "environment", .uri = "sensordata", .topic = NULL,
+        .fields = sensor_frame_environment_fields, .field_count = SENSOR_METRIC_COUNT,
+        .record_size = sizeof(sensor_data_t),
+    },
+    [SENSOR_CLASS_AIR_QUALITY] = {
+        .name = "air_quality", .uri = "airquality", .topic = "thread/aire/%s",
+        .fields = FIELDS(s_air_quality_fields), .record_size = sizeof(air_quality_data_t),
+    },
+    [SENSOR_CLASS_ENERGY] = {
+        .name = "energy", .uri = "energy", .topic = "thread/energia/%s",
+        .fields = FIELDS(s_energy_fields), .record_size = sizeof(energy_data_t),
+    },
+    [SENSOR_CLASS_OCCUPANCY] = {
+        .name = "occupancy", .uri = "occupancy", .topic = "thread/ocupacion/%s",
+        .fields = FIELDS(s_occupancy_fields), .record_size = sizeof(occupancy_data_t),
+    },
+};
+
+// Una cola por clase tipada, con slots de su propio tipo. Productor: mainloop
+// de OpenThread; consumidor: aws_iot_task.
+static air_quality_data_t s_air_quality_slots[SENSOR_CLASS_QUEUE_DEPTH];
+static energy_data_t s_energy_slots[SENSOR_CLASS_QUEUE_DEPTH];
+static occupancy_data_t s_occupancy_slots[SENSOR_CLASS_QUEUE_DEPTH];
+
+static void *const s_storage[SENSOR_CLASS_COUNT] = {
+    [SENSOR_CLASS_AIR_QUALITY] = s_air_quality_slots,
+    [SENSOR_CLASS_ENERGY] = s_energy_slots,
+    [SENSOR_CLASS_OCCUPANCY] = s_occupancy_slots,
+};
+
+static spsc_ring_t s_rings[SENSOR_CLASS_COUNT];
+
+// eventfd común a las colas tipadas
+static _Atomic int s_event_fd = -1;
+
+static uint32_t sample_dropped(void)
+{
+    uint32_t dropped = 0;
+
+    for (int cls = SENSOR_CLASS_ENVIRONMENT + 1; cls < SENSOR_CLASS_COUNT; cls++) {
+        spsc_ring_stats_t stats;
+        spsc_ring_get_stats(&s_rings[cls], &stats);
+        dropped += stats.dropped;
+    }
+    return dropped;
+}
+
+static metric_t s_metric_dropped = METRIC_SAMPLED_INIT("queue.class_dropped", METRIC_TYPE_COUNTER, sample_dropped);
+
+esp_err_t sensor_class_init(void)
+{
+    for (int cls = SENSOR_CLASS_ENVIRONMENT + 1; cls < SENSOR_CLASS_COUNT; cls++) {
+        esp_err_t err = spsc_ring_init(&s_rings[cls], s_storage[cls], s_classes[cls].record_size,
+                                       SENSOR_CLASS_QUEUE_DEPTH);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create %s ring: %s", s_classes[cls].name, esp_err_to_name(err));
+            return err;
+        }
+    }
+    metrics_register(&s_metric_dropped);
+
+    ESP_LOGI(TAG, "%d sensor classes, %d slots per typed queue", SENSOR_CLASS_COUNT, SENSOR_CLASS_QUEUE_DEPTH);
+    return ESP_OK;
+}
+
+const sensor_class_info_t *sensor_class_get(sensor_class_t cls)
+{
+    return &s_classes[cls];
+}
+
+esp_err_t sensor_class_decode(sensor_class_t cls, sensor_frame_reader_t *reader, void *record)
+{
+    return sensor_frame_next_fields(reader, s_classes[cls].fields, s_classes[cls].field_count, record);
+}
+
+void *sensor_class_reserve(sensor_class_t cls)
+{
+    if (cls == SENSOR_CLASS_ENVIRONMENT) {
+        return sensor_pipeline_reserve();
+    }
+    return spsc_ring_reserve(&s_rings[cls]);
+}
+
+void sensor_class_commit(sensor_class_t cls, void *slot, uint16_t device, uint32_t ingest_us)
+{
+    if (cls == SENSOR_CLASS_ENVIRONMENT) {
+        sensor_data_t *data = slot;
+        data->device = device;
+        data->ingest_us = ingest_us;
+        sensor_pipeline_commit(data);
+        return;
+    }
+
+    sensor_record_header_t *header = slot;
+    header->device = device;
+    header->generation = device_registry_generation(device);
+    header->ingest_us = ingest_us;
+
+    // Solo se despierta al consumidor en la transición vacío -> no vacío
+    if (spsc_ring_commit(&s_rings[cls]) == 1) {
+        int fd = atomic_load(&s_event_fd);
+        if (fd >= 0) {
+            uint64_t one = 1;
+            write(fd, &one, sizeof(one));
+        }
+    }
+}
+
+void sensor_class_abort(sensor_class_t cls, void *slot)
+{
+    // Reservar no avanza el ring: basta con no hacer commit
+    (void)cls;
+    (void)slot;
+}
+
+int sensor_class_get_eventfd(void)
+{
+    int fd = atomic_load(&s_event_fd);
+
+    if (fd < 0) {
+        fd = eventfd(0, 0);
+        if (fd < 0) {
+            ESP_LOGE(TAG, "Failed to create sensor class eventfd");
+            return -1;
+        }
+        atomic_store(&s_event_fd, fd);
+    }
+    return fd;
+}
+
+size_t sensor_class_poll(void)
+{
+    int fd = atomic_load(&s_event_fd);
+    size_t ready = 0;
+
+    // Vaciar antes de mirar las colas: un commit posterior lo vuelve a
+    // dejar legible
+    if (fd >= 0) {
+        uint64_t value;
+        read(fd, &value, sizeof(value));
+    }
+    for (int cls = SENSOR_CLASS_ENVIRONMENT + 1; cls < SENSOR_CLASS_COUNT; cls++) {
+        ready += spsc_ring_available(&s_rings[cls]);
+    }
+    return ready;
+}
+
+size_t sensor_class_receive(sensor_class_t cls, void **records, size_t max)
+{
+    if (cls == SENSOR_CLASS_ENVIRONMENT) {
+        return 0;
+    }
+
+    size_t ready = spsc_ring_available(&s_rings[cls]);
+    size_t count = (ready < max) ? ready : max;
+
+    for (size_t i = 0; i < count; i++) {
+        records[i] = spsc_ring_peek(&s_rings[cls], i);
+    }
+    return count;
+}
+
+void sensor_class_release(sensor_class_t cls, size_t count)
+{
+    spsc_ring_release(&s_rings[cls], count);
+}
+
+void sensor_class_get_stats(sensor_class_t cls, spsc_ring_stats_t *stats)
+{
+    if (cls == SENSOR_CLASS_ENVIRONMENT) {
+        sensor_pipeline_get_stats(stats);
+        return;
+    }
+    spsc_ring_get_stats(&s_rings[cls], stats);
+}
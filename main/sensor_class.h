@@ -0,0 +1,171 @@
+#ifndef SENSOR_CLASS_H
+#define SENSOR_CLASS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "shared_data.h"
+#include "sensor_frame.h"
+#include "spsc_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Kinds of Thread node, one CoAP resource each
+ *
+ * The table behind sensor_class_get() is fixed at compile time. The
+ * environment class keeps its dedicated pipeline (sensor_pipeline.h) with
+ * aggregation, deadband and flash spool; every other class gets its own
+ * bounded ring of its own record type and is published as is.
+ */
+typedef enum {
+    SENSOR_CLASS_ENVIRONMENT = 0,   /**< "sensordata": sensor_data_t */
+    SENSOR_CLASS_AIR_QUALITY,       /**< "airquality": air_quality_data_t */
+    SENSOR_CLASS_ENERGY,            /**< "energy": energy_data_t */
+    SENSOR_CLASS_OCCUPANCY,         /**< "occupancy": occupancy_data_t */
+    SENSOR_CLASS_COUNT
+} sensor_class_t;
+
+/**
+ * @brief Common head of every typed record (all classes but environment)
+ */
+typedef struct {
+    uint16_t device;      /**< Device handle (see device_registry.h) */
+    uint16_t generation;  /**< device_registry_generation() of the handle at arrival */
+    uint32_t ingest_us;   /**< Arrival at the CoAP handler (sensor_latency_now_us()) */
+} sensor_record_header_t;
+
+typedef struct {
+    sensor_record_header_t header;
+    float co2_ppm;
+    float voc_index;
+    float pm2_5;
+    float pm10;
+} air_quality_data_t;
+
+typedef struct {
+    sensor_record_header_t header;
+    float voltage;
+    float current;
+    float power;
+    float energy_wh;
+} energy_data_t;
+
+typedef struct {
+    sensor_record_header_t header;
+    float occupied;
+    float people;
+    float illuminance;
+} occupancy_data_t;
+
+/**
+ * @brief Storage large enough for a reading of any class
+ */
+typedef union {
+    sensor_data_t environment;
+    air_quality_data_t air_quality;
+    energy_data_t energy;
+    occupancy_data_t occupancy;
+} sensor_class_record_t;
+
+/**
+ * @brief One entry of the compile-time class table
+ */
+typedef struct {
+    const char *name;                    /**< Short name for logs */
+    const char *uri;                     /**< CoAP Uri-Path */
+    const char *topic;                   /**< MQTT topic template, "%s" = device ID;
+                                              NULL for environment (MQTT_TOPIC in aws_task.c) */
+    const sensor_frame_field_t *fields;  /**< Decoder and serializer field table */
+    size_t field_count;
+    size_t record_size;
+} sensor_class_info_t;
+
+/**
+ * @brief Create the rings of the typed classes
+ *
+ * Must be called once from app_main(), next to sensor_pipeline_init().
+ */
+esp_err_t sensor_class_init(void);
+
+/**
+ * @brief Table entry of a class
+ */
+const sensor_class_info_t *sensor_class_get(sensor_class_t cls);
+
+/**
+ * @brief Decode the next reading of a frame into a record of the class
+ *
+ * @return Same as sensor_frame_next()
+ */
+esp_err_t sensor_class_decode(sensor_class_t cls, sensor_frame_reader_t *reader, void *record);
+
+/**
+ * @brief Reserve a slot in the class queue (producer side, OpenThread task)
+ *
+ * For the environment class this is sensor_pipeline_reserve().
+ *
+ * @return Free slot, or NULL if the queue is full
+ */
+void *sensor_class_reserve(sensor_class_t cls);
+
+/**
+ * @brief Stamp the device and arrival time on a reserved slot and hand it
+ *        to the AWS task
+ *
+ * Typed records also get the handle's registry generation: they may wait in
+ * their queue longer than CONFIG_SENSOR_REGISTRY_IDLE_S while the cloud is
+ * down, and a record whose handle has been reused since must not be
+ * published under the new device's ID.
+ */
+void sensor_class_commit(sensor_class_t cls, void *slot, uint16_t device, uint32_t ingest_us);
+
+/**
+ * @brief Return a reserved slot without publishing it
+ */
+void sensor_class_abort(sensor_class_t cls, void *slot);
+
+/**
+ * @brief Get the eventfd shared by the typed class queues (consumer side)
+ *
+ * It becomes readable when any of them goes from empty to non-empty. Created
+ * on first call, which must happen after esp_vfs_eventfd_register().
+ *
+ * @return File descriptor, or -1 if it could not be created
+ */
+int sensor_class_get_eventfd(void);
+
+/**
+ * @brief Clear the eventfd before checking the queues (consumer side)
+ *
+ * @return Records ready across all typed classes; if non-zero the caller
+ *         must not wait in select()
+ */
+size_t sensor_class_poll(void);
+
+/**
+ * @brief Borrow up to max records of a typed class, oldest first (consumer side)
+ *
+ * The records stay in the ring until sensor_class_release().
+ *
+ * @return Number of records borrowed; always 0 for the environment class
+ */
+size_t sensor_class_receive(sensor_class_t cls, void **records, size_t max);
+
+/**
+ * @brief Hand the oldest count borrowed records of a class back to the producer
+ */
+void sensor_class_release(sensor_class_t cls, size_t count);
+
+/**
+ * @brief Ring counters of a typed class
+ */
+void sensor_class_get_stats(sensor_class_t cls, spsc_ring_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SENSOR_CLASS_H
@@ -0,0 +1,144 @@
+#include "sensor_deadband.h"
+#include <math.h>
+#include "device_registry.h"
+#include "sdkconfig.h"
+
+#define DEADBAND_HEARTBEAT_MS   CONFIG_SENSOR_DEADBAND_HEARTBEAT_MS
+#define DEADBAND_MAX_DEVICES    CONFIG_SENSOR_REGISTRY_MAX_DEVICES
+#define DEADBAND_MAX_CHECKS     CONFIG_SENSOR_BATCH_MAX_READINGS
+
+// Umbrales en centésimas de la unidad de cada métrica (Kconfig no tiene floats)
+static const float s_threshold[SENSOR_METRIC_COUNT] = {
+    [SENSOR_METRIC_TEMPERATURE] = CONFIG_SENSOR_DEADBAND_TEMP / 100.0f,
+    [SENSOR_METRIC_HUMIDITY] = CONFIG_SENSOR_DEADBAND_HUM / 100.0f,
+    [SENSOR_METRIC_PRESSURE] = CONFIG_SENSOR_DEADBAND_PRESS / 100.0f,
+    [SENSOR_METRIC_GAS] = CONFIG_SENSOR_DEADBAND_GAS / 100.0f,
+};
+
+// Última lectura reenviada de cada dispositivo, indexada por su handle
+typedef struct {
+    float value[SENSOR_METRIC_COUNT];
+    uint32_t sent_ms;
+    uint16_t generation;  // del handle en el registro: otra = otro dispositivo
+    bool in_use;
+} deadband_device_t;
+
+typedef enum {
+    DEADBAND_UNTRACKED,  // handle sin estado (bench, reenvíos del spool)
+    DEADBAND_SUPPRESSED,
+    DEADBAND_FIRST_SEEN,
+    DEADBAND_CHANGED,
+    DEADBAND_HEARTBEAT,
+} deadband_outcome_t;
+
+// Evaluación pendiente de commit: el estado anterior del dispositivo para
+// deshacerla y lo que hay que sumar a los contadores si se confirma
+typedef struct {
+    deadband_device_t previous;
+    uint16_t device;
+    uint8_t outcome;    // deadband_outcome_t
+    uint8_t triggered;  // bit m: la métrica m superó su umbral
+} deadband_check_t;
+
+static deadband_device_t s_devices[DEADBAND_MAX_DEVICES];
+static deadband_check_t s_checks[DEADBAND_MAX_CHECKS];
+static size_t s_check_count;
+static sensor_deadband_stats_t s_stats;
+
+bool sensor_deadband_enabled(void)
+{
+    return DEADBAND_HEARTBEAT_MS > 0;
+}
+
+bool sensor_deadband_check(const sensor_data_t *reading, uint32_t now_ms)
+{
+    // Sin hueco para deshacerla, la lectura se publica sin tocar la referencia
+    if (DEADBAND_HEARTBEAT_MS == 0 || s_check_count >= DEADBAND_MAX_CHECKS) {
+        return true;
+    }
+
+    // Toda evaluación ocupa su puesto en el diario, también las que no
+    // tocan estado: el count de sensor_deadband_commit() cuenta posiciones
+    deadband_check_t *check = &s_checks[s_check_count++];
+    check->device = reading->device;
+    check->triggered = 0;
+    if (reading->device >= DEADBAND_MAX_DEVICES) {
+        check->outcome = DEADBAND_UNTRACKED;
+        return true;
+    }
+
+    deadband_device_t *dev = &s_devices[reading->device];
+    uint16_t generation = device_registry_generation(reading->device);
+    bool created = !dev->in_use || dev->generation != generation;
+
+    check->previous = *dev;
+    if (created) {
+        dev->in_use = true;
+        dev->generation = generation;
+        check->outcome = DEADBAND_FIRST_SEEN;
+    } else {
+        for (int m = 0; m < SENSOR_METRIC_COUNT; m++) {
+            float value = sensor_data_metric(reading, (sensor_metric_t)m);
+            if (isfinite(value) && (!isfinite(dev->value[m]) || fabsf(value - dev->value[m]) > s_threshold[m])) {
+                check->triggered |= 1u << m;
+            }
+        }
+        if (check->triggered != 0) {
+            check->outcome = DEADBAND_CHANGED;
+        } else if (now_ms - dev->sent_ms >= DEADBAND_HEARTBEAT_MS) {
+            check->outcome = DEADBAND_HEARTBEAT;
+        } else {
+            check->outcome = DEADBAND_SUPPRESSED;
+            return false;
+        }
+    }
+
+    // Las métricas ausentes conservan su referencia anterior
+    for (int m = 0; m < SENSOR_METRIC_COUNT; m++) {
+        float value = sensor_data_metric(reading, (sensor_metric_t)m);
+        if (created || isfinite(value)) {
+            dev->value[m] = value;
+        }
+    }
+    dev->sent_ms = now_ms;
+    return true;
+}
+
+void sensor_deadband_commit(size_t count)
+{
+    // Deshacer en orden inverso: un dispositivo puede aparecer varias veces
+    while (s_check_count > count) {
+        const deadband_check_t *check = &s_checks[--s_check_count];
+        if (check->outcome != DEADBAND_UNTRACKED) {
+            s_devices[check->device] = check->previous;
+        }
+    }
+
+    for (size_t i = 0; i < s_check_count; i++) {
+        const deadband_check_t *check = &s_checks[i];
+        if (check->outcome == DEADBAND_UNTRACKED) {
+            continue;
+        }
+        for (int m = 0; m < SENSOR_METRIC_COUNT; m++) {
+            if (check->triggered & (1u << m)) {
+                s_stats.triggered[m]++;
+            }
+        }
+        if (check->outcome == DEADBAND_SUPPRESSED) {
+            s_stats.suppressed++;
+            continue;
+        }
+        s_stats.passed++;
+        if (check->outcome == DEADBAND_FIRST_SEEN) {
+            s_stats.first_seen++;
+        } else if (check->outcome == DEADBAND_HEARTBEAT) {
+            s_stats.heartbeats++;
+        }
+    }
+    s_check_count = 0;
+}
+
+void sensor_deadband_get_stats(sensor_deadband_stats_t *stats)
+{
+    *stats = s_stats;
+}
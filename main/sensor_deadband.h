@@ -0,0 +1,70 @@
+#ifndef SENSOR_DEADBAND_H
+#define SENSOR_DEADBAND_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "shared_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Deadband filter counters, for tuning the thresholds
+ */
+typedef struct {
+    uint32_t passed;                          /**< Readings forwarded */
+    uint32_t suppressed;                      /**< Readings dropped as unchanged */
+    uint32_t first_seen;                      /**< Forwarded because the device had no state */
+    uint32_t heartbeats;                      /**< Forwarded only because the heartbeat expired */
+    uint32_t triggered[SENSOR_METRIC_COUNT];  /**< Times each metric moved past its threshold */
+} sensor_deadband_stats_t;
+
+/**
+ * @brief Decide whether a raw reading is worth publishing
+ *
+ * A reading passes when any metric moved more than its threshold
+ * (CONFIG_SENSOR_DEADBAND_*) since the last reading forwarded for the same
+ * device, when a metric appears that the last one lacked, or when
+ * CONFIG_SENSOR_DEADBAND_HEARTBEAT_MS has elapsed since then. A passing
+ * reading becomes the reference for the readings checked after it, but only
+ * provisionally: sensor_deadband_commit() decides which checks stand.
+ *
+ * Must be called from the AWS task only, at most
+ * CONFIG_SENSOR_BATCH_MAX_READINGS times between commits. Each call takes
+ * one position in the order sensor_deadband_commit() counts, also for
+ * handles that keep no state (bench, spool replays), which always pass.
+ *
+ * @return true to publish, false to drop; always true when
+ *         CONFIG_SENSOR_DEADBAND_HEARTBEAT_MS is 0 (filter disabled)
+ */
+bool sensor_deadband_check(const sensor_data_t *reading, uint32_t now_ms);
+
+/**
+ * @brief Settle the checks made since the last commit
+ *
+ * The first count checks belong to readings that left the ring: their
+ * references and counters stay. The later ones belong to readings that stay
+ * in the ring for the next batch, or to a reading dropped without being
+ * published; their reference changes are undone, newest first, so the
+ * reference never moves to a value that was not published, and they are
+ * not counted.
+ */
+void sensor_deadband_commit(size_t count);
+
+/**
+ * @brief Whether the filter is enabled
+ */
+bool sensor_deadband_enabled(void);
+
+/**
+ * @brief Read the filter counters
+ */
+void sensor_deadband_get_stats(sensor_deadband_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SENSOR_DEADBAND_H
@@ -0,0 +1,124 @@
+#include "sensor_frame.h"
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+const sensor_frame_field_t sensor_frame_environment_fields[SENSOR_METRIC_COUNT] = {
+    [SENSOR_METRIC_TEMPERATURE] = { SENSOR_FRAME_M_TEMPERATURE, 2, offsetof(sensor_data_t, temperature), "temp" },
+    [SENSOR_METRIC_HUMIDITY] = { SENSOR_FRAME_M_HUMIDITY, 2, offsetof(sensor_data_t, humidity), "hum" },
+    [SENSOR_METRIC_PRESSURE] = { SENSOR_FRAME_M_PRESSURE, 2, offsetof(sensor_data_t, pressure), "press" },
+    [SENSOR_METRIC_GAS] = { SENSOR_FRAME_M_GAS, 2, offsetof(sensor_data_t, gas_concentration), "gas" },
+};
+
+// Entero con signo little endian de 1 a 4 bytes, con dos decimales o sin ellos
+static bool read_fixed(const uint8_t *value, size_t len, uint8_t decimals, float *out)
+{
+    if (len == 0 || len > 4) {
+        return false;
+    }
+
+    uint32_t raw = 0;
+    for (size_t i = 0; i < len; i++) {
+        raw |= (uint32_t)value[i] << (8 * i);
+    }
+    // Extender el signo desde el bit más alto del último byte
+    if (len < 4 && (value[len - 1] & 0x80)) {
+        raw |= UINT32_MAX << (8 * len);
+    }
+    *out = (decimals == 0) ? (float)(int32_t)raw : (float)(int32_t)raw / 100.0f;
+    return true;
+}
+
+// Copia los len bytes en pos del origen; false si se sale de la trama
+static bool read_at(const sensor_frame_reader_t *reader, size_t pos, void *buf, size_t len)
+{
+    return len <= reader->len - pos && reader->read(reader->source, pos, buf, len) == len;
+}
+
+// Métricas de la lectura en [pos, end): se lee cada cabecera y solo el valor
+// de las métricas que conoce este tipo de lectura
+static esp_err_t decode_reading(const sensor_frame_reader_t *reader, size_t pos, size_t end,
+                                const sensor_frame_field_t *fields, size_t field_count, void *out)
+{
+    for (size_t f = 0; f < field_count; f++) {
+        *(float *)((uint8_t *)out + fields[f].offset) = NAN;
+    }
+
+    while (pos < end) {
+        uint8_t header[2];
+        if (end - pos < 2 || !read_at(reader, pos, header, sizeof(header)) || end - pos - 2 < header[1]) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        uint8_t type = header[0];
+        uint8_t length = header[1];
+
+        // Una métrica que este tipo de lectura no conoce (otra clase de
+        // sensor o una versión más nueva del nodo) se ignora
+        for (size_t f = 0; f < field_count; f++) {
+            if (fields[f].type != type) {
+                continue;
+            }
+            uint8_t value[4];
+            if (length > sizeof(value) || !read_at(reader, pos + 2, value, length) ||
+                !read_fixed(value, length, fields[f].decimals, (float *)((uint8_t *)out + fields[f].offset))) {
+                return ESP_ERR_INVALID_SIZE;
+            }
+            break;
+        }
+        pos += 2 + length;
+    }
+    return ESP_OK;
+}
+
+esp_err_t sensor_frame_begin(sensor_frame_reader_t *reader, sensor_frame_read_t read, const void *source,
+                             size_t len)
+{
+    uint8_t version = 0;
+
+    if (len == 0 || read(source, 0, &version, 1) != 1) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (version != SENSOR_FRAME_VERSION_1) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    memset(reader, 0, sizeof(*reader));
+    reader->read = read;
+    reader->source = source;
+    reader->len = len;
+    reader->pos = 1;
+    return ESP_OK;
+}
+
+esp_err_t sensor_frame_next(sensor_frame_reader_t *reader, sensor_data_t *out)
+{
+    return sensor_frame_next_fields(reader, sensor_frame_environment_fields, SENSOR_METRIC_COUNT, out);
+}
+
+esp_err_t sensor_frame_next_fields(sensor_frame_reader_t *reader, const sensor_frame_field_t *fields,
+                                   size_t field_count, void *out)
+{
+    while (reader->pos < reader->len) {
+        uint8_t header[2];
+        size_t remaining = reader->len - reader->pos;
+        if (remaining < 2 || !read_at(reader, reader->pos, header, sizeof(header)) || remaining - 2 < header[1]) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        uint8_t type = header[0];
+        uint8_t length = header[1];
+        size_t value = reader->pos + 2;
+        reader->pos = value + length;
+
+        if (type == SENSOR_FRAME_T_DEVICE_ID) {
+            if (length == 0 || length >= sizeof(reader->device_id) ||
+                !read_at(reader, value, reader->device_id, length)) {
+                return ESP_ERR_INVALID_SIZE;
+            }
+            reader->device_id[length] = '\0';
+        } else if (type == SENSOR_FRAME_T_READING) {
+            return decode_reading(reader, value, reader->pos, fields, field_count, out);
+        }
+        // Otros tipos de registro: reservados para versiones futuras
+    }
+    return ESP_ERR_NOT_FOUND;
+}
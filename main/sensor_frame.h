@@ -0,0 +1,157 @@
+#ifndef SENSOR_FRAME_H
+#define SENSOR_FRAME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "shared_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Versioned TLV sensor frame sent by Thread nodes
+ *
+ * A frame starts with a version byte that has its high bit set, so it can
+ * never be mistaken for the legacy raw sensor_data_t (which starts with an
+ * ASCII device_id). It is followed by type-length-value records:
+ *
+ *   frame   = version(1) record*
+ *   record  = type(1) length(1) value(length)
+ *
+ * Top-level records:
+ * - SENSOR_FRAME_T_DEVICE_ID: device identifier (1..15 bytes, no NUL); it
+ *   applies to every following reading. It may be left out once the border
+ *   router knows the node: readings before any ID belong to the device
+ *   registered for the sender's mesh address.
+ * - SENSOR_FRAME_T_READING: one reading; its value is itself a list of
+ *   metric records.
+ *
+ * Metric values are signed little-endian fixed-point integers of 1 to 4
+ * bytes, in hundredths of the unit (2150 = 21.50), except counts and flags,
+ * which are plain integers (see sensor_frame_field_t). Every metric is
+ * optional; a missing metric decodes to NAN. Unknown record types are
+ * skipped, so newer nodes can add fields without breaking older border
+ * routers. All multi-byte integers are little endian.
+ *
+ * The same framing is used on every CoAP resource (see sensor_class.h); only
+ * the metric types that are meaningful change from one sensor class to
+ * another.
+ */
+#define SENSOR_FRAME_VERSION_1      0x81
+
+typedef enum {
+    SENSOR_FRAME_T_DEVICE_ID = 0x01,    /**< string, up to 15 bytes */
+    SENSOR_FRAME_T_READING = 0x02,      /**< nested metric records */
+} sensor_frame_type_t;
+
+typedef enum {
+    SENSOR_FRAME_M_TEMPERATURE = 0x10,  /**< centi-degrees C */
+    SENSOR_FRAME_M_HUMIDITY = 0x11,     /**< centi-% RH */
+    SENSOR_FRAME_M_PRESSURE = 0x12,     /**< centi-hPa */
+    SENSOR_FRAME_M_GAS = 0x13,          /**< hundredths of the gas sensor unit */
+
+    SENSOR_FRAME_M_CO2 = 0x20,          /**< ppm, integer */
+    SENSOR_FRAME_M_VOC_INDEX = 0x21,    /**< VOC index (1..500), integer */
+    SENSOR_FRAME_M_PM2_5 = 0x22,        /**< centi-ug/m3 */
+    SENSOR_FRAME_M_PM10 = 0x23,         /**< centi-ug/m3 */
+
+    SENSOR_FRAME_M_VOLTAGE = 0x30,      /**< centi-volts RMS */
+    SENSOR_FRAME_M_CURRENT = 0x31,      /**< centi-amperes RMS */
+    SENSOR_FRAME_M_POWER = 0x32,        /**< centi-watts, active power */
+    SENSOR_FRAME_M_ENERGY = 0x33,       /**< Wh, integer, total since install */
+
+    SENSOR_FRAME_M_OCCUPIED = 0x40,     /**< 0 or 1 */
+    SENSOR_FRAME_M_PEOPLE = 0x41,       /**< people count, integer */
+    SENSOR_FRAME_M_ILLUMINANCE = 0x42,  /**< lux, integer */
+} sensor_frame_metric_t;
+
+/**
+ * @brief Where a metric record lands in a decoded reading
+ *
+ * A table of these describes one reading type: the decoder stores each known
+ * metric in the float at `offset` and leaves the others at NAN. The
+ * serializer walks the same table to name the fields.
+ */
+typedef struct {
+    uint8_t type;       /**< sensor_frame_metric_t */
+    uint8_t decimals;   /**< 2: hundredths of the unit; 0: plain integer */
+    uint16_t offset;    /**< offsetof() the float field in the reading */
+    const char *key;    /**< JSON key */
+} sensor_frame_field_t;
+
+/**
+ * @brief Copy len bytes at offset of a frame source into buf
+ *
+ * Lets the reader pull records straight out of wherever the frame lives
+ * (e.g. an OpenThread message) without copying the whole frame first.
+ *
+ * @return Bytes copied; fewer than len only past the end of the source
+ */
+typedef size_t (*sensor_frame_read_t)(const void *source, size_t offset, void *buf, size_t len);
+
+/**
+ * @brief Cursor over the readings of one frame
+ */
+typedef struct {
+    sensor_frame_read_t read;
+    const void *source;
+    size_t len;
+    size_t pos;
+    char device_id[16];
+} sensor_frame_reader_t;
+
+/**
+ * @brief Whether a payload is a versioned frame (as opposed to a legacy raw struct)
+ */
+static inline bool sensor_frame_is_versioned(const uint8_t *buf, size_t len)
+{
+    return len > 0 && (buf[0] & 0x80) != 0;
+}
+
+/**
+ * @brief Start decoding a frame of len bytes read through read from source
+ *
+ * Records are fetched a header and a value at a time as they are decoded,
+ * so no buffer of the frame's size is needed.
+ *
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED for an unknown version, or
+ *         ESP_ERR_INVALID_SIZE if the source is shorter than len
+ */
+esp_err_t sensor_frame_begin(sensor_frame_reader_t *reader, sensor_frame_read_t read, const void *source,
+                             size_t len);
+
+/**
+ * @brief Decode the next reading of the frame into out
+ *
+ * Fills the metrics only. The device ID in effect for the reading is left
+ * in reader->device_id, empty if the frame has not carried one yet.
+ *
+ * @return ESP_OK, ESP_ERR_NOT_FOUND when there are no more readings, or
+ *         ESP_ERR_INVALID_SIZE if the frame is truncated or malformed
+ */
+esp_err_t sensor_frame_next(sensor_frame_reader_t *reader, sensor_data_t *out);
+
+/**
+ * @brief Decode the next reading into any reading type described by fields
+ *
+ * Every float listed in fields is set, to NAN when the reading does not
+ * carry that metric; the rest of out is left untouched.
+ *
+ * @return Same as sensor_frame_next()
+ */
+esp_err_t sensor_frame_next_fields(sensor_frame_reader_t *reader, const sensor_frame_field_t *fields,
+                                   size_t field_count, void *out);
+
+/**
+ * @brief Field table of sensor_data_t (temperature, humidity, pressure, gas)
+ */
+extern const sensor_frame_field_t sensor_frame_environment_fields[SENSOR_METRIC_COUNT];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SENSOR_FRAME_H
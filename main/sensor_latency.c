@@ -0,0 +1,42 @@
+#include "sensor_latency.h"
+#include "metrics.h"
+
+// Un histograma del registro de métricas por etapa; solo escribe aws_iot_task
+static metric_histogram_t s_storage[SENSOR_LATENCY_STAGE_COUNT];
+static metric_t s_stages[SENSOR_LATENCY_STAGE_COUNT] = {
+    [SENSOR_LATENCY_QUEUE] = METRIC_HISTOGRAM_INIT("latency.queue", &s_storage[SENSOR_LATENCY_QUEUE]),
+    [SENSOR_LATENCY_SERIALIZE] = METRIC_HISTOGRAM_INIT("latency.serialize", &s_storage[SENSOR_LATENCY_SERIALIZE]),
+    [SENSOR_LATENCY_PUBLISH] = METRIC_HISTOGRAM_INIT("latency.publish", &s_storage[SENSOR_LATENCY_PUBLISH]),
+    [SENSOR_LATENCY_PUBACK] = METRIC_HISTOGRAM_INIT("latency.puback", &s_storage[SENSOR_LATENCY_PUBACK]),
+    [SENSOR_LATENCY_END_TO_END] = METRIC_HISTOGRAM_INIT("latency.e2e", &s_storage[SENSOR_LATENCY_END_TO_END]),
+};
+
+void sensor_latency_init(void)
+{
+    for (int stage = 0; stage < SENSOR_LATENCY_STAGE_COUNT; stage++) {
+        metrics_register(&s_stages[stage]);
+    }
+}
+
+void sensor_latency_record(sensor_latency_stage_t stage, uint32_t us)
+{
+    metric_histogram_record(&s_stages[stage], us);
+}
+
+void sensor_latency_get(sensor_latency_stage_t stage, sensor_latency_summary_t *summary)
+{
+    metric_histogram_summary_t hist;
+
+    metric_histogram_get(&s_stages[stage], &hist);
+    summary->count = hist.count;
+    summary->p50_us = hist.p50;
+    summary->p90_us = hist.p90;
+    summary->p99_us = hist.p99;
+    summary->max_us = hist.max;
+}
+
+const char *sensor_latency_stage_name(sensor_latency_stage_t stage)
+{
+    // Sin el prefijo "latency."
+    return (stage < SENSOR_LATENCY_STAGE_COUNT) ? s_stages[stage].name + sizeof("latency.") - 1 : "";
+}
@@ -0,0 +1,74 @@
+#ifndef SENSOR_LATENCY_H
+#define SENSOR_LATENCY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_timer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Stages of a reading's trip from coap_handler() to its PUBACK
+ */
+typedef enum {
+    SENSOR_LATENCY_QUEUE = 0,   /**< CoAP arrival -> taken from the pipeline by the AWS task */
+    SENSOR_LATENCY_SERIALIZE,   /**< Encoding one MQTT payload */
+    SENSOR_LATENCY_PUBLISH,     /**< One MQTT_Publish() call */
+    SENSOR_LATENCY_PUBACK,      /**< First MQTT_Publish() -> PUBACK */
+    SENSOR_LATENCY_END_TO_END,  /**< CoAP arrival of the oldest reading in a payload -> PUBACK */
+    SENSOR_LATENCY_STAGE_COUNT
+} sensor_latency_stage_t;
+
+/**
+ * @brief Percentiles of one stage since boot, in microseconds
+ *
+ * Percentiles are bucket upper bounds, within 25% of the true value.
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t p50_us;
+    uint32_t p90_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} sensor_latency_summary_t;
+
+/**
+ * @brief Timestamp for latency tracing: esp_timer_get_time() truncated to
+ *        32 bits (wraps every ~71 minutes, differences stay valid)
+ */
+static inline uint32_t sensor_latency_now_us(void)
+{
+    return (uint32_t)esp_timer_get_time();
+}
+
+/**
+ * @brief Register the stage histograms in the metrics registry (metrics.h)
+ *        as latency.queue, latency.serialize, ...
+ */
+void sensor_latency_init(void);
+
+/**
+ * @brief Add one sample to a stage's histogram
+ *
+ * Must be called from the AWS task only; recording is a couple of relaxed
+ * atomic stores so readers on other tasks never see torn counters.
+ */
+void sensor_latency_record(sensor_latency_stage_t stage, uint32_t us);
+
+/**
+ * @brief Compute the percentiles of a stage (any task)
+ */
+void sensor_latency_get(sensor_latency_stage_t stage, sensor_latency_summary_t *summary);
+
+/**
+ * @brief Short stage name used by the CLI
+ */
+const char *sensor_latency_stage_name(sensor_latency_stage_t stage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SENSOR_LATENCY_H
@@ -0,0 +1,234 @@
+#include "sensor_pipeline.h"
+#include <stdatomic.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "esp_vfs_eventfd.h"
+#include "freertos/task.h"
+#include "metrics.h"
+#include "nvs.h"
+#include "sdkconfig.h"
+#include "spsc_ring.h"
+
+static const char *TAG = "SENSOR_PIPELINE";
+
+#define SENSOR_PIPELINE_DEPTH CONFIG_SENSOR_PIPELINE_DEPTH
+
+_Static_assert((SENSOR_PIPELINE_DEPTH & (SENSOR_PIPELINE_DEPTH - 1)) == 0,
+               "CONFIG_SENSOR_PIPELINE_DEPTH must be a power of two");
+
+// Productor: mainloop de OpenThread (coap_handler). Consumidor: aws_iot_task.
+// Los datos viven en el ring y se leen/escriben en sitio, sin colas del kernel.
+static sensor_data_t s_slots[SENSOR_PIPELINE_DEPTH] __attribute__((aligned(SPSC_RING_CACHE_LINE)));
+static spsc_ring_t s_ring;
+static TaskHandle_t s_consumer = NULL;
+
+// Identidad de cada lectura: (arranque, posición en el ring). s_released solo
+// lo toca el consumidor y cuenta las lecturas devueltas desde el arranque, así
+// que el slot i de un lote recibido es la lectura número s_released + i.
+static uint16_t s_boot_id = 0;
+static uint32_t s_released = 0;
+
+// Ocupación a la que el consumidor pide ser despertado además de la
+// transición vacío -> no vacío (0 = solo esa transición).
+static _Atomic uint32_t s_wake_threshold = 0;
+
+// eventfd para un consumidor que espera con select() junto a otros fds
+static _Atomic int s_event_fd = -1;
+
+// Métricas de la cola: se leen de los contadores del ring al volcarlas
+static uint32_t sample_used(void)
+{
+    spsc_ring_stats_t stats;
+    spsc_ring_get_stats(&s_ring, &stats);
+    return stats.used;
+}
+
+static uint32_t sample_high_water(void)
+{
+    spsc_ring_stats_t stats;
+    spsc_ring_get_stats(&s_ring, &stats);
+    return stats.high_water;
+}
+
+static uint32_t sample_dropped(void)
+{
+    spsc_ring_stats_t stats;
+    spsc_ring_get_stats(&s_ring, &stats);
+    return stats.dropped;
+}
+
+static metric_t s_metric_used = METRIC_SAMPLED_INIT("queue.used", METRIC_TYPE_GAUGE, sample_used);
+static metric_t s_metric_high_water = METRIC_SAMPLED_INIT("queue.high_water", METRIC_TYPE_GAUGE, sample_high_water);
+static metric_t s_metric_dropped = METRIC_SAMPLED_INIT("queue.dropped", METRIC_TYPE_COUNTER, sample_dropped);
+
+static void wake_consumer(uint32_t before, uint32_t after)
+{
+    uint32_t threshold = atomic_load(&s_wake_threshold);
+
+    if (before != 0 && (threshold <= before || threshold > after)) {
+        return;
+    }
+    if (s_consumer != NULL) {
+        xTaskNotifyGive(s_consumer);
+    }
+    int fd = atomic_load(&s_event_fd);
+    if (fd >= 0) {
+        uint64_t one = 1;
+        write(fd, &one, sizeof(one));
+    }
+}
+
+// Incrementa el contador de arranques en NVS; nvs_flash_init() ya se ha llamado
+static uint16_t load_boot_id(void)
+{
+    nvs_handle_t handle;
+    uint16_t boot = 0;
+
+    if (nvs_open("sensor_pipe", NVS_READWRITE, &handle) != ESP_OK) {
+        ESP_LOGW(TAG, "NVS unavailable, boot id stays at 0");
+        return 0;
+    }
+    nvs_get_u16(handle, "boot", &boot);
+    boot++;
+    if (nvs_set_u16(handle, "boot", boot) != ESP_OK || nvs_commit(handle) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to persist boot id");
+    }
+    nvs_close(handle);
+    return boot;
+}
+
+esp_err_t sensor_pipeline_init(void)
+{
+    s_boot_id = load_boot_id();
+
+    esp_err_t err = spsc_ring_init(&s_ring, s_slots, sizeof(sensor_data_t), SENSOR_PIPELINE_DEPTH);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create pipeline ring: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    metrics_register(&s_metric_used);
+    metrics_register(&s_metric_high_water);
+    metrics_register(&s_metric_dropped);
+
+    ESP_LOGI(TAG, "Sensor pipeline created (capacity: %d, boot: %u)", SENSOR_PIPELINE_DEPTH, s_boot_id);
+    return ESP_OK;
+}
+
+sensor_data_t *sensor_pipeline_reserve(void)
+{
+    return spsc_ring_reserve(&s_ring);
+}
+
+void sensor_pipeline_commit(sensor_data_t *slot)
+{
+    (void)slot;
+
+    // Solo se despierta al consumidor en la transición vacío -> no vacío o al
+    // alcanzar el umbral pedido; el resto de commits no llaman al kernel.
+    uint32_t used = spsc_ring_commit(&s_ring);
+    wake_consumer(used - 1, used);
+}
+
+void sensor_pipeline_abort(sensor_data_t *slot)
+{
+    // Reservar no avanza el ring: basta con no hacer commit
+    (void)slot;
+}
+
+size_t sensor_pipeline_push_batch(const sensor_data_t *items, size_t count)
+{
+    uint32_t used = 0;
+    size_t pushed = spsc_ring_push_batch(&s_ring, items, count, &used);
+
+    if (pushed > 0) {
+        wake_consumer(used - pushed, used);
+    }
+    return pushed;
+}
+
+size_t sensor_pipeline_wait_for(size_t count, TickType_t wait)
+{
+    TickType_t start = xTaskGetTickCount();
+
+    if (s_consumer == NULL) {
+        s_consumer = xTaskGetCurrentTaskHandle();
+    }
+
+    // El umbral se publica antes de mirar el ring: o el productor ve el umbral
+    // nuevo, o nosotros vemos su commit. Nunca se pierde el aviso.
+    atomic_store(&s_wake_threshold, (uint32_t)count);
+
+    uint32_t ready = spsc_ring_available(&s_ring);
+    while (ready < count) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= wait) {
+            break;
+        }
+        ulTaskNotifyTake(pdTRUE, wait - elapsed);
+        ready = spsc_ring_available(&s_ring);
+    }
+
+    atomic_store(&s_wake_threshold, 0);
+    return ready;
+}
+
+int sensor_pipeline_get_eventfd(void)
+{
+    int fd = atomic_load(&s_event_fd);
+
+    if (fd < 0) {
+        fd = eventfd(0, 0);
+        if (fd < 0) {
+            ESP_LOGE(TAG, "Failed to create pipeline eventfd");
+            return -1;
+        }
+        atomic_store(&s_event_fd, fd);
+    }
+    return fd;
+}
+
+size_t sensor_pipeline_poll(size_t count)
+{
+    int fd = atomic_load(&s_event_fd);
+
+    // Vaciar el eventfd antes de armar el umbral y mirar el ring: un commit
+    // posterior vuelve a dejarlo legible, así que select() no se lo pierde
+    if (fd >= 0) {
+        uint64_t value;
+        read(fd, &value, sizeof(value));
+    }
+    atomic_store(&s_wake_threshold, (uint32_t)count);
+    return spsc_ring_available(&s_ring);
+}
+
+size_t sensor_pipeline_receive_batch(sensor_data_t **slots, size_t max, TickType_t wait)
+{
+    size_t ready = sensor_pipeline_wait_for(1, wait);
+    size_t count = (ready < max) ? ready : max;
+
+    for (size_t i = 0; i < count; i++) {
+        slots[i] = spsc_ring_peek(&s_ring, i);
+        slots[i]->boot = s_boot_id;
+        slots[i]->seq = s_released + i;
+    }
+    return count;
+}
+
+sensor_data_t *sensor_pipeline_receive(TickType_t wait)
+{
+    sensor_data_t *slot = NULL;
+
+    return (sensor_pipeline_receive_batch(&slot, 1, wait) == 1) ? slot : NULL;
+}
+
+void sensor_pipeline_release(size_t count)
+{
+    spsc_ring_release(&s_ring, count);
+    s_released += count;
+}
+
+void sensor_pipeline_get_stats(spsc_ring_stats_t *stats)
+{
+    spsc_ring_get_stats(&s_ring, stats);
+}
@@ -0,0 +1,129 @@
+#ifndef SENSOR_PIPELINE_H
+#define SENSOR_PIPELINE_H
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "shared_data.h"
+#include "spsc_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create the lock-free ring that carries sensor readings from the
+ *        CoAP handler (OpenThread task) to the AWS publisher task
+ *
+ * The ring is single-producer / single-consumer: only the OpenThread task may
+ * call the producer functions and only the AWS task the consumer ones.
+ * Must be called once from app_main() before any producer or consumer runs.
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t sensor_pipeline_init(void);
+
+/**
+ * @brief Reserve a free slot for an incoming reading (producer side)
+ *
+ * The caller decodes the payload directly into the returned slot and then
+ * hands it over with sensor_pipeline_commit(), or gives it back with
+ * sensor_pipeline_abort() if decoding fails. Never blocks.
+ *
+ * @return Pointer to a free slot, or NULL if the pipeline is full
+ */
+sensor_data_t *sensor_pipeline_reserve(void);
+
+/**
+ * @brief Publish a previously reserved slot to the consumer
+ *
+ * Wakes the consumer only when the ring goes from empty to non-empty.
+ */
+void sensor_pipeline_commit(sensor_data_t *slot);
+
+/**
+ * @brief Return a reserved slot without publishing it
+ */
+void sensor_pipeline_abort(sensor_data_t *slot);
+
+/**
+ * @brief Copy several readings into the pipeline at once (producer side)
+ *
+ * @return Number of readings accepted; the rest are counted as drops
+ */
+size_t sensor_pipeline_push_batch(const sensor_data_t *items, size_t count);
+
+/**
+ * @brief Wait until at least count readings are ready (consumer side)
+ *
+ * Used to linger for a fuller batch: the producer wakes the consumer as soon
+ * as the occupancy reaches count, without notifying on every commit.
+ *
+ * @return Number of readings ready when returning (may be below count on timeout)
+ */
+size_t sensor_pipeline_wait_for(size_t count, TickType_t wait);
+
+/**
+ * @brief Get an eventfd that becomes readable when readings are ready (consumer side)
+ *
+ * Lets the consumer wait on the pipeline and on sockets with a single
+ * select(). The producer signals it on the same conditions that wake a
+ * consumer blocked in sensor_pipeline_wait_for(); arm it with
+ * sensor_pipeline_poll() before every select(). Created on first call, which
+ * must happen after esp_vfs_eventfd_register().
+ *
+ * @return File descriptor, or -1 if it could not be created
+ */
+int sensor_pipeline_get_eventfd(void);
+
+/**
+ * @brief Clear the eventfd and arm it for count ready readings (consumer side)
+ *
+ * Non-blocking counterpart of sensor_pipeline_wait_for(): after this call
+ * the eventfd becomes readable as soon as the ring goes from empty to
+ * non-empty or its occupancy reaches count.
+ *
+ * @return Number of readings ready right now; if it already reaches count,
+ *         the caller must not wait in select()
+ */
+size_t sensor_pipeline_poll(size_t count);
+
+/**
+ * @brief Wait for committed readings and borrow up to max of them (consumer side)
+ *
+ * The slots are read in place and stay owned by the consumer until they are
+ * handed back, oldest first, with sensor_pipeline_release(). Each borrowed
+ * reading is stamped with the boot counter and its sequence number since
+ * boot, so (boot, seq) identifies it even after a replay from the spool.
+ *
+ * @param[out] slots Receives pointers to the ready readings, oldest first
+ * @param max        Maximum number of readings to borrow
+ * @param wait       Maximum time to block while the pipeline is empty
+ * @return Number of readings borrowed, 0 on timeout
+ */
+size_t sensor_pipeline_receive_batch(sensor_data_t **slots, size_t max, TickType_t wait);
+
+/**
+ * @brief Wait for the next committed reading (consumer side)
+ *
+ * Shorthand for sensor_pipeline_receive_batch() with max = 1.
+ *
+ * @return Pointer to the reading, or NULL on timeout
+ */
+sensor_data_t *sensor_pipeline_receive(TickType_t wait);
+
+/**
+ * @brief Hand the oldest count borrowed readings back to the producer
+ */
+void sensor_pipeline_release(size_t count);
+
+/**
+ * @brief Read ring occupancy, high-water mark and drop counters
+ */
+void sensor_pipeline_get_stats(spsc_ring_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SENSOR_PIPELINE_H
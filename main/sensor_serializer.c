@@ -0,0 +1,397 @@
+#include "sensor_serializer.h"
+#include "device_registry.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#if CONFIG_SENSOR_PAYLOAD_CBOR
+#include "cbor.h"
+#else
+#include "json_writer.h"
+#endif
+
+// Valor de un campo entero de una clase tipada. El entero de 32 bits de la
+// trama llega como float, y cerca de ±2^31 el redondeo puede dar 2^31, que
+// no cabe en int32_t: se satura en lugar de convertir fuera de rango.
+static int32_t field_int(float value)
+{
+    if (value >= 2147483648.0f) {
+        return INT32_MAX;
+    }
+    if (value < -2147483648.0f) {
+        return INT32_MIN;
+    }
+    return (int32_t)value;
+}
+
+#if CONFIG_SENSOR_PAYLOAD_CBOR
+
+// Temperatura y humedad caben en half float (paso de ~0.03 en su rango útil);
+// presión y gas necesitan single float para conservar dos decimales.
+static CborError encode_small_float(CborEncoder *encoder, float value)
+{
+#if CONFIG_SENSOR_CBOR_HALF_FLOAT
+    return cbor_encode_float_as_half_float(encoder, value);
+#else
+    return cbor_encode_float(encoder, value);
+#endif
+}
+
+// Codifica una lectura como mapa CBOR; devuelve la longitud o -1 si no cabe.
+// Las métricas que el nodo no envió (NAN) no aparecen en el mapa.
+static int encode_object(const sensor_data_t *data, uint8_t *buf, size_t size)
+{
+    const char *name = device_registry_name(data->device);
+    CborEncoder encoder, map;
+    CborError err;
+    size_t entries = 3;
+
+    entries += isfinite(data->temperature) + isfinite(data->humidity) +
+               isfinite(data->pressure) + isfinite(data->gas_concentration);
+
+    cbor_encoder_init(&encoder, buf, size, 0);
+    err = cbor_encoder_create_map(&encoder, &map, entries);
+    err |= cbor_encode_uint(&map, SENSOR_CBOR_KEY_ID);
+    err |= cbor_encode_text_string(&map, name, strlen(name));
+    if (isfinite(data->temperature)) {
+        err |= cbor_encode_uint(&map, SENSOR_CBOR_KEY_TEMP);
+        err |= encode_small_float(&map, data->temperature);
+    }
+    if (isfinite(data->humidity)) {
+        err |= cbor_encode_uint(&map, SENSOR_CBOR_KEY_HUM);
+        err |= encode_small_float(&map, data->humidity);
+    }
+    if (isfinite(data->pressure)) {
+        err |= cbor_encode_uint(&map, SENSOR_CBOR_KEY_PRESS);
+        err |= cbor_encode_float(&map, data->pressure);
+    }
+    if (isfinite(data->gas_concentration)) {
+        err |= cbor_encode_uint(&map, SENSOR_CBOR_KEY_GAS);
+        err |= cbor_encode_float(&map, data->gas_concentration);
+    }
+    err |= cbor_encode_uint(&map, SENSOR_CBOR_KEY_BOOT);
+    err |= cbor_encode_uint(&map, data->boot);
+    err |= cbor_encode_uint(&map, SENSOR_CBOR_KEY_SEQ);
+    err |= cbor_encode_uint(&map, data->seq);
+    err |= cbor_encoder_close_container(&encoder, &map);
+
+    return (err == CborNoError) ? (int)cbor_encoder_get_buffer_size(&encoder, buf) : -1;
+}
+
+// Resumen de ventana como mapa CBOR: cada métrica es [min, max, media, última]
+static int encode_summary(const sensor_summary_t *summary, uint8_t *buf, size_t size)
+{
+    static const sensor_cbor_key_t metric_keys[SENSOR_METRIC_COUNT] = {
+        SENSOR_CBOR_KEY_TEMP, SENSOR_CBOR_KEY_HUM, SENSOR_CBOR_KEY_PRESS, SENSOR_CBOR_KEY_GAS,
+    };
+    const char *name = device_registry_name(summary->device);
+    CborEncoder encoder, map, values;
+    CborError err;
+    size_t entries = 5;
+
+    for (int m = 0; m < SENSOR_METRIC_COUNT; m++) {
+        entries += (summary->metrics[m].count > 0);
+    }
+
+    cbor_encoder_init(&encoder, buf, size, 0);
+    err = cbor_encoder_create_map(&encoder, &map, entries);
+    err |= cbor_encode_uint(&map, SENSOR_CBOR_KEY_ID);
+    err |= cbor_encode_text_string(&map, name, strlen(name));
+    err |= cbor_encode_uint(&map, SENSOR_CBOR_KEY_COUNT);
+    err |= cbor_encode_uint(&map, summary->readings);
+    err |= cbor_encode_uint(&map, SENSOR_CBOR_KEY_WINDOW);
+    err |= cbor_encode_uint(&map, summary->window_ms);
+    for (int m = 0; m < SENSOR_METRIC_COUNT; m++) {
+        const sensor_metric_summary_t *metric = &summary->metrics[m];
+        if (metric->count == 0) {
+            continue;
+        }
+        bool small = (m == SENSOR_METRIC_TEMPERATURE || m == SENSOR_METRIC_HUMIDITY);
+        const float values_f[] = { metric->min, metric->max, metric->mean, metric->last };
+
+        err |= cbor_encode_uint(&map, metric_keys[m]);
+        err |= cbor_encoder_create_array(&map, &values, 4);
+        for (int v = 0; v < 4; v++) {
+            err |= small ? encode_small_float(&values, values_f[v]) : cbor_encode_float(&values, values_f[v]);
+        }
+        err |= cbor_encoder_close_container(&map, &values);
+    }
+    err |= cbor_encode_uint(&map, SENSOR_CBOR_KEY_BOOT);
+    err |= cbor_encode_uint(&map, summary->boot);
+    err |= cbor_encode_uint(&map, SENSOR_CBOR_KEY_SEQ);
+    err |= cbor_encode_uint(&map, summary->seq);
+    err |= cbor_encoder_close_container(&encoder, &map);
+
+    return (err == CborNoError) ? (int)cbor_encoder_get_buffer_size(&encoder, buf) : -1;
+}
+
+// Lectura de una clase tipada como mapa CBOR: cada campo va con su tipo de
+// métrica de la trama (0x20, 0x21, ...) como clave; los enteros como enteros
+static int encode_record(const sensor_class_info_t *info, const void *record, uint8_t *buf, size_t size)
+{
+    const sensor_record_header_t *header = record;
+    const char *name = device_registry_name(header->device);
+    CborEncoder encoder, map;
+    CborError err;
+    size_t entries = 1;
+
+    for (size_t f = 0; f < info->field_count; f++) {
+        entries += isfinite(*(const float *)((const uint8_t *)record + info->fields[f].offset));
+    }
+
+    cbor_encoder_init(&encoder, buf, size, 0);
+    err = cbor_encoder_create_map(&encoder, &map, entries);
+    err |= cbor_encode_uint(&map, SENSOR_CBOR_KEY_ID);
+    err |= cbor_encode_text_string(&map, name, strlen(name));
+    for (size_t f = 0; f < info->field_count; f++) {
+        const sensor_frame_field_t *field = &info->fields[f];
+        float value = *(const float *)((const uint8_t *)record + field->offset);
+        if (!isfinite(value)) {
+            continue;
+        }
+        err |= cbor_encode_uint(&map, field->type);
+        err |= (field->decimals == 0) ? cbor_encode_int(&map, field_int(value)) : cbor_encode_float(&map, value);
+    }
+    err |= cbor_encoder_close_container(&encoder, &map);
+
+    return (err == CborNoError) ? (int)cbor_encoder_get_buffer_size(&encoder, buf) : -1;
+}
+
+// Cabecera de arreglo CBOR (tipo mayor 4) de longitud definida
+#define BATCH_HEADER_MAX 2
+
+static size_t encode_batch_header(size_t count, uint8_t *buf)
+{
+    if (count < 24) {
+        buf[0] = 0x80 | (uint8_t)count;
+        return 1;
+    }
+    buf[0] = 0x98;
+    buf[1] = (uint8_t)count;
+    return 2;
+}
+
+#define BATCH_SEPARATOR_LEN 0
+#define BATCH_TRAILER_LEN   0
+
+#else // JSON
+
+// Claves fijas precalculadas: cada una se copia con un solo memcpy
+static const json_fragment_t s_key_id = JSON_FRAGMENT("{\"id\":");
+static const json_fragment_t s_key_boot = JSON_KEY("boot");
+static const json_fragment_t s_key_seq = JSON_KEY("seq");
+static const json_fragment_t s_key_n = JSON_KEY("n");
+static const json_fragment_t s_key_win = JSON_KEY("win");
+static const json_fragment_t s_metric_keys[SENSOR_METRIC_COUNT] = {
+    JSON_KEY("temp"), JSON_KEY("hum"), JSON_KEY("press"), JSON_KEY("gas"),
+};
+
+// Añade "clave":valor solo si el nodo envió la métrica (no NAN)
+static void append_metric(json_writer_t *writer, const json_fragment_t *key, float value)
+{
+    if (isfinite(value)) {
+        json_writer_fragment(writer, key);
+        json_writer_fixed2(writer, value);
+    }
+}
+
+// ,"boot":N,"seq":N} común a lecturas y resúmenes
+static void append_trailer(json_writer_t *writer, uint16_t boot, uint32_t seq)
+{
+    json_writer_fragment(writer, &s_key_boot);
+    json_writer_u32(writer, boot);
+    json_writer_fragment(writer, &s_key_seq);
+    json_writer_u32(writer, seq);
+    json_writer_literal(writer, "}");
+}
+
+// Formatea una lectura como objeto JSON; devuelve la longitud o -1 si no cabe
+static int encode_object(const sensor_data_t *data, uint8_t *buf, size_t size)
+{
+    json_writer_t writer;
+
+    json_writer_init(&writer, buf, size);
+    json_writer_fragment(&writer, &s_key_id);
+    json_writer_string(&writer, device_registry_name(data->device));
+    append_metric(&writer, &s_metric_keys[SENSOR_METRIC_TEMPERATURE], data->temperature);
+    append_metric(&writer, &s_metric_keys[SENSOR_METRIC_HUMIDITY], data->humidity);
+    append_metric(&writer, &s_metric_keys[SENSOR_METRIC_PRESSURE], data->pressure);
+    append_metric(&writer, &s_metric_keys[SENSOR_METRIC_GAS], data->gas_concentration);
+    append_trailer(&writer, data->boot, data->seq);
+
+    return json_writer_finish(&writer);
+}
+
+// Resumen de ventana como objeto JSON: cada métrica es {"min","max","mean","last"}
+static int encode_summary(const sensor_summary_t *summary, uint8_t *buf, size_t size)
+{
+    json_writer_t writer;
+
+    json_writer_init(&writer, buf, size);
+    json_writer_fragment(&writer, &s_key_id);
+    json_writer_string(&writer, device_registry_name(summary->device));
+    json_writer_fragment(&writer, &s_key_n);
+    json_writer_u32(&writer, summary->readings);
+    json_writer_fragment(&writer, &s_key_win);
+    json_writer_u32(&writer, summary->window_ms);
+    for (int m = 0; m < SENSOR_METRIC_COUNT; m++) {
+        const sensor_metric_summary_t *metric = &summary->metrics[m];
+        if (metric->count == 0) {
+            continue;
+        }
+        json_writer_fragment(&writer, &s_metric_keys[m]);
+        json_writer_literal(&writer, "{\"min\":");
+        json_writer_fixed2(&writer, metric->min);
+        json_writer_literal(&writer, ",\"max\":");
+        json_writer_fixed2(&writer, metric->max);
+        json_writer_literal(&writer, ",\"mean\":");
+        json_writer_fixed2(&writer, metric->mean);
+        json_writer_literal(&writer, ",\"last\":");
+        json_writer_fixed2(&writer, metric->last);
+        json_writer_literal(&writer, "}");
+    }
+    append_trailer(&writer, summary->boot, summary->seq);
+
+    return json_writer_finish(&writer);
+}
+
+// Lectura de una clase tipada como objeto JSON con las claves de su tabla de campos
+static int encode_record(const sensor_class_info_t *info, const void *record, uint8_t *buf, size_t size)
+{
+    const sensor_record_header_t *header = record;
+    json_writer_t writer;
+
+    json_writer_init(&writer, buf, size);
+    json_writer_fragment(&writer, &s_key_id);
+    json_writer_string(&writer, device_registry_name(header->device));
+    for (size_t f = 0; f < info->field_count; f++) {
+        const sensor_frame_field_t *field = &info->fields[f];
+        float value = *(const float *)((const uint8_t *)record + field->offset);
+        if (!isfinite(value)) {
+            continue;
+        }
+        json_writer_key(&writer, field->key);
+        if (field->decimals == 0) {
+            json_writer_i32(&writer, field_int(value));
+        } else {
+            json_writer_fixed2(&writer, value);
+        }
+    }
+    json_writer_literal(&writer, "}");
+
+    return json_writer_finish(&writer);
+}
+
+#define BATCH_HEADER_MAX 1
+
+static size_t encode_batch_header(size_t count, uint8_t *buf)
+{
+    (void)count;
+    buf[0] = '[';
+    return 1;
+}
+
+#define BATCH_SEPARATOR_LEN 1
+#define BATCH_TRAILER_LEN   1
+
+#endif // CONFIG_SENSOR_PAYLOAD_CBOR
+
+// Codificador de un elemento del lote; devuelve la longitud o -1 si no cabe.
+// context es la clase en los lotes de lecturas tipadas.
+typedef int (*encode_item_fn)(const void *context, const void *items, size_t index, uint8_t *buf, size_t size);
+
+static int encode_reading_item(const void *context, const void *items, size_t index, uint8_t *buf, size_t size)
+{
+    return encode_object(((sensor_data_t *const *)items)[index], buf, size);
+}
+
+static int encode_summary_item(const void *context, const void *items, size_t index, uint8_t *buf, size_t size)
+{
+    return encode_summary(&((const sensor_summary_t *)items)[index], buf, size);
+}
+
+static int encode_record_item(const void *context, const void *items, size_t index, uint8_t *buf, size_t size)
+{
+    return encode_record(context, ((const void *const *)items)[index], buf, size);
+}
+
+static size_t encode_batch(const void *context, const void *items, size_t count, encode_item_fn encode_item,
+                           uint8_t *buf, size_t size, size_t *len)
+{
+    *len = 0;
+    if (count == 0) {
+        return 0;
+    }
+
+    if (count == 1) {
+        int n = encode_item(context, items, 0, buf, size);
+        if (n < 0) {
+            return 0;
+        }
+        *len = n;
+        return 1;
+    }
+
+    // Lote: los objetos se codifican tras un hueco para la cabecera, que solo
+    // se conoce al final (CBOR lleva el número de elementos). Se reserva
+    // siempre espacio para el cierre del arreglo.
+    if (size <= BATCH_HEADER_MAX + BATCH_TRAILER_LEN) {
+        return 0;
+    }
+    size_t limit = size - BATCH_TRAILER_LEN;
+    size_t pos = BATCH_HEADER_MAX;
+    size_t encoded = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        size_t sep = (encoded > 0) ? BATCH_SEPARATOR_LEN : 0;
+        if (pos + sep >= limit) {
+            break;
+        }
+        int n = encode_item(context, items, i, buf + pos + sep, limit - pos - sep);
+        if (n < 0) {
+            break;
+        }
+        if (sep) {
+            buf[pos] = ',';
+        }
+        pos += sep + n;
+        encoded++;
+    }
+
+    if (encoded == 0) {
+        return 0;
+    }
+
+    // Colocar la cabecera justo antes del primer objeto
+    uint8_t header[BATCH_HEADER_MAX];
+    size_t header_len = encode_batch_header(encoded, header);
+    size_t start = BATCH_HEADER_MAX - header_len;
+    memcpy(buf + start, header, header_len);
+    if (start > 0) {
+        memmove(buf, buf + start, pos - start);
+        pos -= start;
+    }
+#if BATCH_TRAILER_LEN
+    buf[pos++] = ']';
+#endif
+    *len = pos;
+    return encoded;
+}
+
+size_t sensor_serializer_encode(sensor_data_t *const *readings, size_t count,
+                                uint8_t *buf, size_t size, size_t *len)
+{
+    return encode_batch(NULL, readings, count, encode_reading_item, buf, size, len);
+}
+
+size_t sensor_serializer_encode_summaries(const sensor_summary_t *summaries, size_t count,
+                                          uint8_t *buf, size_t size, size_t *len)
+{
+    return encode_batch(NULL, summaries, count, encode_summary_item, buf, size, len);
+}
+
+size_t sensor_serializer_encode_records(const sensor_class_info_t *info, const void *const *records,
+                                        size_t count, uint8_t *buf, size_t size, size_t *len)
+{
+    return encode_batch(info, records, count, encode_record_item, buf, size, len);
+}
@@ -0,0 +1,101 @@
+#ifndef SENSOR_SERIALIZER_H
+#define SENSOR_SERIALIZER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "shared_data.h"
+#include "sensor_aggregate.h"
+#include "sensor_class.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Integer keys of the compact CBOR reading map
+ */
+typedef enum {
+    SENSOR_CBOR_KEY_ID = 0,     /**< text string, device_id */
+    SENSOR_CBOR_KEY_TEMP = 1,   /**< half or single float, degrees C */
+    SENSOR_CBOR_KEY_HUM = 2,    /**< half or single float, % RH */
+    SENSOR_CBOR_KEY_PRESS = 3,  /**< single float */
+    SENSOR_CBOR_KEY_GAS = 4,    /**< single float */
+    SENSOR_CBOR_KEY_BOOT = 5,   /**< unsigned, border router boot counter */
+    SENSOR_CBOR_KEY_SEQ = 6,    /**< unsigned, reading sequence within the boot */
+    SENSOR_CBOR_KEY_COUNT = 7,  /**< unsigned, readings in a window summary */
+    SENSOR_CBOR_KEY_WINDOW = 8, /**< unsigned, window summary duration in ms */
+} sensor_cbor_key_t;
+
+/**
+ * @brief Encode a batch of readings for the thread/sensores topic
+ *
+ * The encoding is selected with CONFIG_SENSOR_PAYLOAD_FORMAT:
+ * - JSON: a single reading is one JSON object (the historical format); two
+ *   or more are a JSON array of those objects.
+ * - CBOR: a single reading is one map keyed by sensor_cbor_key_t; two or
+ *   more are a CBOR array of those maps.
+ *
+ * Metrics a node did not report (NAN) are left out of the object or map.
+ *
+ * Every reading carries its (boot, seq) pair so that readings replayed from
+ * the spool can be deduplicated downstream.
+ *
+ * Readings that do not fit in the buffer are left out, so the caller can
+ * publish what was encoded and retry the rest in the next batch.
+ *
+ * @param readings Readings to encode, oldest first
+ * @param count    Number of readings
+ * @param buf      Output buffer
+ * @param size     Size of the output buffer
+ * @param[out] len Number of bytes written (not NUL-terminated)
+ * @return Number of readings encoded, 0 if not even one fits
+ */
+size_t sensor_serializer_encode(sensor_data_t *const *readings, size_t count,
+                                uint8_t *buf, size_t size, size_t *len);
+
+/**
+ * @brief Encode a batch of window summaries for the thread/sensores/resumen topic
+ *
+ * Same framing and encoding choice as sensor_serializer_encode(). In JSON a
+ * summary is {"id","n","win",<metric>:{"min","max","mean","last"},"boot","seq"};
+ * in CBOR it is a map where COUNT and WINDOW hold n and win, and each metric
+ * key holds a [min, max, mean, last] array. Metrics no reading carried are
+ * left out; (boot, seq) are those of the last reading in the window.
+ *
+ * @return Number of summaries encoded, 0 if not even one fits
+ */
+size_t sensor_serializer_encode_summaries(const sensor_summary_t *summaries, size_t count,
+                                          uint8_t *buf, size_t size, size_t *len);
+
+/**
+ * @brief Encode a batch of typed class records (see sensor_class.h)
+ *
+ * Same framing and encoding choice as sensor_serializer_encode(). A record
+ * is {"id", <key>: value, ...} in JSON, with the keys of the class field
+ * table; in CBOR the map is keyed by SENSOR_CBOR_KEY_ID and by each field's
+ * frame metric type (0x20, 0x21, ...). Integer fields stay integers; metrics
+ * the node did not report are left out.
+ *
+ * @return Number of records encoded, 0 if not even one fits
+ */
+size_t sensor_serializer_encode_records(const sensor_class_info_t *info, const void *const *records,
+                                        size_t count, uint8_t *buf, size_t size, size_t *len);
+
+/**
+ * @brief Whether the selected encoding is printable text (for logging)
+ */
+static inline int sensor_serializer_is_text(void)
+{
+#if CONFIG_SENSOR_PAYLOAD_CBOR
+    return 0;
+#else
+    return 1;
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SENSOR_SERIALIZER_H
@@ -0,0 +1,404 @@
+#include "sensor_spool.h"
+#include <stddef.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "device_registry.h"
+
+static const char *TAG = "SENSOR_SPOOL";
+
+#define SPOOL_PARTITION_LABEL   "spool"
+#define SPOOL_SECTOR_SIZE       4096
+#define SPOOL_RECORD_SIZE       64
+#define SPOOL_RECORDS_PER_SECTOR (SPOOL_SECTOR_SIZE / SPOOL_RECORD_SIZE)  // el slot 0 es la cabecera
+#define SPOOL_SECTOR_MAGIC      0x53504C31u  // "SPL1"
+#define SPOOL_RECORD_MAGIC      0x5352u      // "SR"
+#define SPOOL_STATE_PENDING     0xFFFFu
+#define SPOOL_STATE_CONSUMED    0x0000u
+
+// Cabecera de sector: se escribe justo después de borrarlo. seq crece de forma
+// monótona y permite reconstruir el orden del log al arrancar.
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t payload_size;  // sizeof(spool_payload_t) con el que se escribió
+    uint8_t reserved[SPOOL_RECORD_SIZE - 12];
+} spool_sector_header_t;
+
+// Registro de tamaño fijo. "state" se escribe en 0xFFFF y, una vez entregado,
+// se pasa a 0x0000 sin borrar (en NOR flash los bits solo bajan de 1 a 0).
+typedef struct {
+    uint16_t magic;
+    uint16_t state;
+    uint32_t crc;
+    uint8_t payload[SPOOL_RECORD_SIZE - 8];
+} spool_record_t;
+
+_Static_assert(sizeof(spool_sector_header_t) == SPOOL_RECORD_SIZE, "bad spool header size");
+_Static_assert(sizeof(spool_record_t) == SPOOL_RECORD_SIZE, "bad spool record size");
+// Lectura tal como se guarda en flash. Lleva el ID en texto porque los
+// handles del registro no sobreviven a un reinicio; el formato es el de los
+// registros escritos antes de existir el registro, que siguen siendo legibles.
+typedef struct {
+    char device_id[16];
+    float temperature;
+    float pressure;
+    float humidity;
+    float gas_concentration;
+    uint32_t seq;
+    uint16_t boot;
+} spool_payload_t;
+
+_Static_assert(sizeof(spool_payload_t) <= sizeof(((spool_record_t *)0)->payload),
+               "spool_payload_t no cabe en un registro del spool");
+
+typedef struct {
+    uint32_t sector;
+    uint32_t index;
+} spool_pos_t;
+
+static const esp_partition_t *s_partition = NULL;
+static uint32_t s_sector_count = 0;
+static uint32_t s_head_seq = 0;
+static spool_pos_t s_head;  // siguiente posición de escritura
+static spool_pos_t s_tail;  // registro pendiente más antiguo
+static sensor_spool_stats_t s_stats;
+
+static inline size_t record_offset(spool_pos_t pos)
+{
+    return (size_t)pos.sector * SPOOL_SECTOR_SIZE + (size_t)pos.index * SPOOL_RECORD_SIZE;
+}
+
+// Posición (sensor_spool_consume()) del registro pendiente más antiguo: cada
+// registro que sale de la cola, entregado o perdido, avanza una
+static inline uint32_t tail_position(void)
+{
+    return s_stats.replayed + s_stats.dropped;
+}
+
+static inline bool pos_equal(spool_pos_t a, spool_pos_t b)
+{
+    return a.sector == b.sector && a.index == b.index;
+}
+
+static inline uint32_t payload_crc(const spool_record_t *record)
+{
+    return esp_rom_crc32_le(0, record->payload, sizeof(spool_payload_t));
+}
+
+static bool record_is_pending(const spool_record_t *record)
+{
+    return record->magic == SPOOL_RECORD_MAGIC &&
+           record->state == SPOOL_STATE_PENDING &&
+           record->crc == payload_crc(record);
+}
+
+static bool read_sector_header(uint32_t sector, spool_sector_header_t *header)
+{
+    if (esp_partition_read(s_partition, (size_t)sector * SPOOL_SECTOR_SIZE, header, sizeof(*header)) != ESP_OK) {
+        return false;
+    }
+    return header->magic == SPOOL_SECTOR_MAGIC && header->payload_size == sizeof(spool_payload_t);
+}
+
+// Avanza una posición de lectura, saltando la cabecera del sector siguiente
+static void advance(spool_pos_t *pos)
+{
+    pos->index++;
+    if (pos->index >= SPOOL_RECORDS_PER_SECTOR) {
+        pos->sector = (pos->sector + 1) % s_sector_count;
+        pos->index = 1;
+    }
+}
+
+// Cuenta los registros pendientes de un sector desde first_index
+static uint32_t count_pending(uint32_t sector, uint32_t first_index)
+{
+    spool_record_t record;
+    uint32_t pending = 0;
+
+    for (uint32_t i = first_index; i < SPOOL_RECORDS_PER_SECTOR; i++) {
+        spool_pos_t pos = { .sector = sector, .index = i };
+        if (esp_partition_read(s_partition, record_offset(pos), &record, sizeof(record)) == ESP_OK &&
+            record_is_pending(&record)) {
+            pending++;
+        }
+    }
+    return pending;
+}
+
+// Abre el siguiente sector del anillo para escritura. Si todavía contiene
+// datos sin entregar, se pierden (spool lleno): se sacrifica lo más antiguo.
+static esp_err_t open_next_sector(void)
+{
+    uint32_t next = (s_head.sector + 1) % s_sector_count;
+
+    if (s_stats.pending > 0 && s_tail.sector == next) {
+        uint32_t lost = count_pending(next, s_tail.index);
+        s_stats.pending -= lost;
+        s_stats.dropped += lost;
+        s_tail.sector = (next + 1) % s_sector_count;
+        s_tail.index = 1;
+        ESP_LOGW(TAG, "Spool full, dropped %lu oldest records", (unsigned long)lost);
+    }
+
+    esp_err_t err = esp_partition_erase_range(s_partition, (size_t)next * SPOOL_SECTOR_SIZE, SPOOL_SECTOR_SIZE);
+    if (err != ESP_OK) {
+        return err;
+    }
+    s_stats.erases++;
+
+    spool_sector_header_t header;
+    memset(&header, 0xFF, sizeof(header));
+    header.magic = SPOOL_SECTOR_MAGIC;
+    header.seq = s_head_seq + 1;
+    header.payload_size = sizeof(spool_payload_t);
+    err = esp_partition_write(s_partition, (size_t)next * SPOOL_SECTOR_SIZE, &header, sizeof(header));
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    s_head_seq = header.seq;
+    s_head.sector = next;
+    s_head.index = 1;
+    if (s_stats.pending == 0) {
+        s_tail = s_head;
+    }
+    return ESP_OK;
+}
+
+// Reconstruye cabeza, cola y pendientes a partir del contenido de la flash
+static void scan(void)
+{
+    spool_sector_header_t header;
+    spool_record_t record;
+    bool found = false;
+
+    for (uint32_t sector = 0; sector < s_sector_count; sector++) {
+        if (read_sector_header(sector, &header) && (!found || header.seq > s_head_seq)) {
+            found = true;
+            s_head_seq = header.seq;
+            s_head.sector = sector;
+        }
+    }
+
+    if (!found) {
+        // Partición virgen: el primer append abrirá el sector 0
+        s_head.sector = s_sector_count - 1;
+        s_head.index = SPOOL_RECORDS_PER_SECTOR;
+        s_tail = s_head;
+        return;
+    }
+
+    // Primer hueco libre del sector cabeza
+    s_head.index = SPOOL_RECORDS_PER_SECTOR;
+    for (uint32_t i = 1; i < SPOOL_RECORDS_PER_SECTOR; i++) {
+        spool_pos_t pos = { .sector = s_head.sector, .index = i };
+        if (esp_partition_read(s_partition, record_offset(pos), &record, sizeof(record)) == ESP_OK &&
+            record.magic == 0xFFFF) {
+            s_head.index = i;
+            break;
+        }
+    }
+
+    // Recorrer del sector más antiguo (el siguiente a la cabeza) al más nuevo
+    bool tail_found = false;
+    for (uint32_t n = 1; n <= s_sector_count; n++) {
+        uint32_t sector = (s_head.sector + n) % s_sector_count;
+        if (!read_sector_header(sector, &header) || header.seq > s_head_seq) {
+            continue;
+        }
+        uint32_t end = (sector == s_head.sector) ? s_head.index : SPOOL_RECORDS_PER_SECTOR;
+        for (uint32_t i = 1; i < end; i++) {
+            spool_pos_t pos = { .sector = sector, .index = i };
+            if (esp_partition_read(s_partition, record_offset(pos), &record, sizeof(record)) == ESP_OK &&
+                record_is_pending(&record)) {
+                if (!tail_found) {
+                    s_tail = pos;
+                    tail_found = true;
+                }
+                s_stats.pending++;
+            }
+        }
+    }
+
+    if (!tail_found) {
+        s_tail = s_head;
+    }
+}
+
+esp_err_t sensor_spool_init(void)
+{
+    s_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                           SPOOL_PARTITION_LABEL);
+    if (s_partition == NULL) {
+        ESP_LOGW(TAG, "No '%s' partition, store-and-forward disabled", SPOOL_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    s_sector_count = s_partition->size / SPOOL_SECTOR_SIZE;
+    if (s_sector_count < 2) {
+        ESP_LOGE(TAG, "Spool partition too small (%lu bytes)", (unsigned long)s_partition->size);
+        s_partition = NULL;
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.capacity = s_sector_count * (SPOOL_RECORDS_PER_SECTOR - 1);
+    scan();
+
+    ESP_LOGI(TAG, "Spool mounted: %lu sectors, %lu pending records (capacity %lu)",
+             (unsigned long)s_sector_count, (unsigned long)s_stats.pending,
+             (unsigned long)s_stats.capacity);
+    return ESP_OK;
+}
+
+esp_err_t sensor_spool_append(sensor_data_t *const *readings, size_t count)
+{
+    if (s_partition == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    spool_record_t record;
+    for (size_t i = 0; i < count; i++) {
+        if (s_head.index >= SPOOL_RECORDS_PER_SECTOR) {
+            esp_err_t err = open_next_sector();
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to open spool sector: %s", esp_err_to_name(err));
+                return err;
+            }
+        }
+
+        memset(&record, 0xFF, sizeof(record));
+        record.magic = SPOOL_RECORD_MAGIC;
+        record.state = SPOOL_STATE_PENDING;
+        spool_payload_t payload = {
+            .temperature = readings[i]->temperature,
+            .pressure = readings[i]->pressure,
+            .humidity = readings[i]->humidity,
+            .gas_concentration = readings[i]->gas_concentration,
+            .seq = readings[i]->seq,
+            .boot = readings[i]->boot,
+        };
+        strncpy(payload.device_id, device_registry_name(readings[i]->device), sizeof(payload.device_id) - 1);
+        memcpy(record.payload, &payload, sizeof(payload));
+        record.crc = payload_crc(&record);
+
+        spool_pos_t written = s_head;
+        esp_err_t err = esp_partition_write(s_partition, record_offset(written), &record, sizeof(record));
+        // Aunque la escritura falle el hueco queda usado: el CRC lo invalidará.
+        // La cabeza no usa advance(): el cambio de sector lo hace open_next_sector()
+        s_head.index++;
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to write spool record: %s", esp_err_to_name(err));
+            return err;
+        }
+        if (s_stats.pending == 0) {
+            s_tail = written;
+        }
+        s_stats.pending++;
+        s_stats.appended++;
+    }
+    return ESP_OK;
+}
+
+size_t sensor_spool_peek(sensor_data_t *out, size_t max, uint32_t *first)
+{
+    spool_record_t record;
+    spool_pos_t pos = s_tail;
+    size_t copied = 0;
+
+    *first = tail_position();
+    if (s_partition == NULL) {
+        return 0;
+    }
+    device_registry_replay_reset();
+
+    while (copied < max && copied < s_stats.pending && !pos_equal(pos, s_head)) {
+        if (pos.index >= SPOOL_RECORDS_PER_SECTOR) {
+            advance(&pos);
+            continue;
+        }
+        if (esp_partition_read(s_partition, record_offset(pos), &record, sizeof(record)) == ESP_OK &&
+            record_is_pending(&record)) {
+            spool_payload_t payload;
+            memcpy(&payload, record.payload, sizeof(payload));
+            payload.device_id[sizeof(payload.device_id) - 1] = '\0';
+            // El dispositivo puede no estar ya (o aún) en el registro: las
+            // lecturas reenviadas llevan un handle temporal con su ID. Un
+            // registro sin ID sale con DEVICE_HANDLE_INVALID para descartarlo
+            uint16_t device = DEVICE_HANDLE_INVALID;
+            if (payload.device_id[0] != '\0') {
+                device = device_registry_replay_handle(payload.device_id);
+                if (device == DEVICE_HANDLE_INVALID) {
+                    break;
+                }
+            }
+            out[copied++] = (sensor_data_t){
+                .device = device,
+                .boot = payload.boot,
+                .seq = payload.seq,
+                .temperature = payload.temperature,
+                .pressure = payload.pressure,
+                .humidity = payload.humidity,
+                .gas_concentration = payload.gas_concentration,
+            };
+        }
+        advance(&pos);
+    }
+    return copied;
+}
+
+esp_err_t sensor_spool_consume(uint32_t first, size_t count)
+{
+    spool_record_t record;
+    const uint16_t consumed = SPOOL_STATE_CONSUMED;
+
+    if (s_partition == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Lo que ya salió de la cola desde el peek (perdido por spool lleno) no
+    // se vuelve a contar
+    uint32_t gone = tail_position() - first;
+    if (gone >= count) {
+        return ESP_OK;
+    }
+    count -= gone;
+
+    while (count > 0 && s_stats.pending > 0 && !pos_equal(s_tail, s_head)) {
+        if (s_tail.index >= SPOOL_RECORDS_PER_SECTOR) {
+            advance(&s_tail);
+            continue;
+        }
+        size_t offset = record_offset(s_tail);
+        if (esp_partition_read(s_partition, offset, &record, sizeof(record)) == ESP_OK &&
+            record_is_pending(&record)) {
+            esp_err_t err = esp_partition_write(s_partition, offset + offsetof(spool_record_t, state),
+                                                &consumed, sizeof(consumed));
+            if (err != ESP_OK) {
+                return err;
+            }
+            s_stats.pending--;
+            s_stats.replayed++;
+            count--;
+        }
+        advance(&s_tail);
+    }
+
+    if (s_stats.pending == 0) {
+        s_tail = s_head;
+    }
+    return ESP_OK;
+}
+
+size_t sensor_spool_pending(void)
+{
+    return s_stats.pending;
+}
+
+void sensor_spool_get_stats(sensor_spool_stats_t *stats)
+{
+    *stats = s_stats;
+}
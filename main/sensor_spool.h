@@ -0,0 +1,87 @@
+#ifndef SENSOR_SPOOL_H
+#define SENSOR_SPOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "shared_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Spool counters
+ */
+typedef struct {
+    uint32_t capacity;  /**< Records the partition can hold */
+    uint32_t pending;   /**< Records waiting to be replayed */
+    uint32_t appended;  /**< Records written since boot */
+    uint32_t replayed;  /**< Records consumed since boot */
+    uint32_t dropped;   /**< Pending records overwritten because the spool was full */
+    uint32_t erases;    /**< Sector erases since boot */
+} sensor_spool_stats_t;
+
+/**
+ * @brief Mount the store-and-forward spool on the "spool" data partition
+ *
+ * The partition is used as an append-only circular log of fixed-size
+ * records. Sectors are filled and erased strictly in order, so wear is spread
+ * evenly over the whole partition. Records survive reboots and are replayed
+ * in FIFO order. A boot scan restores the read and write positions.
+ *
+ * All spool functions must be called from the AWS task only.
+ *
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND if the partition table has no spool
+ *         (the spool then stays disabled and appends fail)
+ */
+esp_err_t sensor_spool_init(void);
+
+/**
+ * @brief Append readings to the spool
+ *
+ * When the spool is full, the oldest sector is erased and its pending
+ * records are counted as dropped.
+ *
+ * @return ESP_OK, or an error if the spool is unavailable or flash failed
+ */
+esp_err_t sensor_spool_append(sensor_data_t *const *readings, size_t count);
+
+/**
+ * @brief Copy the oldest pending readings without consuming them
+ *
+ * Device IDs are mapped to temporary replay handles (see
+ * device_registry_replay_handle()), valid until the next peek. A record
+ * without a device ID is returned with DEVICE_HANDLE_INVALID.
+ *
+ * @param[out] first Position of the first copied reading, to hand to
+ *                   sensor_spool_consume() once they are delivered
+ * @return Number of readings copied into out
+ */
+size_t sensor_spool_peek(sensor_data_t *out, size_t max, uint32_t *first);
+
+/**
+ * @brief Mark count readings, starting at position first, as delivered
+ *
+ * Positions number the pending readings in the order they leave the spool,
+ * whether consumed or dropped because the spool filled up. Readings of the
+ * range that were dropped after the peek are skipped, so a late
+ * acknowledgement never consumes newer readings that were not sent.
+ */
+esp_err_t sensor_spool_consume(uint32_t first, size_t count);
+
+/**
+ * @brief Number of readings waiting to be replayed
+ */
+size_t sensor_spool_pending(void);
+
+/**
+ * @brief Read the spool counters
+ */
+void sensor_spool_get_stats(sensor_spool_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SENSOR_SPOOL_H
@@ -0,0 +1,121 @@
+#include "serializer_bench.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_timer.h"
+#include "device_registry.h"
+#include "sdkconfig.h"
+#include "sensor_serializer.h"
+
+#define BENCH_JSON_MAX 128
+
+#if CONFIG_NEWLIB_NANO_FORMAT
+// El printf de newlib nano no formatea %f: "%.2f" sale vacío y compararía el
+// codificador contra nada. La referencia parte cada valor en entero y
+// centésimas, lo único que ese printf sabe escribir.
+#define LEGACY_INTEGER_SPLIT true
+#define LEGACY_JSON_MAX 256  // peor caso de cuatro %lu.%02lu, para que nunca se corte
+#define LEGACY_VALUE "%s%lu.%02lu"
+#define LEGACY_FORMAT "{\"id\":\"%s\",\"temp\":" LEGACY_VALUE ",\"hum\":" LEGACY_VALUE ",\"press\":" \
+                      LEGACY_VALUE ",\"gas\":" LEGACY_VALUE ",\"boot\":%u,\"seq\":%lu}"
+
+typedef struct {
+    const char *sign;
+    unsigned long whole;
+    unsigned long hundredths;
+} legacy_split_t;
+
+// En double el producto por 100 es exacto y rint redondea los empates al par,
+// como printf
+static inline legacy_split_t legacy_split(float value)
+{
+    unsigned long cents = (unsigned long)rint(fabs((double)value) * 100.0);
+    return (legacy_split_t){ signbit(value) ? "-" : "", cents / 100, cents % 100 };
+}
+
+// Una lectura con el snprintf de referencia
+static int legacy_encode(char *buf, size_t size, const char *name, const sensor_data_t *data)
+{
+    legacy_split_t t = legacy_split(data->temperature);
+    legacy_split_t h = legacy_split(data->humidity);
+    legacy_split_t p = legacy_split(data->pressure);
+    legacy_split_t g = legacy_split(data->gas_concentration);
+
+    return snprintf(buf, size, LEGACY_FORMAT, name, t.sign, t.whole, t.hundredths, h.sign, h.whole,
+                    h.hundredths, p.sign, p.whole, p.hundredths, g.sign, g.whole, g.hundredths,
+                    (unsigned)data->boot, (unsigned long)data->seq);
+}
+#else
+// Formato de una lectura antes del escritor de coma fija
+#define LEGACY_INTEGER_SPLIT false
+#define LEGACY_JSON_MAX BENCH_JSON_MAX
+#define LEGACY_FORMAT "{\"id\":\"%s\",\"temp\":%.2f,\"hum\":%.2f,\"press\":%.2f,\"gas\":%.2f,\"boot\":%u,\"seq\":%lu}"
+
+// Una lectura con el snprintf de referencia
+static int legacy_encode(char *buf, size_t size, const char *name, const sensor_data_t *data)
+{
+    return snprintf(buf, size, LEGACY_FORMAT, name, data->temperature, data->humidity, data->pressure,
+                    data->gas_concentration, (unsigned)data->boot, (unsigned long)data->seq);
+}
+#endif
+
+// Lectura i de la serie sintética: valores que cambian en cada iteración para
+// que ninguna de las dos rutas se beneficie de repetir dígitos
+static void fill_reading(sensor_data_t *data, uint16_t device, uint32_t i)
+{
+    data->device = device;
+    data->temperature = -10.0f + (float)(i % 5000) * 0.0137f;
+    data->humidity = (float)(i % 1000) * 0.0991f;
+    data->pressure = 950.0f + (float)(i % 1200) * 0.0833f;
+    data->gas_concentration = (float)(i % 4000) * 1.37f;
+    data->boot = 1 + (uint16_t)(i >> 16);
+    data->seq = i;
+}
+
+bool serializer_bench_run(uint32_t iterations, serializer_bench_result_t *result)
+{
+    uint16_t device = DEVICE_HANDLE_BENCH;
+    const char *name = device_registry_name(device);
+    char legacy[LEGACY_JSON_MAX];
+    uint8_t encoded[BENCH_JSON_MAX];
+    sensor_data_t data;
+    sensor_data_t *reading = &data;
+    size_t len = 0;
+
+    memset(result, 0, sizeof(*result));
+    if (iterations == 0) {
+        return false;
+    }
+    result->iterations = iterations;
+    result->integer_split = LEGACY_INTEGER_SPLIT;
+
+    // Las dos pasadas van por separado para no medir el memcmp
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < iterations; i++) {
+        fill_reading(&data, device, i);
+        legacy_encode(legacy, sizeof(legacy), name, &data);
+    }
+    int64_t legacy_us = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (uint32_t i = 0; i < iterations; i++) {
+        fill_reading(&data, device, i);
+        sensor_serializer_encode(&reading, 1, encoded, sizeof(encoded), &len);
+    }
+    int64_t serializer_us = esp_timer_get_time() - start;
+
+    result->snprintf_ns = (uint32_t)(legacy_us * 1000 / iterations);
+    result->serializer_ns = (uint32_t)(serializer_us * 1000 / iterations);
+
+    if (sensor_serializer_is_text()) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            fill_reading(&data, device, i);
+            int n = legacy_encode(legacy, sizeof(legacy), name, &data);
+            sensor_serializer_encode(&reading, 1, encoded, sizeof(encoded), &len);
+            if ((size_t)n != len || memcmp(legacy, encoded, len) != 0) {
+                result->mismatches++;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,43 @@
+#ifndef SERIALIZER_BENCH_H
+#define SERIALIZER_BENCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Result of serializer_bench_run()
+ */
+typedef struct {
+    uint32_t iterations;
+    uint32_t snprintf_ns;   /**< Mean time per reading of the snprintf() reference */
+    uint32_t serializer_ns; /**< Mean time per reading of sensor_serializer_encode() */
+    uint32_t mismatches;    /**< JSON builds: readings where both outputs differ */
+    bool integer_split;     /**< The reference printed integer and hundredths (nano printf) */
+} serializer_bench_result_t;
+
+/**
+ * @brief Time the reading encoder against the snprintf() one it replaced
+ *
+ * Encodes iterations synthetic readings (device "bench") one by one with a
+ * single snprintf() of the historical JSON format and with
+ * sensor_serializer_encode(), on the calling task. In JSON builds both
+ * outputs are also compared. Runs synchronously: keep iterations small when
+ * calling from the OpenThread task.
+ *
+ * With CONFIG_NEWLIB_NANO_FORMAT printf cannot format floats, so the
+ * reference prints each value as integer and hundredths ("%lu.%02lu")
+ * instead of "%.2f"; the output is the same, only the cost differs.
+ *
+ * @return false if iterations is 0
+ */
+bool serializer_bench_run(uint32_t iterations, serializer_bench_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SERIALIZER_BENCH_H
@@ -1,15 +1,58 @@
 #pragma once
+#include <stddef.h>
+#include <stdint.h>
 #include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
 
-// Estructura de los datos que vienen de los sensores
+// Lectura de un sensor tal como recorre el pipeline. El dispositivo va como
+// handle del registro (device_registry.h); el ID en texto solo se consulta
+// al serializar.
 typedef struct {
-    char device_id[16];
+    uint16_t device;
+    // Campos añadidos por el border router: número de arranque y secuencia
+    // de ingesta, para que la nube deduplique lo que se reenvía desde el spool
+    uint16_t boot;
+    uint32_t seq;
+    // Llegada al handler CoAP (sensor_latency_now_us()); 0 = desconocida,
+    // p. ej. en lecturas reenviadas desde el spool
+    uint32_t ingest_us;
     float temperature;
     float pressure;
     float humidity;
     float gas_concentration;
 } sensor_data_t;
 
-// Referencia externa a la cola, la cual se define en Thread_BR.c
-extern QueueHandle_t g_aws_queue;
\ No newline at end of file
+// Payload heredado que envían los nodos Thread (struct crudo)
+typedef struct {
+    char device_id[16];
+    float temperature;
+    float pressure;
+    float humidity;
+    float gas_concentration;
+} sensor_wire_t;
+
+// Métricas de sensor_data_t; un valor NAN indica que el nodo no la envió
+typedef enum {
+    SENSOR_METRIC_TEMPERATURE = 0,
+    SENSOR_METRIC_HUMIDITY,
+    SENSOR_METRIC_PRESSURE,
+    SENSOR_METRIC_GAS,
+    SENSOR_METRIC_COUNT
+} sensor_metric_t;
+
+static inline float sensor_data_metric(const sensor_data_t *data, sensor_metric_t metric)
+{
+    switch (metric) {
+        case SENSOR_METRIC_TEMPERATURE: return data->temperature;
+        case SENSOR_METRIC_HUMIDITY:    return data->humidity;
+        case SENSOR_METRIC_PRESSURE:    return data->pressure;
+        default:                        return data->gas_concentration;
+    }
+}
+
+// Bytes del payload heredado
+#define SENSOR_DATA_WIRE_SIZE sizeof(sensor_wire_t)
+
+// Payload opcional de las respuestas CoAP del BR a los nodos (little endian)
+typedef struct __attribute__((packed)) {
+    uint32_t report_interval_ms;  // Periodo de reporte que asigna el BR
+} sensor_coap_config_t;
\ No newline at end of file
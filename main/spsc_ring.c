@@ -0,0 +1,151 @@
+#include "spsc_ring.h"
+#include <string.h>
+
+// Los contadores de estadísticas solo los escribe el productor, así que basta
+// con load/store relajados (sin operaciones read-modify-write).
+static inline void counter_add(_Atomic uint32_t *counter, uint32_t value)
+{
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value,
+                          memory_order_relaxed);
+}
+
+static inline uint8_t *slot_at(spsc_ring_t *ring, uint32_t index)
+{
+    return ring->buffer + (size_t)(index & ring->mask) * ring->elem_size;
+}
+
+esp_err_t spsc_ring_init(spsc_ring_t *ring, void *storage, size_t elem_size, uint32_t capacity)
+{
+    if (ring == NULL || storage == NULL || elem_size == 0 ||
+        capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->buffer = storage;
+    ring->elem_size = elem_size;
+    ring->mask = capacity - 1;
+    return ESP_OK;
+}
+
+void *spsc_ring_reserve(spsc_ring_t *ring)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    if (head - ring->tail_cache > ring->mask) {
+        // Solo se relee el índice del consumidor cuando la copia local dice "lleno"
+        ring->tail_cache = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (head - ring->tail_cache > ring->mask) {
+            counter_add(&ring->dropped, 1);
+            return NULL;
+        }
+    }
+    return slot_at(ring, head);
+}
+
+// Publica count elementos ya escritos. El store de head y el load de tail son
+// seq_cst para que, frente al release() del consumidor, al menos uno de los dos
+// vea el cambio del otro: así nunca se pierde una notificación de "ya no vacío".
+static uint32_t publish(spsc_ring_t *ring, uint32_t count)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed) + count;
+
+    atomic_store_explicit(&ring->head, head, memory_order_seq_cst);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_seq_cst);
+    ring->tail_cache = tail;
+
+    uint32_t used = head - tail;
+    if (used > atomic_load_explicit(&ring->high_water, memory_order_relaxed)) {
+        atomic_store_explicit(&ring->high_water, used, memory_order_relaxed);
+    }
+    counter_add(&ring->pushed, count);
+    return used;
+}
+
+uint32_t spsc_ring_commit(spsc_ring_t *ring)
+{
+    return publish(ring, 1);
+}
+
+uint32_t spsc_ring_push_batch(spsc_ring_t *ring, const void *items, uint32_t count, uint32_t *used)
+{
+    const uint8_t *src = items;
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t capacity = ring->mask + 1;
+
+    if (capacity - (head - ring->tail_cache) < count) {
+        ring->tail_cache = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    }
+
+    uint32_t space = capacity - (head - ring->tail_cache);
+    uint32_t n = (count < space) ? count : space;
+
+    for (uint32_t i = 0; i < n; i++) {
+        memcpy(slot_at(ring, head + i), src + (size_t)i * ring->elem_size, ring->elem_size);
+    }
+
+    uint32_t occupancy = head - ring->tail_cache;
+    if (n > 0) {
+        occupancy = publish(ring, n);
+    }
+    if (n < count) {
+        counter_add(&ring->dropped, count - n);
+    }
+    if (used != NULL) {
+        *used = occupancy;
+    }
+    return n;
+}
+
+uint32_t spsc_ring_available(spsc_ring_t *ring)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    ring->head_cache = atomic_load_explicit(&ring->head, memory_order_seq_cst);
+    return ring->head_cache - tail;
+}
+
+void *spsc_ring_peek(spsc_ring_t *ring, uint32_t index)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    if (ring->head_cache - tail <= index && spsc_ring_available(ring) <= index) {
+        return NULL;
+    }
+    return slot_at(ring, tail + index);
+}
+
+void spsc_ring_release(spsc_ring_t *ring, uint32_t count)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    atomic_store_explicit(&ring->tail, tail + count, memory_order_seq_cst);
+}
+
+uint32_t spsc_ring_pop_batch(spsc_ring_t *ring, void *out, uint32_t max)
+{
+    uint8_t *dst = out;
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t ready = spsc_ring_available(ring);
+    uint32_t n = (ready < max) ? ready : max;
+
+    for (uint32_t i = 0; i < n; i++) {
+        memcpy(dst + (size_t)i * ring->elem_size, slot_at(ring, tail + i), ring->elem_size);
+    }
+    if (n > 0) {
+        spsc_ring_release(ring, n);
+    }
+    return n;
+}
+
+void spsc_ring_get_stats(spsc_ring_t *ring, spsc_ring_stats_t *stats)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    stats->capacity = ring->mask + 1;
+    stats->used = (head - tail > stats->capacity) ? stats->capacity : head - tail;
+    stats->high_water = atomic_load_explicit(&ring->high_water, memory_order_relaxed);
+    stats->pushed = atomic_load_explicit(&ring->pushed, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+}
@@ -0,0 +1,131 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef CONFIG_ESP32S3_DATA_CACHE_LINE_SIZE
+#define SPSC_RING_CACHE_LINE CONFIG_ESP32S3_DATA_CACHE_LINE_SIZE
+#else
+#define SPSC_RING_CACHE_LINE 64
+#endif
+
+/**
+ * @brief Lock-free single-producer / single-consumer ring of fixed-size elements
+ *
+ * The producer owns `head`, the consumer owns `tail`; each sits on its own
+ * cache line together with a private copy of the other side's index, so the
+ * hot path never takes a kernel critical section and rarely touches the
+ * other core's line. Indices run freely and are masked on access, which
+ * requires a power-of-two capacity.
+ *
+ * Slots are accessed in place: the producer fills the slot returned by
+ * spsc_ring_reserve() and publishes it with spsc_ring_commit(); the consumer
+ * reads spsc_ring_peek() slots and hands them back in FIFO order with
+ * spsc_ring_release().
+ */
+typedef struct {
+    // Lado productor
+    _Atomic uint32_t head __attribute__((aligned(SPSC_RING_CACHE_LINE)));
+    uint32_t tail_cache;
+    _Atomic uint32_t high_water;
+    _Atomic uint32_t pushed;
+    _Atomic uint32_t dropped;
+
+    // Lado consumidor
+    _Atomic uint32_t tail __attribute__((aligned(SPSC_RING_CACHE_LINE)));
+    uint32_t head_cache;
+
+    // Configuración (solo lectura tras init)
+    uint8_t *buffer __attribute__((aligned(SPSC_RING_CACHE_LINE)));
+    size_t elem_size;
+    uint32_t mask;
+} spsc_ring_t;
+
+/**
+ * @brief Snapshot of ring occupancy counters
+ */
+typedef struct {
+    uint32_t capacity;   /**< Number of slots */
+    uint32_t used;       /**< Slots currently holding data */
+    uint32_t high_water; /**< Highest occupancy ever observed */
+    uint32_t pushed;     /**< Elements committed since init */
+    uint32_t dropped;    /**< Reservations refused because the ring was full */
+} spsc_ring_stats_t;
+
+/**
+ * @brief Initialize a ring over caller-provided storage
+ *
+ * @param ring      Ring to initialize
+ * @param storage   Buffer of at least elem_size * capacity bytes
+ * @param elem_size Size of one element in bytes
+ * @param capacity  Number of slots, must be a power of two
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG if capacity is not a power of two
+ */
+esp_err_t spsc_ring_init(spsc_ring_t *ring, void *storage, size_t elem_size, uint32_t capacity);
+
+/**
+ * @brief Get the next free slot (producer only)
+ *
+ * @return Pointer to the slot, or NULL if the ring is full (counted as a drop)
+ */
+void *spsc_ring_reserve(spsc_ring_t *ring);
+
+/**
+ * @brief Publish the slot obtained from spsc_ring_reserve() (producer only)
+ *
+ * @return Occupancy right after the commit; 1 means the ring was empty and
+ *         the consumer may be waiting to be woken up
+ */
+uint32_t spsc_ring_commit(spsc_ring_t *ring);
+
+/**
+ * @brief Copy up to count elements into the ring (producer only)
+ *
+ * @param[out] used Occupancy right after the push (may be NULL)
+ * @return Number of elements pushed; the rest are counted as drops
+ */
+uint32_t spsc_ring_push_batch(spsc_ring_t *ring, const void *items, uint32_t count, uint32_t *used);
+
+/**
+ * @brief Number of elements ready for the consumer (consumer only)
+ */
+uint32_t spsc_ring_available(spsc_ring_t *ring);
+
+/**
+ * @brief Access the index-th ready element without consuming it (consumer only)
+ *
+ * @return Pointer to the element, or NULL if fewer than index + 1 are ready
+ */
+void *spsc_ring_peek(spsc_ring_t *ring, uint32_t index);
+
+/**
+ * @brief Hand the oldest count peeked elements back to the producer (consumer only)
+ */
+void spsc_ring_release(spsc_ring_t *ring, uint32_t count);
+
+/**
+ * @brief Copy out and release up to max elements (consumer only)
+ *
+ * @return Number of elements copied into out
+ */
+uint32_t spsc_ring_pop_batch(spsc_ring_t *ring, void *out, uint32_t max);
+
+/**
+ * @brief Read the occupancy counters (safe from any task)
+ */
+void spsc_ring_get_stats(spsc_ring_t *ring, spsc_ring_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SPSC_RING_H
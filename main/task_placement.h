@@ -0,0 +1,34 @@
+#ifndef TASK_PLACEMENT_H
+#define TASK_PLACEMENT_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Core affinity of a CONFIG_TASK_CORE_* option for xTaskCreatePinnedToCore()
+ *
+ * -1 and single-core builds map to tskNO_AFFINITY.
+ */
+#if CONFIG_FREERTOS_UNICORE
+#define TASK_PLACEMENT_CORE(core) tskNO_AFFINITY
+#else
+#define TASK_PLACEMENT_CORE(core) (((core) < 0) ? tskNO_AFFINITY : (BaseType_t)(core))
+#endif
+
+/** OpenThread mainloop (CoAP handlers, spinel) and its helpers */
+#define TASK_CORE_OPENTHREAD    TASK_PLACEMENT_CORE(CONFIG_TASK_CORE_OPENTHREAD)
+/** aws_iot_task: serialization, TLS and MQTT */
+#define TASK_CORE_CLOUD         TASK_PLACEMENT_CORE(CONFIG_TASK_CORE_CLOUD)
+/** Low-rate housekeeping tasks */
+#define TASK_CORE_SERVICES      TASK_PLACEMENT_CORE(CONFIG_TASK_CORE_SERVICES)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TASK_PLACEMENT_H
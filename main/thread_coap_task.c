@@ -2,114 +2,497 @@
 #include <stdio.h>
 #include "esp_log.h"
 #include "esp_openthread.h"
-#include "esp_openthread_lock.h"
 #include "openthread/coap.h"
 #include "openthread/ip6.h"
 #include "openthread/thread.h"
-#include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
+#include "esp_timer.h"
+#include "openthread/instance.h"
+#include "sdkconfig.h"
 #include "shared_data.h"
+#include "thread_coap_task.h"
+#include "sensor_pipeline.h"
+#include "sensor_class.h"
+#include "sensor_frame.h"
+#include "device_registry.h"
+#include "sensor_latency.h"
+#include "metrics.h"
+#include "coap_rate_control.h"
 
 static const char *TAG = "THREAD_COAP";
 
-// Esta función se ejecuta cada vez que llega un mensaje CoAP
-static void coap_handler(void *aContext, otMessage *aMessage, const otMessageInfo *aMessageInfo)
+#define SENSOR_COAP_MAX_OBSERVERS       CONFIG_SENSOR_COAP_MAX_OBSERVERS
+#define SENSOR_FRAME_MAX_SIZE           CONFIG_SENSOR_FRAME_MAX_SIZE
+
+// Nodos registrados con GET + Observe en cualquiera de los recursos
+typedef struct {
+    bool in_use;
+    otMessageInfo info;
+    uint8_t token[OT_COAP_MAX_TOKEN_LENGTH];
+    uint8_t token_len;
+} coap_observer_t;
+
+static coap_observer_t s_observers[SENSOR_COAP_MAX_OBSERVERS];
+static uint32_t s_observe_seq = 2;
+
+// Un recurso CoAP por clase de sensor (sensor_class.h); el contexto del
+// handler es la propia entrada
+typedef struct {
+    otCoapResource resource;
+    otInstance *instance;
+    sensor_class_t cls;
+} coap_class_resource_t;
+
+static coap_class_resource_t s_resources[SENSOR_CLASS_COUNT];
+static bool s_coap_running = false;
+
+// Métricas de ingesta (metrics.h); se actualizan desde el mainloop de OpenThread
+static metric_t s_metric_requests = METRIC_COUNTER_INIT("coap.requests");
+static metric_t s_metric_readings = METRIC_COUNTER_INIT("coap.readings");
+static metric_t s_metric_dropped = METRIC_COUNTER_INIT("coap.dropped");
+static metric_t s_metric_rejected = METRIC_COUNTER_INIT("coap.rejected");
+static metric_t s_metric_ack_errors = METRIC_COUNTER_INIT("coap.ack_errors");
+static metric_t s_metric_up = METRIC_GAUGE_INIT("coap.up");
+static metric_t s_metric_starts = METRIC_COUNTER_INIT("coap.starts");
+
+// Añade el intervalo de reporte como payload (sensor_coap_config_t)
+static otError append_report_interval(otMessage *message, uint32_t interval_ms)
 {
-    sensor_data_t received_data;
-    uint16_t length = otMessageGetLength(aMessage) - otMessageGetOffset(aMessage);
+    sensor_coap_config_t config = { .report_interval_ms = interval_ms };
 
-    ESP_LOGI(TAG, ">>> HANDLER COAP EJECUTADO! Mensaje recibido con %d bytes <<<", length);
+    otError error = otCoapMessageAppendContentFormatOption(message, OT_COAP_OPTION_CONTENT_FORMAT_OCTET_STREAM);
+    if (error == OT_ERROR_NONE) {
+        error = otCoapMessageSetPayloadMarker(message);
+    }
+    if (error == OT_ERROR_NONE) {
+        error = otMessageAppend(message, &config, sizeof(config));
+    }
+    return error;
+}
 
-    // Verificar que el tamaño del mensaje sea correcto
-    if (length < sizeof(sensor_data_t)) {
-        ESP_LOGE(TAG, "Payload muy pequeño (%d bytes, esperado %d)", length, sizeof(sensor_data_t));
+// ACK con respuesta incluida (piggybacked) para los mensajes confirmables.
+// Los no confirmables no llevan respuesta: el nodo no la espera. Si
+// interval_ms no es 0, el ACK le asigna al nodo ese periodo de reporte.
+static void send_ack(otInstance *instance, const otMessage *request,
+                     const otMessageInfo *info, otCoapCode code, uint32_t interval_ms)
+{
+    if (otCoapMessageGetType(request) != OT_COAP_TYPE_CONFIRMABLE) {
         return;
     }
 
-    // 1. Leer el mensaje
-    if (otMessageRead(aMessage, otMessageGetOffset(aMessage), &received_data, sizeof(received_data)) != length) {
-        ESP_LOGE(TAG, "Error leyendo mensaje CoAP");
+    otMessage *response = otCoapNewMessage(instance, NULL);
+    if (response == NULL) {
+        ESP_LOGW(TAG, "Sin buffers para la respuesta CoAP");
+        metric_inc(&s_metric_ack_errors);
         return;
     }
 
-    ESP_LOGI(TAG, ">>> Recibido de Thread: ID=%s, Temp=%.2f, Hum=%.2f, Press=%.2f, Gas=%.2f",
-             received_data.device_id, received_data.temperature,
-             received_data.humidity, received_data.pressure, received_data.gas_concentration);
+    otError error = otCoapMessageInitResponse(response, request, OT_COAP_TYPE_ACKNOWLEDGMENT, code);
+    if (error == OT_ERROR_NONE && interval_ms > 0) {
+        error = append_report_interval(response, interval_ms);
+    }
+    if (error == OT_ERROR_NONE) {
+        error = otCoapSendResponse(instance, response, info);
+    }
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGW(TAG, "Error enviando respuesta CoAP (error %d)", error);
+        metric_inc(&s_metric_ack_errors);
+        otMessageFree(response);
+    }
+}
+
+// Notificación Observe (NON, 2.05) con el nuevo periodo a todos los observadores
+static void notify_observers(otInstance *instance, uint32_t interval_ms)
+{
+    s_observe_seq = (s_observe_seq + 1) & 0xFFFFFF;  // la opción Observe es de 24 bits
 
-    // 2. Enviar a la cola de AWS
-    if (g_aws_queue != NULL) {
-        if (xQueueSend(g_aws_queue, &received_data, 0) != pdTRUE) {
-            ESP_LOGW(TAG, "Cola AWS llena, descartando dato");
-        } else {
-            ESP_LOGI(TAG, "Dato enviado a cola AWS exitosamente");
+    for (size_t i = 0; i < SENSOR_COAP_MAX_OBSERVERS; i++) {
+        coap_observer_t *observer = &s_observers[i];
+        if (!observer->in_use) {
+            continue;
+        }
+
+        otMessage *message = otCoapNewMessage(instance, NULL);
+        if (message == NULL) {
+            ESP_LOGW(TAG, "Sin buffers para notificar a los observadores");
+            return;
+        }
+
+        otCoapMessageInit(message, OT_COAP_TYPE_NON_CONFIRMABLE, OT_COAP_CODE_CONTENT);
+        otError error = otCoapMessageSetToken(message, observer->token, observer->token_len);
+        if (error == OT_ERROR_NONE) {
+            error = otCoapMessageAppendObserveOption(message, s_observe_seq);
+        }
+        if (error == OT_ERROR_NONE) {
+            error = append_report_interval(message, interval_ms);
+        }
+        if (error == OT_ERROR_NONE) {
+            error = otCoapSendResponse(instance, message, &observer->info);
+        }
+        if (error != OT_ERROR_NONE) {
+            ESP_LOGW(TAG, "Error notificando a un observador (error %d)", error);
+            otMessageFree(message);
         }
-    } else {
-        ESP_LOGE(TAG, "ERROR: g_aws_queue es NULL - la cola no fue inicializada");
     }
+}
 
-    // 3. Responder con ACK (Opcional pero recomendado)
-    if (aMessageInfo != NULL) {
-         // Aquí iría la lógica simple de respuesta (omitiendo para brevedad)
-         (void)aContext; // Suprimir advertencia de variable no usada
+static coap_observer_t *find_observer(const otMessageInfo *info)
+{
+    for (size_t i = 0; i < SENSOR_COAP_MAX_OBSERVERS; i++) {
+        if (s_observers[i].in_use && s_observers[i].info.mPeerPort == info->mPeerPort &&
+            otIp6IsAddressEqual(&s_observers[i].info.mPeerAddr, &info->mPeerAddr)) {
+            return &s_observers[i];
+        }
     }
+    return NULL;
 }
 
-// Tarea que espera a que OpenThread esté operativo y registra el servidor CoAP
-static void coap_server_task(void *pvParameters)
+// Registra (Observe = 0) o da de baja (Observe = 1) al nodo que envía el GET
+static bool update_observer(const otMessage *request, const otMessageInfo *info, uint64_t observe)
 {
-    otInstance *instance = NULL;
-    otDeviceRole role = OT_DEVICE_ROLE_DISABLED;
+    coap_observer_t *observer = find_observer(info);
 
-    ESP_LOGI(TAG, "Tarea CoAP iniciada, esperando a que OpenThread esté listo...");
+    if (observe != 0) {
+        if (observer != NULL) {
+            observer->in_use = false;
+        }
+        return false;
+    }
 
-    // Paso 1: Esperar hasta que OpenThread esté completamente inicializado
-    while (instance == NULL) {
-        vTaskDelay(pdMS_TO_TICKS(500));
-        instance = esp_openthread_get_instance();
+    for (size_t i = 0; observer == NULL && i < SENSOR_COAP_MAX_OBSERVERS; i++) {
+        if (!s_observers[i].in_use) {
+            observer = &s_observers[i];
+        }
+    }
+    if (observer == NULL) {
+        ESP_LOGW(TAG, "Tabla de observadores llena");
+        return false;
     }
 
-    ESP_LOGI(TAG, "Instancia de OpenThread obtenida");
+    observer->in_use = true;
+    observer->info = *info;
+    observer->token_len = otCoapMessageGetTokenLength(request);
+    memcpy(observer->token, otCoapMessageGetToken(request), observer->token_len);
+    return true;
+}
 
-    // Paso 2: Esperar hasta que OpenThread tenga un rol activo (child, router o leader)
-    ESP_LOGI(TAG, "Esperando a que OpenThread tenga rol activo...");
-    while (role == OT_DEVICE_ROLE_DISABLED || role == OT_DEVICE_ROLE_DETACHED) {
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        esp_openthread_lock_acquire(portMAX_DELAY);
-        role = otThreadGetDeviceRole(instance);
-        esp_openthread_lock_release();
+// GET a un recurso de sensores: devuelve el intervalo de reporte vigente. Con la opción
+// Observe el nodo queda registrado para recibir los cambios de intervalo.
+static void handle_get(otInstance *instance, otMessage *request, const otMessageInfo *info)
+{
+    otCoapOptionIterator iterator;
+    uint64_t observe = 0;
+    bool has_observe = false;
+    bool registered = false;
+
+    if (otCoapOptionIteratorInit(&iterator, request) == OT_ERROR_NONE &&
+        otCoapOptionIteratorGetFirstOptionMatching(&iterator, OT_COAP_OPTION_OBSERVE) != NULL &&
+        otCoapOptionIteratorGetOptionUintValue(&iterator, &observe) == OT_ERROR_NONE) {
+        has_observe = true;
+    }
+    if (has_observe) {
+        registered = update_observer(request, info, observe);
+    }
+
+    otMessage *response = otCoapNewMessage(instance, NULL);
+    if (response == NULL) {
+        ESP_LOGW(TAG, "Sin buffers para la respuesta CoAP");
+        return;
+    }
+
+    otCoapType type = (otCoapMessageGetType(request) == OT_COAP_TYPE_CONFIRMABLE) ?
+                      OT_COAP_TYPE_ACKNOWLEDGMENT : OT_COAP_TYPE_NON_CONFIRMABLE;
+    otError error = otCoapMessageInitResponse(response, request, type, OT_COAP_CODE_CONTENT);
+    if (error == OT_ERROR_NONE && registered) {
+        error = otCoapMessageAppendObserveOption(response, s_observe_seq);
+    }
+    if (error == OT_ERROR_NONE) {
+        error = append_report_interval(response, rate_control_fleet_period());
+    }
+    if (error == OT_ERROR_NONE) {
+        error = otCoapSendResponse(instance, response, info);
+    }
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGW(TAG, "Error enviando respuesta CoAP (error %d)", error);
+        otMessageFree(response);
+    }
+}
+
+// Control de ritmo: cada lectura cuenta como demanda del nodo, aunque luego
+// se descarte por falta de sitio. Devuelve el periodo asignado.
+static uint32_t pace_device(otInstance *instance, uint16_t device, size_t count)
+{
+    uint32_t fleet_period = rate_control_fleet_period();
+    uint32_t interval_ms = rate_control_on_reading(device, count);
+
+    if (rate_control_fleet_period() != fleet_period) {
+        notify_observers(instance, rate_control_fleet_period());
+    }
+    return interval_ms;
+}
+
+// Identificador de interfaz de la dirección mesh del nodo (ML-EID): estable
+// mientras el nodo siga en la misma red
+static inline const uint8_t *peer_iid(const otMessageInfo *info)
+{
+    return &info->mPeerAddr.mFields.m8[OT_IP6_ADDRESS_SIZE - DEVICE_REGISTRY_IID_LEN];
+}
+
+// Handle del dispositivo: por su ID si la trama lo trae, si no por la
+// dirección desde la que envía
+static uint16_t resolve_device(const char *device_id, const otMessageInfo *info)
+{
+    if (device_id[0] == '\0') {
+        return device_registry_find_by_iid(peer_iid(info));
+    }
+    return device_registry_resolve(device_id, peer_iid(info));
+}
+
+// Payload CoAP como origen de sensor_frame: cada registro se lee del mensaje
+// de OpenThread en su posición, sin copiar la trama entera
+typedef struct {
+    const otMessage *message;
+    uint16_t offset;
+} coap_payload_t;
+
+static size_t read_payload(const void *source, size_t offset, void *buf, size_t len)
+{
+    const coap_payload_t *payload = source;
+
+    return otMessageRead(payload->message, payload->offset + offset, buf, len);
+}
+
+// Cierra un tramo de lecturas de un mismo dispositivo: lo anota y lo pasa por
+// el control de ritmo con su número de lecturas, entraran o no en la cola. El
+// ACK lleva el periodo del primer tramo.
+static void finish_run(otInstance *instance, uint16_t device, size_t run, size_t run_accepted,
+                       uint32_t *interval_ms)
+{
+    if (run == 0) {
+        return;
+    }
+    uint32_t period = pace_device(instance, device, run);
+    if (*interval_ms == 0) {
+        *interval_ms = period;
+    }
+    device_registry_note(device, run_accepted, run - run_accepted);
+}
+
+// Trama versionada (sensor_frame.h): una o varias lecturas por datagrama,
+// decodificadas como registros de la clase del recurso en una sola pasada,
+// leyendo cada registro del mensaje directamente al slot reservado de la
+// cola. Una trama que se corta a mitad deja en la cola las lecturas previas
+// al registro corrupto y recibe 4.00, así que el nodo no la reenvía.
+static void handle_frame(otInstance *instance, sensor_class_t cls, otMessage *request, const otMessageInfo *info,
+                         uint16_t offset, uint16_t length, uint32_t arrival_us)
+{
+    coap_payload_t payload = { .message = request, .offset = offset };
+    sensor_frame_reader_t reader;
+    sensor_class_record_t scratch;
+    char current[sizeof(reader.device_id)] = "";
+    uint16_t first = DEVICE_HANDLE_INVALID;
+    uint16_t device = DEVICE_HANDLE_INVALID;
+    size_t count = 0;
+    size_t accepted = 0;
+    size_t unknown = 0;
+    size_t run = 0;
+    size_t run_accepted = 0;
+    uint32_t interval_ms = 0;
+    bool full = false;
+    esp_err_t err;
+
+    if (length > SENSOR_FRAME_MAX_SIZE) {
+        ESP_LOGE(TAG, "Trama demasiado grande (%d bytes, máximo %d)", length, SENSOR_FRAME_MAX_SIZE);
+        metric_inc(&s_metric_rejected);
+        send_ack(instance, request, info, OT_COAP_CODE_REQUEST_TOO_LARGE, 0);
+        return;
+    }
 
-        if (role == OT_DEVICE_ROLE_DISABLED || role == OT_DEVICE_ROLE_DETACHED) {
-            ESP_LOGI(TAG, "Rol actual: %d (esperando rol activo...)", role);
+    err = sensor_frame_begin(&reader, read_payload, &payload, length);
+    while (err == ESP_OK) {
+        // Con la cola llena el resto de lecturas se decodifica igual, para
+        // validarlas y contarlas como demanda descartada
+        void *slot = full ? NULL : sensor_class_reserve(cls);
+        full = (slot == NULL);
+        err = sensor_class_decode(cls, &reader, full ? (void *)&scratch : slot);
+        if (err != ESP_OK) {
+            if (slot != NULL) {
+                sensor_class_abort(cls, slot);
+            }
+            break;
+        }
+
+        if (count++ == 0 || strncmp(current, reader.device_id, sizeof(current)) != 0) {
+            finish_run(instance, device, run, run_accepted, &interval_ms);
+            memcpy(current, reader.device_id, sizeof(current));
+            device = resolve_device(current, info);
+            run = 0;
+            run_accepted = 0;
+        }
+        if (count == 1 && device == DEVICE_HANDLE_INVALID) {
+            // Sin ID y desde una dirección desconocida el nodo debe
+            // identificarse; con ID, el registro está lleno
+            ESP_LOGW(TAG, "Trama de nodo no registrado (%s)", current[0] ? current : "sin ID");
+            if (slot != NULL) {
+                sensor_class_abort(cls, slot);
+            }
+            metric_inc(&s_metric_rejected);
+            send_ack(instance, request, info,
+                     current[0] ? OT_COAP_CODE_SERVICE_UNAVAILABLE : OT_COAP_CODE_BAD_REQUEST, 0);
+            return;
+        }
+        if (count == 1) {
+            first = device;
+        }
+        if (device == DEVICE_HANDLE_INVALID) {
+            if (slot != NULL) {
+                sensor_class_abort(cls, slot);
+            }
+            unknown++;
+            continue;
+        }
+        run++;
+        if (slot != NULL) {
+            sensor_class_commit(cls, slot, device, arrival_us);
+            run_accepted++;
+            accepted++;
         }
     }
+    finish_run(instance, device, run, run_accepted, &interval_ms);
 
-    ESP_LOGI(TAG, "OpenThread ahora tiene rol activo: %d", role);
+    size_t dropped = count - accepted - unknown;
+    metric_add(&s_metric_readings, accepted);
+    metric_add(&s_metric_dropped, dropped);
 
-    // Paso 3: Iniciar el servidor CoAP
-    esp_openthread_lock_acquire(portMAX_DELAY);
+    if (err != ESP_ERR_NOT_FOUND || count == 0) {
+        uint8_t version = 0;
+        otMessageRead(request, offset, &version, sizeof(version));
+        ESP_LOGE(TAG, "Trama %s inválida (versión 0x%02x, error %s, %d lecturas antes del error)",
+                 sensor_class_get(cls)->name, version, esp_err_to_name(err), (int)count);
+        metric_inc(&s_metric_rejected);
+        send_ack(instance, request, info, OT_COAP_CODE_BAD_REQUEST, 0);
+        return;
+    }
 
-    otError error = otCoapStart(instance, OT_DEFAULT_COAP_PORT);
-    if (error != OT_ERROR_NONE) {
-        ESP_LOGE(TAG, "ERROR: No se pudo iniciar el stack CoAP (error %d)", error);
-        esp_openthread_lock_release();
-        vTaskDelete(NULL);
+    ESP_LOGD(TAG, "Trama %s de %s: %d/%d lecturas aceptadas", sensor_class_get(cls)->name,
+             device_registry_name(first), (int)accepted, (int)count);
+
+    if (dropped > 0) {
+        spsc_ring_stats_t stats;
+        sensor_class_get_stats(cls, &stats);
+        ESP_LOGD(TAG, "Cola %s llena, descartadas %d de %d lecturas (descartes: %lu)",
+                 sensor_class_get(cls)->name, (int)dropped, (int)count, (unsigned long)stats.dropped);
+    }
+    if (accepted < count) {
+        // 5.03: el nodo sabe que la ráfaga no entró entera
+        send_ack(instance, request, info, OT_COAP_CODE_SERVICE_UNAVAILABLE, interval_ms);
+        return;
+    }
+    send_ack(instance, request, info, OT_COAP_CODE_CHANGED, interval_ms);
+}
+
+// Esta función se ejecuta cada vez que llega un mensaje CoAP a cualquiera de
+// los recursos de sensores. Corre en el mainloop de OpenThread con el lock
+// tomado. Las tramas versionadas se decodifican directamente en slots
+// reservados de la cola de la clase; el struct heredado, que solo existe en
+// 'sensordata', se lee una vez para resolver su device_id a un handle.
+static void coap_handler(void *aContext, otMessage *aMessage, const otMessageInfo *aMessageInfo)
+{
+    const coap_class_resource_t *resource = aContext;
+    otInstance *instance = resource->instance;
+    uint32_t arrival_us = sensor_latency_now_us();
+
+    if (otCoapMessageGetCode(aMessage) == OT_COAP_CODE_GET) {
+        handle_get(instance, aMessage, aMessageInfo);
+        return;
+    }
+
+    uint16_t offset = otMessageGetOffset(aMessage);
+    uint16_t length = otMessageGetLength(aMessage) - offset;
+    uint8_t first = 0;
+
+    ESP_LOGD(TAG, "Mensaje CoAP recibido con %d bytes", length);
+    metric_inc(&s_metric_requests);
+
+    // Trama versionada (primer byte >= 0x80) o struct crudo heredado, que
+    // empieza por el device_id en ASCII
+    otMessageRead(aMessage, offset, &first, sizeof(first));
+    if (length > 0 && sensor_frame_is_versioned(&first, sizeof(first))) {
+        handle_frame(instance, resource->cls, aMessage, aMessageInfo, offset, length, arrival_us);
+        return;
+    }
+    if (resource->cls != SENSOR_CLASS_ENVIRONMENT) {
+        ESP_LOGE(TAG, "Payload %s sin trama versionada (%d bytes)", sensor_class_get(resource->cls)->name, length);
+        metric_inc(&s_metric_rejected);
+        send_ack(instance, aMessage, aMessageInfo, OT_COAP_CODE_BAD_REQUEST, 0);
+        return;
+    }
+
+    // Verificar que el tamaño del mensaje sea correcto
+    if (length < SENSOR_DATA_WIRE_SIZE) {
+        ESP_LOGE(TAG, "Payload muy pequeño (%d bytes, esperado %d)", length, SENSOR_DATA_WIRE_SIZE);
+        metric_inc(&s_metric_rejected);
+        send_ack(instance, aMessage, aMessageInfo, OT_COAP_CODE_BAD_REQUEST, 0);
+        return;
+    }
+
+    sensor_wire_t wire;
+    if (otMessageRead(aMessage, offset, &wire, sizeof(wire)) != sizeof(wire)) {
+        ESP_LOGE(TAG, "Error leyendo mensaje CoAP");
+        send_ack(instance, aMessage, aMessageInfo, OT_COAP_CODE_INTERNAL_ERROR, 0);
+        return;
+    }
+    wire.device_id[sizeof(wire.device_id) - 1] = '\0';
+
+    // 0. Resolver el dispositivo a su handle y aplicar el control de ritmo:
+    // cada llegada cuenta como demanda, aunque luego el dato se descarte
+    // Un device_id vacío se resuelve por la dirección, como en las tramas
+    uint16_t device = resolve_device(wire.device_id, aMessageInfo);
+    if (device == DEVICE_HANDLE_INVALID) {
+        metric_inc(&s_metric_rejected);
+        send_ack(instance, aMessage, aMessageInfo,
+                 wire.device_id[0] ? OT_COAP_CODE_SERVICE_UNAVAILABLE : OT_COAP_CODE_BAD_REQUEST, 0);
         return;
     }
-    ESP_LOGI(TAG, "Stack CoAP iniciado en puerto %d", OT_DEFAULT_COAP_PORT);
+    uint32_t interval_ms = pace_device(instance, device, 1);
 
-    // Paso 4: Registrar el recurso 'sensordata'
-    static otCoapResource s_resource;
+    // 1. Reservar un slot en el pipeline hacia AWS
+    sensor_data_t *slot = sensor_pipeline_reserve();
+    if (slot == NULL) {
+        spsc_ring_stats_t stats;
+        sensor_pipeline_get_stats(&stats);
+        device_registry_note(device, 0, 1);
+        metric_inc(&s_metric_dropped);
+        ESP_LOGD(TAG, "Cola AWS llena, descartando dato (descartes: %lu, capacidad: %lu)",
+                 (unsigned long)stats.dropped, (unsigned long)stats.capacity);
+        // 5.03: el nodo sabe que el dato no se aceptó y puede reintentar más tarde
+        send_ack(instance, aMessage, aMessageInfo, OT_COAP_CODE_SERVICE_UNAVAILABLE, interval_ms);
+        return;
+    }
 
-    memset(&s_resource, 0, sizeof(s_resource));
-    s_resource.mUriPath = "sensordata";
-    s_resource.mHandler = coap_handler;
-    s_resource.mContext = instance;
+    // 2. Rellenar el slot: solo viaja el handle, no el texto
+    slot->device = device;
+    slot->ingest_us = arrival_us;
+    slot->temperature = wire.temperature;
+    slot->pressure = wire.pressure;
+    slot->humidity = wire.humidity;
+    slot->gas_concentration = wire.gas_concentration;
 
-    otCoapAddResource(instance, &s_resource);
+    ESP_LOGD(TAG, "Recibido de Thread: ID=%s, Temp=%.2f, Hum=%.2f, Press=%.2f, Gas=%.2f",
+             wire.device_id, slot->temperature,
+             slot->humidity, slot->pressure, slot->gas_concentration);
 
-    ESP_LOGI(TAG, "Recurso CoAP 'sensordata' registrado correctamente");
+    // 3. Entregar el slot al publicador de AWS
+    sensor_pipeline_commit(slot);
+    device_registry_note(device, 1, 0);
+    metric_inc(&s_metric_readings);
 
-    // Paso 5: Mostrar las direcciones IPv6 Thread donde está escuchando
+    // 4. Responder con ACK 2.04 (piggybacked) para que el nodo no retransmita
+    send_ack(instance, aMessage, aMessageInfo, OT_COAP_CODE_CHANGED, interval_ms);
+}
+
+// Muestra las direcciones IPv6 Thread donde escucha el servidor
+static void log_listen_addresses(otInstance *instance)
+{
     const otNetifAddress *addr = otIp6GetUnicastAddresses(instance);
     ESP_LOGI(TAG, "CoAP server escuchando en puerto %d en las siguientes direcciones:", OT_DEFAULT_COAP_PORT);
 
@@ -129,22 +512,110 @@ static void coap_server_task(void *pvParameters)
                  ip6->mFields.m8[12], ip6->mFields.m8[13],
                  ip6->mFields.m8[14], ip6->mFields.m8[15]);
 
-        ESP_LOGI(TAG, "  coap://[%s]:5683/sensordata", addr_str);
+        ESP_LOGI(TAG, "  coap://[%s]:5683", addr_str);
 
         addr = addr->mNext;
     }
+}
+
+static inline bool role_is_attached(otDeviceRole role)
+{
+    return role == OT_DEVICE_ROLE_CHILD || role == OT_DEVICE_ROLE_ROUTER || role == OT_DEVICE_ROLE_LEADER;
+}
+
+// Inicia el stack CoAP y registra un recurso por clase de sensor. Las dos
+// llamadas son idempotentes, así que repetirlas en cada unión a la red
+// restaura el servidor aunque alguien lo haya parado entretanto (p. ej. el
+// comando CLI "coap stop").
+static void coap_server_up(otInstance *instance, otDeviceRole role)
+{
+    otError error = otCoapStart(instance, OT_DEFAULT_COAP_PORT);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "ERROR: No se pudo iniciar el stack CoAP (error %d)", error);
+        return;
+    }
+
+    for (int cls = 0; cls < SENSOR_CLASS_COUNT; cls++) {
+        coap_class_resource_t *resource = &s_resources[cls];
+
+        resource->instance = instance;
+        resource->cls = cls;
+        resource->resource.mUriPath = sensor_class_get(cls)->uri;
+        resource->resource.mHandler = coap_handler;
+        resource->resource.mContext = resource;
+        otCoapAddResource(instance, &resource->resource);
+    }
 
-    esp_openthread_lock_release();
+    if (!s_coap_running) {
+        s_coap_running = true;
+        metric_set(&s_metric_up, 1);
+        metric_inc(&s_metric_starts);
+        ESP_LOGI(TAG, "Servidor CoAP listo (rol %d, %lu ms desde el arranque), %d recursos:",
+                 role, (unsigned long)(esp_timer_get_time() / 1000), SENSOR_CLASS_COUNT);
+        for (int cls = 0; cls < SENSOR_CLASS_COUNT; cls++) {
+            ESP_LOGI(TAG, "  /%s (%s)", sensor_class_get(cls)->uri, sensor_class_get(cls)->name);
+        }
+        log_listen_addresses(instance);
+    }
+}
+
+// Con la interfaz Thread deshabilitada se para el servidor; los recursos se
+// vuelven a registrar al unirse de nuevo
+static void coap_server_down(otInstance *instance)
+{
+    for (int cls = 0; cls < SENSOR_CLASS_COUNT; cls++) {
+        otCoapRemoveResource(instance, &s_resources[cls].resource);
+    }
+    otCoapStop(instance);
+    s_coap_running = false;
+    metric_set(&s_metric_up, 0);
+    ESP_LOGW(TAG, "Thread deshabilitado: servidor CoAP parado hasta la próxima unión a la red");
+}
 
-    ESP_LOGI(TAG, "=== Servidor CoAP completamente inicializado y LISTO para recibir mensajes ===");
+// Cambios de estado de OpenThread; corre en su mainloop con el lock tomado.
+// Un nodo desconectado (detached) sigue escuchando: suele volver enseguida y
+// las lecturas que lleguen por otra ruta siguen siendo válidas.
+static void thread_state_changed(otChangedFlags flags, void *context)
+{
+    otInstance *instance = context;
 
-    // La tarea termina, pero el servidor CoAP sigue corriendo en el stack de OpenThread
-    vTaskDelete(NULL);
+    if ((flags & OT_CHANGED_THREAD_ROLE) == 0) {
+        return;
+    }
+
+    otDeviceRole role = otThreadGetDeviceRole(instance);
+    ESP_LOGI(TAG, "Rol Thread: %d", role);
+    if (role_is_attached(role)) {
+        coap_server_up(instance, role);
+    } else if (role == OT_DEVICE_ROLE_DISABLED && s_coap_running) {
+        coap_server_down(instance);
+    }
 }
 
-// Función pública para iniciar el servidor (crea una tarea)
+esp_err_t thread_coap_server_attach(otInstance *instance)
+{
+    // Sin el callback el servidor no arrancaría nunca: el error se propaga
+    // para que el arranque falle a la vista
+    otError error = otSetStateChangedCallback(instance, thread_state_changed, instance);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "No se pudo registrar el callback de estado de OpenThread (error %d)", error);
+        return ESP_FAIL;
+    }
+
+    // Por si el nodo ya estaba unido a la red al registrar el callback
+    thread_state_changed(OT_CHANGED_THREAD_ROLE, instance);
+    ESP_LOGI(TAG, "Servidor CoAP a la espera de que Thread tenga rol activo");
+    return ESP_OK;
+}
+
+// Función pública para preparar el servidor; arranca al unirse a la red
 void start_thread_coap_server(void)
 {
-    xTaskCreate(coap_server_task, "coap_server", 4096, NULL, 5, NULL);
-    ESP_LOGI(TAG, "Tarea del servidor CoAP creada");
-}
\ No newline at end of file
+    metrics_register(&s_metric_requests);
+    metrics_register(&s_metric_readings);
+    metrics_register(&s_metric_dropped);
+    metrics_register(&s_metric_rejected);
+    metrics_register(&s_metric_ack_errors);
+    metrics_register(&s_metric_up);
+    metrics_register(&s_metric_starts);
+}
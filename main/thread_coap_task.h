@@ -0,0 +1,36 @@
+#ifndef THREAD_COAP_TASK_H
+#define THREAD_COAP_TASK_H
+
+#include "esp_err.h"
+#include "openthread/instance.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Prepare the sensor CoAP server (metrics); called from app_main()
+ *
+ * The server itself comes up from thread_coap_server_attach().
+ */
+void start_thread_coap_server(void);
+
+/**
+ * @brief Drive the CoAP server from OpenThread state changes
+ *
+ * Registers an otSetStateChangedCallback() handler that starts CoAP and adds
+ * one resource per sensor class as soon as the node becomes child, router or
+ * leader, and stops it when the Thread interface is disabled, so the server
+ * follows every detach/re-attach and stack restart without polling. Must be
+ * called once with the OpenThread lock held, after esp_openthread_init().
+ *
+ * @return ESP_OK, or ESP_FAIL if the callback could not be registered (the
+ *         server would never start)
+ */
+esp_err_t thread_coap_server_attach(otInstance *instance);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // THREAD_COAP_TASK_H
@@ -1,11 +1,13 @@
 #include "wifi_connectivity_watchdog.h"
 #include "esp_log.h"
 #include "esp_system.h"
+#include "metrics.h"
 #include "esp_ping.h"
 #include "ping/ping_sock.h"
 #include "wifi_onboarding/wifi_onboarding.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "task_placement.h"
 #include <string.h>
 
 static const char *TAG = "wifi_watchdog";
@@ -16,27 +18,39 @@ static const char *TAG = "wifi_watchdog";
 #define PING_TARGET_IP               "8.8.8.8"  // Google DNS
 #define PING_TIMEOUT_MS              5000
 
+#define WATCHDOG_TASK_STACK_SIZE     4096
+
 static bool s_connectivity_ok = false;
 static uint32_t s_no_connectivity_time_ms = 0;
 
+// Task and ping session live for the whole uptime: stack and TCB are static
+// and the ping session (with its own task) is created once and restarted on
+// every check instead of being allocated every 30 seconds
+static StackType_t s_task_stack[WATCHDOG_TASK_STACK_SIZE];
+static StaticTask_t s_task_tcb;
+static esp_ping_handle_t s_ping = NULL;
+
+// Metrics (see metrics.h)
+static metric_t s_metric_checks = METRIC_COUNTER_INIT("wifi.checks");
+static metric_t s_metric_ping_ok = METRIC_COUNTER_INIT("wifi.ping_ok");
+static metric_t s_metric_ping_fail = METRIC_COUNTER_INIT("wifi.ping_fail");
+static metric_t s_metric_offline = METRIC_GAUGE_INIT("wifi.offline_s");
+
 // Ping callback
 static void on_ping_success(esp_ping_handle_t hdl, void *args)
 {
     s_connectivity_ok = true;
+    metric_inc(&s_metric_ping_ok);
     ESP_LOGI(TAG, "Internet connectivity verified (ping successful)");
 }
 
 static void on_ping_timeout(esp_ping_handle_t hdl, void *args)
 {
     s_connectivity_ok = false;
+    metric_inc(&s_metric_ping_fail);
     ESP_LOGW(TAG, "Ping timeout - no internet connectivity");
 }
 
-static void on_ping_end(esp_ping_handle_t hdl, void *args)
-{
-    esp_ping_delete_session(hdl);
-}
-
 // Check internet connectivity by pinging Google DNS
 static bool check_internet_connectivity(void)
 {
@@ -49,34 +63,35 @@ static bool check_internet_connectivity(void)
         return false;
     }
 
-    // Configure ping
-    esp_ping_config_t ping_config = ESP_PING_DEFAULT_CONFIG();
-    ping_config.target_addr.u_addr.ip4.addr = ipaddr_addr(PING_TARGET_IP);
-    ping_config.target_addr.type = IPADDR_TYPE_V4;
-    ping_config.count = 1;  // Single ping
-    ping_config.interval_ms = 1000;
-    ping_config.timeout_ms = PING_TIMEOUT_MS;
-
-    // Set callbacks
-    esp_ping_callbacks_t cbs = {
-        .on_ping_success = on_ping_success,
-        .on_ping_timeout = on_ping_timeout,
-        .on_ping_end = on_ping_end,
-        .cb_args = NULL
-    };
-
-    esp_ping_handle_t ping;
-    esp_err_t err = esp_ping_new_session(&ping_config, &cbs, &ping);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to create ping session: %s", esp_err_to_name(err));
-        return false;
+    // Create the ping session on first use
+    if (s_ping == NULL) {
+        esp_ping_config_t ping_config = ESP_PING_DEFAULT_CONFIG();
+        ping_config.target_addr.u_addr.ip4.addr = ipaddr_addr(PING_TARGET_IP);
+        ping_config.target_addr.type = IPADDR_TYPE_V4;
+        ping_config.count = 1;  // Single ping per start
+        ping_config.interval_ms = 1000;
+        ping_config.timeout_ms = PING_TIMEOUT_MS;
+
+        // Set callbacks
+        esp_ping_callbacks_t cbs = {
+            .on_ping_success = on_ping_success,
+            .on_ping_timeout = on_ping_timeout,
+            .on_ping_end = NULL,
+            .cb_args = NULL
+        };
+
+        esp_err_t err = esp_ping_new_session(&ping_config, &cbs, &s_ping);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create ping session: %s", esp_err_to_name(err));
+            s_ping = NULL;
+            return false;
+        }
     }
 
     // Start ping
-    err = esp_ping_start(ping);
+    esp_err_t err = esp_ping_start(s_ping);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to start ping: %s", esp_err_to_name(err));
-        esp_ping_delete_session(ping);
         return false;
     }
 
@@ -111,6 +126,7 @@ static void wifi_watchdog_task(void *param)
 
     while (1) {
         check_count++;
+        metric_inc(&s_metric_checks);
 
         // Check WiFi connection status first
         bool wifi_connected = wifi_onboarding_is_connected();
@@ -130,11 +146,13 @@ static void wifi_watchdog_task(void *param)
                 ESP_LOGI(TAG, "Internet connectivity restored!");
             }
             s_no_connectivity_time_ms = 0;
+            metric_set(&s_metric_offline, 0);
         } else {
             // Increment no-connectivity time (either WiFi disconnected OR no internet)
             s_no_connectivity_time_ms += WATCHDOG_CHECK_INTERVAL_MS;
 
             uint32_t seconds_without_connectivity = s_no_connectivity_time_ms / 1000;
+            metric_set(&s_metric_offline, seconds_without_connectivity);
 
             if (wifi_connected) {
                 ESP_LOGW(TAG, "WiFi connected but no internet for %lu seconds (timeout at %d seconds)",
@@ -186,6 +204,11 @@ static void wifi_watchdog_task(void *param)
 // Start the WiFi connectivity watchdog
 void start_wifi_connectivity_watchdog(void)
 {
-    xTaskCreate(wifi_watchdog_task, "wifi_watchdog", 4096, NULL, 3, NULL);
+    metrics_register(&s_metric_checks);
+    metrics_register(&s_metric_ping_ok);
+    metrics_register(&s_metric_ping_fail);
+    metrics_register(&s_metric_offline);
+    xTaskCreateStaticPinnedToCore(wifi_watchdog_task, "wifi_watchdog", WATCHDOG_TASK_STACK_SIZE, NULL, 3,
+                                  s_task_stack, &s_task_tcb, TASK_CORE_SERVICES);
     ESP_LOGI(TAG, "WiFi connectivity watchdog task created");
 }
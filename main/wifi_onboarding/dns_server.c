@@ -4,6 +4,7 @@
 #include "lwip/inet.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "task_placement.h"
 #include <string.h>
 
 static const char *TAG = "dns_server";
@@ -160,7 +161,8 @@ esp_err_t dns_server_start(void)
 
     dns_running = true;
 
-    BaseType_t ret = xTaskCreate(dns_server_task, "dns_server", 4096, NULL, 5, &dns_task_handle);
+    BaseType_t ret = xTaskCreatePinnedToCore(dns_server_task, "dns_server", 4096, NULL, 5, &dns_task_handle,
+                                             TASK_CORE_SERVICES);
     if (ret != pdPASS) {
         ESP_LOGE(TAG, "Failed to create DNS server task");
         dns_running = false;
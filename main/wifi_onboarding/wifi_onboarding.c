@@ -13,6 +13,7 @@
 #include "esp_ot_wifi_cmd.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "task_placement.h"
 #include <string.h>
 
 static const char *TAG = "wifi_onboarding";
@@ -29,10 +30,16 @@ static const char *TAG = "wifi_onboarding";
 #define AP_MAX_CONNECTIONS 4
 #define AP_CHANNEL 6
 
+// Portal scan results. The portal only runs during onboarding, so its buffers
+// and tasks come from the heap and stay out of the steady-state .bss.
+#define SCAN_MAX_NETWORKS 20
+#define SCAN_JSON_SIZE 4096
+
 // Static variables
 static httpd_handle_t server = NULL;
 static bool provisioning_done = false;
 static bool s_wifi_connected = false;  // Track WiFi STA connection status
+static TaskHandle_t s_restart_task = NULL;
 
 // Forward declarations
 static esp_err_t root_handler(httpd_req_t *req);
@@ -211,9 +218,9 @@ static esp_err_t scan_handler(httpd_req_t *req)
         return ESP_OK;
     }
 
-    // Limit to 20 networks to avoid buffer overflow
-    if (ap_count > 20) {
-        ap_count = 20;
+    // Limit to SCAN_MAX_NETWORKS networks to avoid buffer overflow
+    if (ap_count > SCAN_MAX_NETWORKS) {
+        ap_count = SCAN_MAX_NETWORKS;
     }
 
     wifi_ap_record_t *ap_records = malloc(sizeof(wifi_ap_record_t) * ap_count);
@@ -224,8 +231,8 @@ static esp_err_t scan_handler(httpd_req_t *req)
 
     esp_wifi_scan_get_ap_records(&ap_count, ap_records);
 
-    // Build JSON response
-    char *json = malloc(4096);  // Allocate buffer for JSON
+    // Build JSON response (20 entries of at most ~80 bytes fit in SCAN_JSON_SIZE)
+    char *json = malloc(SCAN_JSON_SIZE);
     if (json == NULL) {
         free(ap_records);
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Memory allocation failed");
@@ -331,8 +338,10 @@ static esp_err_t provision_handler(httpd_req_t *req)
 
     ESP_LOGI(TAG, "Provisioning successful, will restart in 3 seconds...");
 
-    // Create task to restart ESP32 after delay
-    xTaskCreate(restart_task, "restart", 2048, NULL, 5, NULL);
+    // Create task to restart ESP32 after delay (once, even if the credentials arrive twice)
+    if (s_restart_task == NULL) {
+        xTaskCreatePinnedToCore(restart_task, "restart", 2048, NULL, 5, &s_restart_task, TASK_CORE_SERVICES);
+    }
 
     return ESP_OK;
 }